@@ -21,7 +21,10 @@ MEMORY
    FLASH_BANK0_SEC_32_39   : origin = 0x088000, length = 0x2000  /* on-chip Flash */
    FLASH_BANK0_SEC_40_47   : origin = 0x08A000, length = 0x2000  /* on-chip Flash */
    FLASH_BANK0_SEC_48_55   : origin = 0x08C000, length = 0x2000  /* on-chip Flash */
+   /* Sectors 62 and 63 hold the saved parameters (params.h) */
    FLASH_BANK0_SEC_56_63   : origin = 0x08E000, length = 0x2000  /* on-chip Flash */
+   /* Sectors 64..127 hold the persistent log (flash_log.h): keep code and
+      constants out of them */
    FLASH_BANK0_SEC_64_71   : origin = 0x090000, length = 0x2000  /* on-chip Flash */
    FLASH_BANK0_SEC_72_79   : origin = 0x092000, length = 0x2000  /* on-chip Flash */
    FLASH_BANK0_SEC_80_87   : origin = 0x094000, length = 0x2000  /* on-chip Flash */
@@ -34,18 +37,32 @@ MEMORY
    // FLASH_BANK0_SEC_127_RSVD : origin = 0x0A0FF0, length = 0x0010  /* Reserve and do not use for code as per the errata advisory "Memory: Prefetching Beyond Valid Memory" */
 }
 
+/* Application section budgets: see memory_plan.h */
+
 SECTIONS
 {
    codestart        : > BEGIN
 
    .text            : >> FLASH_BANK0_SEC_8_15 | FLASH_BANK0_SEC_16_23 | FLASH_BANK0_SEC_24_31, ALIGN(8)
 
+   /* HotIsr (ADC ISRs and per-sample kernels) is loaded in flash and copied
+      to RAM at boot together with .TI.ramfunc. Link with
+      --define=HOTISR_IN_FLASH to run it from flash for benchmarking (stalls
+      the ISRs while flash_log.c programs the log). The Flash API must run
+      from RAM as well. */
+#if defined(HOTISR_IN_FLASH)
+   HotIsr           : > FLASH_BANK0_SEC_8_15, ALIGN(8)
+#endif
+
    .cinit           : > FLASH_BANK0_SEC_0_7, ALIGN(8)
    .switch          : > FLASH_BANK0_SEC_0_7, ALIGN(8)
 
    .reset           : > RESET,  TYPE = DSECT /* not used, */
 
    .stack           : > RAMM1
+   TelemetryRing    : > RAMM1                  /* Rings drained by the background loop */
+   NoInit           : > RAMM1, TYPE = NOINIT   /* Kept across warm resets */
+   SampleStore      : > RAMLS1                 /* Packed channel buffers, flight recorder */
 
 #if defined(__TI_EABI__)
    .bss             : > RAMLS0
@@ -64,7 +81,14 @@ SECTIONS
 #endif
 
 #if defined(__TI_EABI__)
-   .TI.ramfunc      : LOAD = FLASH_BANK0_SEC_0_7,
+   .TI.ramfunc      : {
+                         *(.TI.ramfunc)
+                         --library=FAPI_F280013x_EABI_v1.58.10.lib (.text)
+#if !defined(HOTISR_IN_FLASH)
+                         *(HotIsr)
+#endif
+                      }
+                      LOAD = FLASH_BANK0_SEC_0_7,
                       RUN = RAMLS0,
                       LOAD_START(RamfuncsLoadStart),
                       LOAD_SIZE(RamfuncsLoadSize),
@@ -74,7 +98,14 @@ SECTIONS
                       RUN_END(RamfuncsRunEnd),
                       ALIGN(8)
 #else
-   .TI.ramfunc      : LOAD = FLASH_BANK0_SEC_0_7,
+   .TI.ramfunc      : {
+                         *(.TI.ramfunc)
+                         --library=FAPI_F280013x_EABI_v1.58.10.lib (.text)
+#if !defined(HOTISR_IN_FLASH)
+                         *(HotIsr)
+#endif
+                      }
+                      LOAD = FLASH_BANK0_SEC_0_7,
                       RUN = RAMLS0,
                       LOAD_START(_RamfuncsLoadStart),
                       LOAD_SIZE(_RamfuncsLoadSize),
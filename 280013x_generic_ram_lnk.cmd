@@ -35,16 +35,22 @@ MEMORY
 }
 
 
+/* Application section budgets: see memory_plan.h */
+
 SECTIONS
 {
    codestart        : > BEGIN
    .TI.ramfunc      : > RAMM0
+   HotIsr           : >> RAMM0 | RAMLS0        /* ADC ISRs and per-sample kernels */
+   SampleStore      : > RAMLS1                 /* Packed channel buffers, flight recorder */
    .text            : >> RAMLS0 | RAMLS1
    .cinit           : > RAMM0
    .switch          : > RAMM0
    .reset           : > RESET,                  TYPE = DSECT /* not used, */
 
    .stack           : > RAMM1
+   TelemetryRing    : > RAMM1                  /* Rings drained by the background loop */
+   NoInit           : > RAMM1, TYPE = NOINIT   /* Kept across warm resets */
 
 #if defined(__TI_EABI__)
    .bss             : > RAMLS0
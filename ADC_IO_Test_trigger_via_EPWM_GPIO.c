@@ -34,12 +34,37 @@
 //!  - A11 should be connected to the signal to be converted by ePWM4 (IN_CP_BORNE).
 //!
 //! \b Watch \b Variables \n
-//!  - \b array_IN_ADC_500VAC - Buffer storing ADC conversion samples from channel A3.
-//!  - \b array_IN_CP_ADC - Buffer storing ADC conversion samples from channel A2.
-//!  - \b array_IN_CP_BORNE - Buffer storing ADC conversion samples from channel A11.
+//!  - \b store_IN_ADC_500VAC - Packed sample store for channel A3 (backed by array_IN_ADC_500VAC).
+//!  - \b store_IN_CP_ADC - Packed sample store for channel A2 (backed by array_IN_CP_ADC).
+//!  - \b store_IN_CP_BORNE - Packed sample store for channel A11 (backed by array_IN_CP_BORNE).
 //!  - \b array_IN_ADC_500VAC_bufferFull - Flag indicating when the buffer for channel A3 is full.
 //!  - \b array_IN_CP_ADC_bufferFull - Flag indicating when the buffer for channel A2 is full.
 //!  - \b array_IN_CP_BORNE_ADC_bufferFull - Flag indicating when the buffer for channel A11 is full.
+//!  - \b fr_slots - Pre/post-trigger captures taken by the flight recorder (CP level changes, CP out of band, mains sags, overflows); read out and released with TLM_OP_FR_READ (see flight_recorder.h, telemetry.h).
+//!  - \b bench_isr - Cycle statistics of the ADC ISRs.
+//!  - \b mv_latest - Newest sample of each channel in millivolts (see adc_cal.h).
+//!  - \b bench_kernelDelta - Cycles lost by a per-sample kernel run from flash.
+//!  - \b temp_cableQ4 - Filtered cable temperature, Q4 degC (see temp_monitor.h).
+//!  - \b temp_rating - Current advertised on PP after thermal derating.
+//!  - \b irq_stat - Preemption counts and trigger latency of the ISRs (see irq_nest.h).
+//!  - \b sup_persist - Reset cause and watchdog trips, kept across resets (see supervisor.h).
+//!  - \b boot_stamp - Boot phase timestamps, boot_firstDecisionUs the time to the first CP decision.
+//!  - \b flog_sector, \b flog_slot - Write position of the persistent log (see flash_log.h).
+//!  - \b mains_rmsDv, \b mains_freqCHz - Mains RMS voltage and frequency (see mains_meas.h).
+//!  - \b tlm_selfTest, \b tlm_txFrames - CAN telemetry self-test result and traffic (see telemetry.h).
+//!  - \b param_value - Active parameters, by register number (see params.h).
+//!  - \b cp_meas - CP period and duty from the ADC and from eCAP1, \b cp_meas_mismatches their disagreements (see cp_meas.h).
+//!  - \b pll_freqCHz, \b pll_ampDv, \b pll_locked - SOGI-PLL on the mains; bench_isr[BENCH_PLL] its cycles per sample (see sogi_pll.h).
+//!  - \b acq_chan - Lost conversions per channel and the stamps of the last complete block (see acq_gap.h).
+//!  - \b cp_hist - CP plateau levels and duty from the per-period histogram (see cp_hist.h).
+//!  - \b env - Min/max of IN_CP_ADC and IN_CP_BORNE over the last PARAM_ENV_WINDOW samples; env_benchDeque and env_benchNaive the cycles per sample against a rescan (see envelope.h).
+//!  - \b bq_benchStat - Cycles per sample per section of the biquad banks, \b bq_benchMismatch tables that differ from the host model (see biquad.h). The start-up benchmarks (this, env_bench*, bench_kernel*) run in BOOT_BENCH=1 builds only (see boot.h).
+//!  - \b dec, \b dec_rateHz - Decimated 1 kS/s stream of each channel and its rate; it goes out in the TLM_ID_LEVELS frame (see decim.h, telemetry.h).
+//!  - \b cpc - Cable-side (IN_CP_ADC) against station-side (IN_CP_BORNE) CP plateaus, amplitude ratio, edge delay and wiring faults (see cp_cable.h).
+//!  - \b stats_snap - Mean, noise (standard deviation), min and max of each channel over its statistics window (see stats.h and stats_windows[]).
+//!  - \b adc_bist - ADC self-test on VREFLO, VREFHI/2 and the temperature sensor in the idle part of the sample period: codes, drift and faults (see adc_bist.h).
+//!  - \b acq_tune - ACQ_TUNE=1 builds: ACQPS sweep state, error and noise per step, the chosen window and the sample rate it allows (see acq_tune.h).
+//!  - \b tb_high, \b cp_levelAt - 64-bit time base on CPU Timer 1 and the time of the last CP level change (see timebase.h).
 //!
 //! The main loop waits for all buffers to be filled before resetting the buffer full flags
 //! and continuing the sampling process. This ensures synchronized data acquisition from
@@ -87,23 +112,95 @@
 #include "f28x_project.h"
 #include "ADC_IO_testing.h"
 #include "Test_GPIO.h"
+#include "flight_recorder.h"
+#include "sample_store.h"
+#include "memory_plan.h"
+#include "bench.h"
+#include "adc_cal.h"
+#include "temp_monitor.h"
+#include "irq_nest.h"
+#include "supervisor.h"
+#include "boot.h"
+#include "gpio_pin.h"
+#include "flash_log.h"
+#include "mains_meas.h"
+#include "telemetry.h"
+#include "params.h"
+#include "cp_meas.h"
+#include "cp_ecap.h"
+#include "sogi_pll.h"
+#include "acq_gap.h"
+#include "timebase.h"
+#include "envelope.h"
+#include "biquad.h"
+#include "decim.h"
+#include "cp_cable.h"
+#include "stats.h"
+#include "adc_bist.h"
+#include "acq_tune.h"
 
 //
 // Defines
 //
-#define RESULTS_BUFFER_SIZE  2000
-#define PERIODE_10u 625
-#define CMPA_      312
+#define RESULTS_BUFFER_SIZE  PLAN_STORE_SAMPLES_PER_CHANNEL  // Capacity, multiple of 4
+
+//
+// Flight recorder sag reference (ADC counts). The trigger levels are
+// parameters (params.h).
+//
+#define MAINS_MID            2048   // Mid-scale bias of the 500 VAC divider
+
+//
+// Nominal mains: the tumbling statistics window of the 500 VAC channel is
+// one cycle at the current sample period (init_stats())
+//
+#define STATS_MAINS_HZ       50UL
+
+//
+// Parameters that reprogram the acquisition when they change
+//
+#define PARAM_MASK_ACQ       ((1UL << PARAM_SAMPLE_PERIOD) | (1UL << PARAM_SOC_CMPA) | \
+                              (1UL << PARAM_ACQPS) | (1UL << PARAM_ADC_PRESCALE) | \
+                              (1UL << PARAM_BUFFER_SAMPLES))
+#define PARAM_MASK_FR        ((1UL << PARAM_CP_BAND_LOW) | (1UL << PARAM_CP_BAND_HIGH) | \
+                              (1UL << PARAM_SAG_THRESHOLD))
+#define PARAM_MASK_ENV       (1UL << PARAM_ENV_WINDOW)
+
+//
+// Period of the summary record in the persistent log
+//
+#define LOG_SUMMARY_MS       60000UL
+
+//
+// CP level outputs on port A, cleared together
+//
+#define PINS_CP_PORT_A       (GPIO_MASK(PIN_CP_9V) | GPIO_MASK(PIN_CP_6V))
+
+//
+// Pin groups updated with one store must share a port
+//
+GPIO_PORT_CHECK(cp_levels, PIN_CP_9V, PIN_CP_6V);
+GPIO_PORT_CHECK(cp_enable, PIN_CP_ENABLE, PIN_CP_9V);
+GPIO_PORT_CHECK(pp_680r, PIN_PP_220R, PIN_PP_680R);
+GPIO_PORT_CHECK(pp_1500r, PIN_PP_220R, PIN_PP_1500R);
 
 //
 // Globals
 //
-uint16_t array_IN_ADC_500VAC[RESULTS_BUFFER_SIZE];
-uint16_t array_IN_CP_ADC[RESULTS_BUFFER_SIZE];
-uint16_t array_IN_CP_BORNE[RESULTS_BUFFER_SIZE];
-uint16_t index_1;                              // Index into result buffer
-uint16_t index_2;                              // Index into result buffer
-uint16_t index_3;                              // Index into result buffer
+//
+// 12-bit samples are packed 4 per 3 words. The buffers live in the
+// SampleStore section and are sized by memory_plan.h.
+//
+#pragma DATA_SECTION(array_IN_ADC_500VAC, "SampleStore");
+#pragma DATA_SECTION(array_IN_CP_ADC, "SampleStore");
+#pragma DATA_SECTION(array_IN_CP_BORNE, "SampleStore");
+uint16_t array_IN_ADC_500VAC[SAMPLE_STORE_WORDS(RESULTS_BUFFER_SIZE)];
+uint16_t array_IN_CP_ADC[SAMPLE_STORE_WORDS(RESULTS_BUFFER_SIZE)];
+uint16_t array_IN_CP_BORNE[SAMPLE_STORE_WORDS(RESULTS_BUFFER_SIZE)];
+SampleStore store_IN_ADC_500VAC;
+SampleStore store_IN_CP_ADC;
+SampleStore store_IN_CP_BORNE;
+int32_t mv_latest[NUM_CHANNELS];               // Newest samples in mV
 
 
 // Flags to indicate buffer is full
@@ -111,6 +208,55 @@ volatile uint16_t array_IN_ADC_500VAC_bufferFull = 0;
 volatile uint16_t array_IN_CP_ADC_bufferFull = 0;
 volatile uint16_t array_IN_CP_BORNE_ADC_bufferFull = 0;
 
+uint16_t cp_level = CP_LEVEL_SAFE;
+uint64_t cp_levelAt;                            // tb_now() of the last change
+
+//
+// SOC position and period of ePWM1/2/4, for the ISR latency statistics
+//
+uint16_t acq_socAt;
+uint16_t acq_period;
+
+static uint32_t log_frLogged;                   // Last capture in the log
+static uint32_t log_summaryMs;
+static uint16_t log_cpcEvents;                  // cpc.faultEvents logged
+static uint16_t log_bistEvents;                 // adc_bist.faultEvents logged
+static uint32_t param_cpPeriods;                // cp_hist.updates at the last commit
+
+//
+// Statistics window of each channel (stats.h): mode, then the window in
+// samples or the EWMA shift. 0 samples: one mains cycle (init_stats())
+//
+static const uint16_t stats_windows[NUM_CHANNELS][2] =
+{
+    { STATS_TUMBLING, 0U },                     // 20 ms, one mains cycle
+    { STATS_EWMA, 10U },                        // ~10 ms time constant
+    { STATS_EWMA, 10U }
+};
+
+//
+// Sample store of each channel, for acq_tune_poll()
+//
+static const SampleStore *const acq_stores[NUM_CHANNELS] =
+{
+    &store_IN_ADC_500VAC, &store_IN_CP_ADC, &store_IN_CP_BORNE
+};
+
+//
+// Function Prototypes
+//
+static void cp_level_set(uint16_t level);
+static void log_poll(void);
+static void apply_params(uint32_t changed);
+static void set_fr_levels(void);
+static void init_stats(void);
+
+//
+// The ADC ISRs run for every sample: keep them in the HotIsr section
+//
+#pragma CODE_SECTION(adcA1ISR, "HotIsr");
+#pragma CODE_SECTION(adcA2ISR, "HotIsr");
+#pragma CODE_SECTION(adcA3ISR, "HotIsr");
 
 //
 // Main
@@ -122,6 +268,50 @@ void main(void)
     //
     InitSysCtrl();
 
+    //
+    // Record why the device reset
+    //
+    sup_init();
+
+    //
+    // Start the cycle counter, the reference of the boot phase stamps
+    //
+    bench_init();
+    boot_begin();
+
+    //
+    // 64-bit time base for the sample, CP and log stamps
+    //
+    tb_init();
+
+    //
+    // Start the slow analog power-ups first: the ADC core and the
+    // temperature sensor settle while the log and the parameters are
+    // loaded from flash and the rest of the system is set up. PRESCALE
+    // follows once the parameters are known.
+    //
+    initADC_A();
+    temp_monitor_powerup();
+    boot_mark(BOOT_PH_ANALOG_START);
+
+    //
+    // Open the persistent log and record the reset, and the supervisor
+    // trip that caused it
+    //
+    flog_init(sup_persist.bootCount);
+    flog_append(FLOG_EV_BOOT, sup_resetCause, sup_persist.bootCount,
+                sup_lockupReset, sup_persist.wdResets);
+    if(sup_tripReset)
+    {
+        flog_append(FLOG_EV_SUP_TRIP, sup_persist.lastFailedTasks,
+                    sup_persist.lastHangToSafeMs, sup_persist.trips, 0);
+    }
+
+    //
+    // Parameters: defaults, or the copy saved in flash
+    //
+    params_init();
+
     //
     // Initialize GPIO
     //
@@ -133,6 +323,7 @@ void main(void)
     // COnfigure GPIo
     Configure_GPIO();
     select_CP_9V();
+    boot_mark(BOOT_PH_GPIO);
 
 
     //
@@ -167,29 +358,116 @@ void main(void)
     PieVectTable.ADCA2_INT = &adcA2ISR;     // Function for ADCA interrupt 2
     PieVectTable.ADCA3_INT = &adcA3ISR;     // Function for ADCA interrupt 3
     EDIS;
+    boot_mark(BOOT_PH_PIE);
 
     //
-    // Configure the ADC and power it up
+    // Seed the count to millivolt conversion (needs the OTP trim loaded)
     //
-    initADC_A();
+    adc_cal_init();
+    mains_meas_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    cp_meas_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    cpc_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    sogi_pll_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    acq_gap_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    dec_init((uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    tlm_dec_init();
 
     //
     // Setup the ADC for ePWM triggered conversions on channel 1
     //
+    EALLOW;
+    AdcaRegs.ADCCTL2.bit.PRESCALE = (uint16_t)param_value[PARAM_ADC_PRESCALE];
+    EDIS;
 
     // Init the ADC channels
     init_IN_ADC_500VAC();
     init_IN_CP_ADC();
     init_IN_CP_Borne_ADC();
 
+    //
+    // Low-rate temperature conversions and thermal derating
+    //
+    temp_monitor_init();
+
     //
     // Configure the ePWM
     //
+    acq_socAt = (uint16_t)param_value[PARAM_SOC_CMPA];
+    acq_period = (uint16_t)param_value[PARAM_SAMPLE_PERIOD];
     init_EPWM1();
     init_EPWM2();
     init_EPWM4();
 
+    //
+    // ADC self-test in the idle part of the sample period
+    //
+    adc_bist_init(acq_period + 1U, acq_socAt,
+                  (uint16_t)param_value[PARAM_ACQPS],
+                  (uint16_t)param_value[PARAM_ADC_PRESCALE]);
+
+    //
+    // Initialize results buffer
+    //
+    sample_store_init(&store_IN_ADC_500VAC, array_IN_ADC_500VAC,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+    sample_store_init(&store_IN_CP_ADC, array_IN_CP_ADC,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+    sample_store_init(&store_IN_CP_BORNE, array_IN_CP_BORNE,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+
+    array_IN_ADC_500VAC_bufferFull = 0;
+    array_IN_CP_ADC_bufferFull = 0;
+    array_IN_CP_BORNE_ADC_bufferFull = 0;
+
+    //
+    // Initialize the flight recorder and arm its triggers
+    //
+    fr_init();
+    set_fr_levels();
+
+    //
+    // Min/max envelopes of the CP channels
+    //
+    env_init(&env[ENV_CP_ADC], (uint16_t)param_value[PARAM_ENV_WINDOW]);
+    env_init(&env[ENV_CP_BORNE], (uint16_t)param_value[PARAM_ENV_WINDOW]);
+
+    //
+    // Running statistics of every channel
+    //
+    init_stats();
+
+    //
+    // CAN telemetry, with its loopback self-test
+    //
+    tlm_init();
+
+    //
+    // CP period and duty by eCAP1, independent of the ADC
+    //
+    cp_ecap_init();
+
+    //
+    // Interrupt nesting statistics
+    //
+    irq_nest_init();
+    boot_mark(BOOT_PH_PERIPH);
+
+#if BOOT_BENCH
+    //
+    // Time the flash/RAM kernel copies, in what is left of the power-up
+    // time: CP is already driven, only the first decision moves
+    //
+    bench_run_kernels();
+    env_bench();
+    bq_bench();
+    boot_mark(BOOT_PH_BENCH);
+#endif
 
+    //
+    // Wait for whatever is left of the analog power-up time
+    //
+    boot_wait_since(BOOT_PH_ANALOG_START, BOOT_ADC_POWERUP_US);
+    boot_mark(BOOT_PH_ANALOG_READY);
 
     //
     // Enable global Interrupts and higher priority real-time debug events:
@@ -201,23 +479,6 @@ void main(void)
     EINT;           // Enable Global interrupt INTM
     ERTM;           // Enable Global realtime interrupt DBGM
 
-    //
-    // Initialize results buffer
-    //
-    for(index_1 = 0; index_1 < RESULTS_BUFFER_SIZE; index_1++)
-    {
-        array_IN_ADC_500VAC[index_1] = 0;
-        array_IN_CP_ADC[index_1] = 0;
-        array_IN_CP_BORNE[index_1] = 0;
-    }
-
-    index_1 = 0;
-    index_2 = 0;
-    index_3 = 0;
-
-    array_IN_ADC_500VAC_bufferFull = 0;
-    array_IN_CP_ADC_bufferFull = 0;
-    array_IN_CP_BORNE_ADC_bufferFull = 0;
     //
     // Enable PIE interrupt individually
     //
@@ -236,6 +497,21 @@ void main(void)
     start_EPWM1();
     start_EPWM2();
     start_EPWM4();
+    temp_monitor_start();
+    irq_load_start();
+    tlm_start();
+    cp_ecap_start();
+    tb_start();
+
+    //
+    // Supervise acquisition, the main loop and telemetry, then enable the
+    // watchdog
+    //
+    sup_register(SUP_TASK_ACQ, SUP_DEADLINE_ACQ_MS);
+    sup_register(SUP_TASK_CP, SUP_DEADLINE_CP_MS);
+    sup_register(SUP_TASK_TELEMETRY, SUP_DEADLINE_TELEMETRY_MS);
+    sup_start();
+    boot_mark(BOOT_PH_RUN);
 
 
 
@@ -255,12 +531,67 @@ void main(void)
         // flag
         //
         while((!array_IN_ADC_500VAC_bufferFull) && (!array_IN_CP_ADC_bufferFull) && (!array_IN_CP_BORNE_ADC_bufferFull) )
-        {}
+        {
+            temp_monitor_poll();
+            sup_poll();
+            mains_meas_poll();
+            cp_ecap_poll();
+            cp_meas_poll();
+
+            //
+            // Safe point: a CP period ended (classified by cp_meas_poll(),
+            // cp_hist.h), apply the parameters written since the last one
+            //
+            if(cp_hist.updates != param_cpPeriods)
+            {
+                apply_params(params_commit());
+                param_cpPeriods = cp_hist.updates;  // Reset by apply_params()
+            }
+
+            cpc_poll();
+            stats_poll();
+            adc_bist_poll();
+            sogi_pll_poll();
+            tlm_poll();
+            log_poll();
+
+            //
+            // First CP decision: the first CP period classified into its
+            // plateau levels by cp_meas_poll() (cp_hist.h), not after a
+            // whole buffer
+            //
+            if((0 == boot_done) && (0UL != cp_hist.updates))
+            {
+                mv_latest[CH_IN_CP_ADC] = adc_cal_to_mv(&adc_cal[CH_IN_CP_ADC],
+                                            sample_store_read(&store_IN_CP_ADC, 0));
+                boot_mark(BOOT_PH_FIRST_DECISION);
+            }
+        }
 
         array_IN_ADC_500VAC_bufferFull= 0; //clear the buffer full flag
         array_IN_CP_ADC_bufferFull= 0; //clear the buffer full flag
         array_IN_CP_BORNE_ADC_bufferFull= 0; //clear the buffer full flag
 
+        mv_latest[CH_IN_ADC_500VAC] = adc_cal_to_mv(&adc_cal[CH_IN_ADC_500VAC],
+                                        sample_store_read(&store_IN_ADC_500VAC, 0));
+        mv_latest[CH_IN_CP_ADC] = adc_cal_to_mv(&adc_cal[CH_IN_CP_ADC],
+                                        sample_store_read(&store_IN_CP_ADC, 0));
+        mv_latest[CH_IN_CP_BORNE] = adc_cal_to_mv(&adc_cal[CH_IN_CP_BORNE],
+                                        sample_store_read(&store_IN_CP_BORNE, 0));
+
+        //
+        // The bench modes step once per buffer set, and only after their
+        // last write was applied at a CP period boundary
+        //
+        if(0UL == param_pendingMask)
+        {
+            acq_sweep_poll();
+            acq_tune_poll(acq_stores);
+        }
+
+        sup_checkin(SUP_TASK_CP);
+        sup_poll();
+
 
         // Software breakpoint. At this point, conversion results are stored in
         // adcAResults.
@@ -286,9 +617,9 @@ void initADC_A(void)
     EALLOW;
 
     //
-    // Set ADCCLK divider to /4
+    // ADCCLK divider: the default /4 until main() sets PARAM_ADC_PRESCALE
     //
-    AdcaRegs.ADCCTL2.bit.PRESCALE = 6;
+    AdcaRegs.ADCCTL2.bit.PRESCALE = (uint16_t)param_defs[PARAM_ADC_PRESCALE].def;
 
     //
     // Set pulse positions to late
@@ -296,12 +627,11 @@ void initADC_A(void)
     AdcaRegs.ADCCTL1.bit.INTPULSEPOS = 1;
 
     //
-    // Power up the ADC and then delay for 1 ms
+    // Power up the ADC. The caller waits BOOT_ADC_POWERUP_US before the
+    // first conversion (see boot.h)
     //
     AdcaRegs.ADCCTL1.bit.ADCPWDNZ = 1;
     EDIS;
-
-    DELAY_US(1000);
 }
 
 //
@@ -315,8 +645,8 @@ void init_EPWM1(void)
     EPwm1Regs.ETSEL.bit.SOCASEL = 4;    // Select SOC on up-count
     EPwm1Regs.ETPS.bit.SOCAPRD = 1;     // Generate pulse on 1st event
 
-    EPwm1Regs.CMPA.bit.CMPA = CMPA_;   // Set compare A value to 2048 counts
-    EPwm1Regs.TBPRD = PERIODE_10u;           // Set period to 4096 counts
+    EPwm1Regs.CMPA.bit.CMPA = acq_socAt;  // SOC position
+    EPwm1Regs.TBPRD = acq_period;         // Sample period
 
     EPwm1Regs.TBCTL.bit.CTRMODE = 3;    // Freeze counter
 
@@ -336,8 +666,8 @@ void init_EPWM2(void)
     EPwm2Regs.ETSEL.bit.SOCASEL = 4;    // Select SOC on up-count
     EPwm2Regs.ETPS.bit.SOCAPRD = 1;     // Generate pulse on 1st event
 
-    EPwm2Regs.CMPA.bit.CMPA = CMPA_;   // Set compare A value to 2048 counts
-    EPwm2Regs.TBPRD = PERIODE_10u;           // Set period to 4096 counts
+    EPwm2Regs.CMPA.bit.CMPA = acq_socAt;  // SOC position
+    EPwm2Regs.TBPRD = acq_period;         // Sample period
 
     EPwm2Regs.TBCTL.bit.CTRMODE = 3;    // Freeze counter
 
@@ -356,8 +686,8 @@ void init_EPWM4(void)
     EPwm4Regs.ETSEL.bit.SOCASEL = 4;    // Select SOC on up-count
     EPwm4Regs.ETPS.bit.SOCAPRD = 1;     // Generate pulse on 1st event
 
-    EPwm4Regs.CMPA.bit.CMPA = CMPA_;   // Set compare A value to 2048 counts
-    EPwm4Regs.TBPRD = PERIODE_10u;           // Set period to 4096 counts
+    EPwm4Regs.CMPA.bit.CMPA = acq_socAt;  // SOC position
+    EPwm4Regs.TBPRD = acq_period;         // Sample period
 
     EPwm4Regs.TBCTL.bit.CTRMODE = 3;    // Freeze counter
 
@@ -436,7 +766,7 @@ void init_IN_ADC_500VAC(void)
     EALLOW;
 
     AdcaRegs.ADCSOC0CTL.bit.CHSEL = 3;     // SOC0 will convert pin A3
-    AdcaRegs.ADCSOC0CTL.bit.ACQPS = 9;     // Sample window is 10 SYSCLK cycles
+    AdcaRegs.ADCSOC0CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS]; // Sample window, SYSCLK cycles - 1
     AdcaRegs.ADCSOC0CTL.bit.TRIGSEL = 5;   // Trigger on ePWM1 SOCA
 
     AdcaRegs.ADCINTSEL1N2.bit.INT1SEL = 0; // End of SOC0 will set INT1 flag
@@ -457,7 +787,7 @@ void init_IN_CP_ADC(void)
     EALLOW;
 
     AdcaRegs.ADCSOC1CTL.bit.CHSEL = 2;     // SOC0 will convert pin A2
-    AdcaRegs.ADCSOC1CTL.bit.ACQPS = 9;     // Sample window is 10 SYSCLK cycles
+    AdcaRegs.ADCSOC1CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS]; // Sample window, SYSCLK cycles - 1
     AdcaRegs.ADCSOC1CTL.bit.TRIGSEL = 7;   // Trigger on ePWM2 SOCA
 
     AdcaRegs.ADCINTSEL1N2.bit.INT2SEL = 1; // End of SOC1 will set INT2 flag
@@ -483,7 +813,7 @@ void init_IN_CP_Borne_ADC(void)
                                            // 8:A8   9:A9   A:A10  B:A11
                                            // C:A12  D:A13  E:A14  F:A15
 
-    AdcaRegs.ADCSOC2CTL.bit.ACQPS = 9;     // Sample window is 10 SYSCLK cycles
+    AdcaRegs.ADCSOC2CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS]; // Sample window, SYSCLK cycles - 1
     AdcaRegs.ADCSOC2CTL.bit.TRIGSEL = 11;   // Trigger on ePWM4 SOCA
 
     AdcaRegs.ADCINTSEL3N4.bit.INT3SEL = 2; // End of SOC2 will set INT3 flag
@@ -501,14 +831,47 @@ __interrupt void adcA1ISR(void)
     //
     // Add the latest result to the buffer
     // ADCRESULT0 is the result register of SOC0
-    array_IN_ADC_500VAC[index_1++] = AdcaResultRegs.ADCRESULT0;
+    uint32_t t0 = BENCH_NOW();
+    uint32_t now = tb_now32();
+    uint32_t t1;
+    uint16_t sample = AdcaResultRegs.ADCRESULT0;
+    uint16_t latency, missed;
+    IrqNestFrame frame;
+
+    //
+    // Acknowledge the group and let the protection level preempt
+    //
+    latency = irq_latency_record(IRQ_ID_ADCA1, EPwm1Regs.TBCTR, acq_socAt,
+                                 acq_period);
+    irq_nest_enter(&frame, IRQ_ID_ADCA1, IRQ_IER_ACQ,
+                   &PieCtrlRegs.PIEIER1.all, IRQ_PIE_KEEP, PIEACK_GROUP1);
+
+    //
+    // Tell the cycle-based consumers about lost conversions
+    //
+    missed = acq_sample(CH_IN_ADC_500VAC, acq_stamp(now, latency),
+                        store_IN_ADC_500VAC.head);
+    if(missed)
+    {
+        mains_meas_gap();
+        sogi_pll_gap(missed);
+    }
+
+    fr_push(FR_CH_IN_ADC_500VAC, sample);
+    dec_push(&dec[CH_IN_ADC_500VAC], sample);
+    stats_push(&stats[CH_IN_ADC_500VAC], sample);
+    mains_meas_push(sample);
+
+    t1 = BENCH_NOW();
+    sogi_pll_push(sample);
+    bench_record(&bench_isr[BENCH_PLL], t1);
 
     //
     // Set the bufferFull flag if the buffer is full
     //
-    if(RESULTS_BUFFER_SIZE <= index_1)
+    if(sample_store_append(&store_IN_ADC_500VAC, sample))
     {
-        index_1 = 0;
+        acq_block_end(CH_IN_ADC_500VAC);
         array_IN_ADC_500VAC_bufferFull = 1;
         //stop_EPWM1();
     }
@@ -525,13 +888,12 @@ __interrupt void adcA1ISR(void)
     {
         AdcaRegs.ADCINTOVFCLR.bit.ADCINT1 = 1; //clear INT1 overflow flag
         AdcaRegs.ADCINTFLGCLR.bit.ADCINT1 = 1; //clear INT1 flag
+        fr_trigger(FR_CH_IN_ADC_500VAC, FR_CAUSE_OVERFLOW);
     }
 
-    //
-    // Acknowledge the interrupt
-    //
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP1;
+    bench_record(&bench_isr[BENCH_ADCA1], t0);
 
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER1.all);
 }
 
 //
@@ -542,12 +904,36 @@ __interrupt void adcA2ISR(void)
     //
     // Add the latest result to the buffer
     // ADCRESULT0 is the result register of SOC0
-    array_IN_CP_ADC[index_2++] = AdcaResultRegs.ADCRESULT1;
+    uint32_t t0 = BENCH_NOW();
+    uint32_t now = tb_now32();
+    uint16_t sample = AdcaResultRegs.ADCRESULT1;
+    uint16_t latency;
+    IrqNestFrame frame;
+
+    //
+    // Acknowledge the group and let the protection level preempt
+    //
+    latency = irq_latency_record(IRQ_ID_ADCA2, EPwm2Regs.TBCTR, acq_socAt,
+                                 acq_period);
+    irq_nest_enter(&frame, IRQ_ID_ADCA2, IRQ_IER_ACQ,
+                   &PieCtrlRegs.PIEIER10.all, IRQ_PIE_KEEP, PIEACK_GROUP10);
+
+    if(acq_sample(CH_IN_CP_ADC, acq_stamp(now, latency), store_IN_CP_ADC.head))
+    {
+        cp_adc_gap();
+    }
+
+    fr_push(FR_CH_IN_CP_ADC, sample);
+    dec_push(&dec[CH_IN_CP_ADC], sample);
+    stats_push(&stats[CH_IN_CP_ADC], sample);
+    cp_adc_push(sample);
+    env_push(&env[ENV_CP_ADC], sample);
+    sup_checkin(SUP_TASK_ACQ);
 
     //
     // Set the bufferFull flag if the buffer is full
     //
-    if(RESULTS_BUFFER_SIZE <= index_2)
+    if(sample_store_append(&store_IN_CP_ADC, sample))
 
         // Enter function here
         // Stop EPWM
@@ -555,7 +941,7 @@ __interrupt void adcA2ISR(void)
         // Start the EPWM
 
     {
-        index_2 = 0;
+        acq_block_end(CH_IN_CP_ADC);
         array_IN_CP_ADC_bufferFull = 1;
     }
 
@@ -571,13 +957,12 @@ __interrupt void adcA2ISR(void)
     {
         AdcaRegs.ADCINTOVFCLR.bit.ADCINT2 = 1; //clear INT3 overflow flag
         AdcaRegs.ADCINTFLGCLR.bit.ADCINT2 = 1; //clear INT3 flag
+        fr_trigger(FR_CH_IN_CP_ADC, FR_CAUSE_OVERFLOW);
     }
 
-    //
-    // Acknowledge the interrupt
-    //
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP10;
+    bench_record(&bench_isr[BENCH_ADCA2], t0);
 
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER10.all);
 }
 
 //
@@ -588,14 +973,38 @@ __interrupt void adcA3ISR(void)
     //
     // Add the latest result to the buffer
     // ADCRESULT0 is the result register of SOC0
-    array_IN_CP_BORNE[index_3++] = AdcaResultRegs.ADCRESULT2;
+    uint32_t t0 = BENCH_NOW();
+    uint32_t now = tb_now32();
+    uint16_t sample = AdcaResultRegs.ADCRESULT2;
+    uint16_t latency;
+    IrqNestFrame frame;
+
+    //
+    // Acknowledge the group and let the protection level preempt
+    //
+    latency = irq_latency_record(IRQ_ID_ADCA3, EPwm4Regs.TBCTR, acq_socAt,
+                                 acq_period);
+    irq_nest_enter(&frame, IRQ_ID_ADCA3, IRQ_IER_ACQ,
+                   &PieCtrlRegs.PIEIER10.all, IRQ_PIE_KEEP, PIEACK_GROUP10);
+
+    if(acq_sample(CH_IN_CP_BORNE, acq_stamp(now, latency),
+                  store_IN_CP_BORNE.head))
+    {
+        cpc_gap();
+    }
+
+    fr_push(FR_CH_IN_CP_BORNE, sample);
+    dec_push(&dec[CH_IN_CP_BORNE], sample);
+    stats_push(&stats[CH_IN_CP_BORNE], sample);
+    cpc_push(AdcaResultRegs.ADCRESULT1, sample);    // Same period as SOC2
+    env_push(&env[ENV_CP_BORNE], sample);
 
     //
     // Set the bufferFull flag if the buffer is full
     //
-    if(RESULTS_BUFFER_SIZE <= index_3)
+    if(sample_store_append(&store_IN_CP_BORNE, sample))
     {
-        index_3 = 0;
+        acq_block_end(CH_IN_CP_BORNE);
         array_IN_CP_BORNE_ADC_bufferFull = 1;
     }
 
@@ -611,13 +1020,12 @@ __interrupt void adcA3ISR(void)
     {
         AdcaRegs.ADCINTOVFCLR.bit.ADCINT3 = 1; //clear INT3 overflow flag
         AdcaRegs.ADCINTFLGCLR.bit.ADCINT3 = 1; //clear INT3 flag
+        fr_trigger(FR_CH_IN_CP_BORNE, FR_CAUSE_OVERFLOW);
     }
 
-    //
-    // Acknowledge the interrupt
-    //
-    PieCtrlRegs.PIEACK.all = PIEACK_GROUP10;
+    bench_record(&bench_isr[BENCH_ADCA3], t0);
 
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER10.all);
 }
 
 //
@@ -649,64 +1057,309 @@ void GPIO224_mux_IN_CP_ADC(void){
 
 void Configure_GPIO(void){
     // Slection des niveaux de tensions CP
-    GPIO_SetupPinMux(24U, GPIO_MUX_CPU1, 0); // OUT_CP_9V
-    GPIO_SetupPinOptions(24U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_CP_9V, GPIO_MUX_CPU1, 0); // OUT_CP_9V
+    GPIO_SetupPinOptions(PIN_CP_9V, GPIO_OUTPUT, GPIO_PUSHPULL);
 
-    GPIO_SetupPinMux(16U, GPIO_MUX_CPU1, 0); // OUT_CP_6V
-    GPIO_SetupPinOptions(16U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_CP_6V, GPIO_MUX_CPU1, 0); // OUT_CP_6V
+    GPIO_SetupPinOptions(PIN_CP_6V, GPIO_OUTPUT, GPIO_PUSHPULL);
 
-    GPIO_SetupPinMux(33U, GPIO_MUX_CPU1, 0); // OUT_CP_3V3
-    GPIO_SetupPinOptions(33U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_CP_3V3, GPIO_MUX_CPU1, 0); // OUT_CP_3V3
+    GPIO_SetupPinOptions(PIN_CP_3V3, GPIO_OUTPUT, GPIO_PUSHPULL);
 
     // Slection des niveau de rsistances
 
-    GPIO_SetupPinMux(7U, GPIO_MUX_CPU1, 0); // OUT_PP_680R
-    GPIO_SetupPinOptions(7U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_PP_680R, GPIO_MUX_CPU1, 0); // OUT_PP_680R
+    GPIO_SetupPinOptions(PIN_PP_680R, GPIO_OUTPUT, GPIO_PUSHPULL);
 
-    GPIO_SetupPinMux(0U, GPIO_MUX_CPU1, 0); // OUT_PP_220R
-    GPIO_SetupPinOptions(0U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_PP_220R, GPIO_MUX_CPU1, 0); // OUT_PP_220R
+    GPIO_SetupPinOptions(PIN_PP_220R, GPIO_OUTPUT, GPIO_PUSHPULL);
 
-    GPIO_SetupPinMux(1U, GPIO_MUX_CPU1, 0); // OUT_PP_1500R
-    GPIO_SetupPinOptions(1U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_PP_1500R, GPIO_MUX_CPU1, 0); // OUT_PP_1500R
+    GPIO_SetupPinOptions(PIN_PP_1500R, GPIO_OUTPUT, GPIO_PUSHPULL);
 
     // CP enabled for 12 V level adaptator and CP modified
 
-    GPIO_SetupPinMux(03U, GPIO_MUX_CPU1, 0); // CP enabled
-    GPIO_SetupPinOptions(03U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_CP_ENABLE, GPIO_MUX_CPU1, 0); // CP enabled
+    GPIO_SetupPinOptions(PIN_CP_ENABLE, GPIO_OUTPUT, GPIO_PUSHPULL);
 
-    GPIO_SetupPinMux(04U, GPIO_MUX_CPU1, 0); // CP_modifie
-    GPIO_SetupPinOptions(04U, GPIO_OUTPUT, GPIO_PUSHPULL);
+    GPIO_SetupPinMux(PIN_CP_MODIFIE, GPIO_MUX_CPU1, 0); // CP_modifie
+    GPIO_SetupPinOptions(PIN_CP_MODIFIE, GPIO_OUTPUT, GPIO_PUSHPULL);
 }
 
+//
+// The level selects clear the other outputs before setting the new one
+// (break before make). Each GPIO_* access is a single store to the SET or
+// CLEAR register of the port (see gpio_pin.h).
+//
 void select_CP_9V(void){
 
-    GpioDataRegs.GPADAT.bit.GPIO16 = 0; // CP_6V
-    GpioDataRegs.GPBDAT.bit.GPIO33 = 0; // CP_3V3
+    GPIO_CLEAR(PIN_CP_6V);
+    GPIO_CLEAR(PIN_CP_3V3);
 
-    //while(GpioDataRegs.GPADAT.bit.GPIO16 == 0 && GpioDataRegs.GPBDAT.bit.GPIO33 == 0 )
-    GpioDataRegs.GPADAT.bit.GPIO24 = 1;
+    GPIO_SET(PIN_CP_9V);
+    cp_level_set(CP_LEVEL_9V);
 
 
 }
 
 void select_CP_6V(void){
 
-    GpioDataRegs.GPADAT.bit.GPIO24 = 0; // CP_9V
-    GpioDataRegs.GPBDAT.bit.GPIO33 = 0; // CP_3V3
+    GPIO_CLEAR(PIN_CP_9V);
+    GPIO_CLEAR(PIN_CP_3V3);
 
-    //while(GpioDataRegs.GPADAT.bit.GPIO24 == 0 && GpioDataRegs.GPBDAT.bit.GPIO33 == 0 )
-    GpioDataRegs.GPADAT.bit.GPIO16 = 1;
+    GPIO_SET(PIN_CP_6V);
+    cp_level_set(CP_LEVEL_6V);
 
 
 }
 
 void select_CP_3V3(void){
 
-    GpioDataRegs.GPADAT.bit.GPIO16 = 0; // CP_6V
-    GpioDataRegs.GPADAT.bit.GPIO24 = 0; // CP_9V
+    GPIO_CLEAR_GROUP(GPIO_PORT(PIN_CP_6V), PINS_CP_PORT_A);
+
+    GPIO_SET(PIN_CP_3V3);
+    cp_level_set(CP_LEVEL_3V3);
+
+
+}
+
+void select_PP_220R(void){
+
+    GPIO_CLEAR_GROUP(GPIO_PORT(PIN_PP_220R),
+                     GPIO_MASK(PIN_PP_680R) | GPIO_MASK(PIN_PP_1500R));
+
+    GPIO_SET(PIN_PP_220R);
+
+
+}
+
+void select_PP_680R(void){
+
+    GPIO_CLEAR_GROUP(GPIO_PORT(PIN_PP_680R),
+                     GPIO_MASK(PIN_PP_220R) | GPIO_MASK(PIN_PP_1500R));
+
+    GPIO_SET(PIN_PP_680R);
+
+
+}
+
+void select_PP_1500R(void){
+
+    GPIO_CLEAR_GROUP(GPIO_PORT(PIN_PP_1500R),
+                     GPIO_MASK(PIN_PP_220R) | GPIO_MASK(PIN_PP_680R));
+
+    GPIO_SET(PIN_PP_1500R);
+
+
+}
+
+void select_CP_safe(void){
+
+    GPIO_CLEAR_GROUP(GPIO_PORT(PIN_CP_ENABLE),
+                     GPIO_MASK(PIN_CP_ENABLE) | PINS_CP_PORT_A);
+    GPIO_CLEAR(PIN_CP_3V3);
+    cp_level_set(CP_LEVEL_SAFE);
+
+
+}
+
+//
+// cp_level_set - Track the CP output level, stamp and log every change
+//
+static void cp_level_set(uint16_t level)
+{
+    uint16_t intState;
+
+    if(level != cp_level)
+    {
+        cp_levelAt = tb_now();
+        flog_append(FLOG_EV_CP_STATE, cp_level, level, 0, 0);
+        cp_level = level;
+
+        //
+        // Capture the CP around the change. fr_trigger() is written for
+        // the ADC ISRs; mask them so it cannot race one on the channel.
+        //
+        intState = __disable_interrupts();
+        fr_trigger(FR_CH_IN_CP_ADC, FR_CAUSE_CP_STATE);
+        __restore_interrupts(intState);
+    }
+}
+
+//
+// log_poll - Background part of the persistent log: queue new flight
+// recorder captures (mains sags, CP out of band) oldest first, ADC gaps,
+// CP wiring and ADC self-test faults, a periodic summary, then let
+// flog_poll() write one record to flash.
+//
+static void log_poll(void)
+{
+    FR_Slot *next = 0;
+    AcqGap gap;
+    uint16_t i;
+
+    for(i = 0; i < FR_NUM_SLOTS; i++)
+    {
+        if((FR_SLOT_READY == fr_slots[i].state) &&
+           (fr_slots[i].sequence > log_frLogged) &&
+           ((0 == next) || (fr_slots[i].sequence < next->sequence)))
+        {
+            next = &fr_slots[i];
+        }
+    }
+    if(0 != next)
+    {
+        flog_append(FLOG_EV_FR_CAPTURE, next->channel, next->cause,
+                    (uint16_t)next->sequence, 0);
+        log_frLogged = next->sequence;
+    }
+
+    if(acq_gap_next(&gap))
+    {
+        flog_append(FLOG_EV_ADC_GAP, gap.channel, gap.missed, gap.position,
+                    gap.block);
+    }
+
+    if(cpc.faultEvents != log_cpcEvents)
+    {
+        log_cpcEvents = cpc.faultEvents;
+        flog_append(FLOG_EV_CP_WIRING, cpc.faults, (uint16_t)cpc.diffHighMv,
+                    (uint16_t)cpc.diffLowMv, (uint16_t)cpc.ratioPm);
+    }
+
+    if(adc_bist.faultEvents != log_bistEvents)
+    {
+        log_bistEvents = adc_bist.faultEvents;
+        flog_append(FLOG_EV_ADC_BIST, adc_bist.faults, adc_bist.lo,
+                    adc_bist.mid, (uint16_t)adc_bist.driftLoQ4);
+    }
+
+    if((flog_time_ms() - log_summaryMs) >= LOG_SUMMARY_MS)
+    {
+        log_summaryMs += LOG_SUMMARY_MS;
+        flog_append(FLOG_EV_SUMMARY, (uint16_t)temp_maxQ4, temp_rating,
+                    (uint16_t)fr_triggerCount, (uint16_t)fr_droppedTriggers);
+    }
+
+    flog_poll();
+}
+
+//
+// set_fr_levels - Flight recorder trigger levels and sag window from the
+// parameters
+//
+static void set_fr_levels(void)
+{
+    uint16_t low = (uint16_t)param_value[PARAM_CP_BAND_LOW];
+    uint16_t high = (uint16_t)param_value[PARAM_CP_BAND_HIGH];
+
+    fr_set_sag(FR_CH_IN_ADC_500VAC, MAINS_MID,
+               (uint16_t)param_value[PARAM_SAG_THRESHOLD],
+               (uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U);
+    fr_set_band(FR_CH_IN_CP_ADC, low, high);
+    fr_set_band(FR_CH_IN_CP_BORNE, low, high);
+}
+
+//
+// init_stats - Restart the statistics of all channels with their windows.
+// A window of 0 samples becomes one STATS_MAINS_HZ cycle at
+// PARAM_SAMPLE_PERIOD, rounded to the nearest sample.
+//
+static void init_stats(void)
+{
+    uint16_t ch;
+    uint16_t length;
+    uint32_t ticks = (uint32_t)param_value[PARAM_SAMPLE_PERIOD] + 1UL;
+    uint32_t cycle = (ACQ_TBCLK_HZ + ticks * (STATS_MAINS_HZ / 2UL)) /
+                     (ticks * STATS_MAINS_HZ);
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        length = stats_windows[ch][1];
+        if(0U == length)
+        {
+            length = (cycle > STATS_MAX_WINDOW) ? STATS_MAX_WINDOW :
+                                                  (uint16_t)cycle;
+        }
+        stats_init(&stats[ch], stats_windows[ch][0], length);
+    }
+}
+
+//
+// apply_params - Reprogram what depends on the committed parameters.
+// Called at the end of a CP period; acquisition settings are changed
+// with the ePWMs frozen and the buffer set restarted, so no buffer mixes
+// two sample rates.
+//
+static void apply_params(uint32_t changed)
+{
+    uint16_t intState;
+
+    if(changed & (PARAM_MASK_FR | PARAM_MASK_ACQ))
+    {
+        intState = __disable_interrupts();
+        set_fr_levels();
+        __restore_interrupts(intState);
+    }
 
-    //while(!GpioDataRegs.GPADAT.bit.GPIO24 == 0 && !GpioDataRegs.GPADAT.bit.GPIO16 == 0 )
-    GpioDataRegs.GPBDAT.bit.GPIO33 = 1;
+    if(changed & (PARAM_MASK_ENV | PARAM_MASK_ACQ))
+    {
+        intState = __disable_interrupts();
+        env_init(&env[ENV_CP_ADC], (uint16_t)param_value[PARAM_ENV_WINDOW]);
+        env_init(&env[ENV_CP_BORNE], (uint16_t)param_value[PARAM_ENV_WINDOW]);
+        __restore_interrupts(intState);
+    }
 
+    if(0UL == (changed & PARAM_MASK_ACQ))
+    {
+        return;
+    }
 
+    intState = __disable_interrupts();
+    stop_EPWM1();
+    stop_EPWM2();
+    stop_EPWM4();
+
+    acq_socAt = (uint16_t)param_value[PARAM_SOC_CMPA];
+    acq_period = (uint16_t)param_value[PARAM_SAMPLE_PERIOD];
+    init_EPWM1();
+    init_EPWM2();
+    init_EPWM4();
+
+    EALLOW;
+    AdcaRegs.ADCCTL2.bit.PRESCALE = (uint16_t)param_value[PARAM_ADC_PRESCALE];
+    AdcaRegs.ADCSOC0CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS];
+    AdcaRegs.ADCSOC1CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS];
+    AdcaRegs.ADCSOC2CTL.bit.ACQPS = (uint16_t)param_value[PARAM_ACQPS];
+    EPwm1Regs.TBCTR = 0;
+    EPwm2Regs.TBCTR = 0;
+    EPwm4Regs.TBCTR = 0;
+    EDIS;
+    adc_bist_init(acq_period + 1U, acq_socAt,
+                  (uint16_t)param_value[PARAM_ACQPS],
+                  (uint16_t)param_value[PARAM_ADC_PRESCALE]);
+
+    sample_store_init(&store_IN_ADC_500VAC, array_IN_ADC_500VAC,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+    sample_store_init(&store_IN_CP_ADC, array_IN_CP_ADC,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+    sample_store_init(&store_IN_CP_BORNE, array_IN_CP_BORNE,
+                      (uint16_t)param_value[PARAM_BUFFER_SAMPLES]);
+    array_IN_ADC_500VAC_bufferFull = 0;
+    array_IN_CP_ADC_bufferFull = 0;
+    array_IN_CP_BORNE_ADC_bufferFull = 0;
+
+    mains_meas_init(acq_period + 1U);
+    cp_meas_init(acq_period + 1U);
+    cpc_init(acq_period + 1U);
+    init_stats();
+    sogi_pll_init(acq_period + 1U);
+    acq_gap_init(acq_period + 1U);
+    dec_init(acq_period + 1U);
+    tlm_dec_init();
+
+    start_EPWM1();
+    start_EPWM2();
+    start_EPWM4();
+    __restore_interrupts(intState);
 }
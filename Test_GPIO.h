@@ -18,14 +18,42 @@
 #ifndef _GPIO_h
 #define _GPIO_h
 
+//
+// Pin map
+//
+#define PIN_CP_9V       24U     // OUT_CP_9V    - port A
+#define PIN_CP_6V       16U     // OUT_CP_6V    - port A
+#define PIN_CP_3V3      33U     // OUT_CP_3V3   - port B
+#define PIN_PP_220R     0U      // OUT_PP_220R  - port A
+#define PIN_PP_680R     7U      // OUT_PP_680R  - port A
+#define PIN_PP_1500R    1U      // OUT_PP_1500R - port A
+#define PIN_CP_ENABLE   3U      // 12 V level adapter enable - port A
+#define PIN_CP_MODIFIE  4U      // CP_modifie   - port A
+
 void Configure_GPIO(void);
 
 void select_CP_9V(void);
 
 void select_CP_6V(void);
 void select_CP_3V3(void);
+void select_CP_safe(void);     // Level adapter and CP levels off
+
+//
+// CP output level last selected, each change is logged (flash_log.h) and
+// stamped with the time base in cp_levelAt (timebase.h)
+//
+#define CP_LEVEL_SAFE   0U
+#define CP_LEVEL_9V     1U
+#define CP_LEVEL_6V     2U
+#define CP_LEVEL_3V3    3U
+
+extern uint16_t cp_level;
+extern uint64_t cp_levelAt;
 
 
 // Select resistance
+void select_PP_220R(void);     // 32 A
+void select_PP_680R(void);     // 20 A
+void select_PP_1500R(void);    // 13 A
 
 #endif
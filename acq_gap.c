@@ -0,0 +1,180 @@
+//#############################################################################
+//
+// FILE: acq_gap.c
+//
+// TITLE: Lost-sample accounting and block/gap timestamps of the ADC
+//        channels
+//
+// DESCRIPTION:
+// Channel records, the gap queue drained by the background and the
+// ACQ_OVF_SWEEP load test.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "acq_gap.h"
+#include "memory_plan.h"
+#include "params.h"
+
+//
+// Globals
+//
+AcqChan acq_chan[NUM_CHANNELS];
+uint32_t acq_periodCycles;
+uint16_t acq_periodShift;
+
+#pragma DATA_SECTION(acq_gaps, "TelemetryRing");
+AcqGap acq_gaps[ACQ_GAP_RING];
+volatile uint16_t acq_gapHead;
+uint16_t acq_gapTail;
+uint16_t acq_gapDropped;
+
+uint16_t acq_sweepState;
+uint16_t acq_sweepOnsetTicks;
+uint32_t acq_sweepOnsetHz;
+
+PLAN_CHECK(acq_gap_ring, (ACQ_GAP_RING & (ACQ_GAP_RING - 1U)) == 0U);
+
+#if ACQ_OVF_SWEEP
+static uint16_t acq_sweepClean;             // Clean sets at this period
+static uint32_t acq_sweepMissed;            // Total at the last step
+static int32_t acq_sweepDefault;            // Period before the sweep
+static int32_t acq_sweepDefaultCmpa;        // SOC position before the sweep
+
+//
+// Function Prototypes
+//
+static uint32_t acq_total_missed(void);
+#endif
+
+//
+// acq_gap_init - Restart the accounting for a sample period in TBCLK
+// ticks. Call with the ADC ISRs stopped. The totals and the sweep are
+// kept.
+//
+void acq_gap_init(uint16_t samplePeriodTicks)
+{
+    uint16_t i;
+
+    acq_periodCycles = (uint32_t)samplePeriodTicks * SYSCLK_PER_TBCLK;
+    acq_periodShift = 0;
+    while(0UL == ((acq_periodCycles << acq_periodShift) & 0x80000000UL))
+    {
+        acq_periodShift++;
+    }
+
+    for(i = 0; i < NUM_CHANNELS; i++)
+    {
+        acq_chan[i].synced = 0;
+        acq_chan[i].cur.start = 0;
+        acq_chan[i].cur.end = 0;
+        acq_chan[i].cur.missed = 0;
+        acq_chan[i].cur.gaps = 0;
+    }
+}
+
+//
+// acq_gap_next - Take the oldest queued gap. Returns 0 if there is none.
+//
+uint16_t acq_gap_next(AcqGap *gap)
+{
+    if(acq_gapTail == acq_gapHead)
+    {
+        return 0;
+    }
+
+    *gap = acq_gaps[acq_gapTail];
+    acq_gapTail = (acq_gapTail + 1U) & (ACQ_GAP_RING - 1U);
+
+    return 1;
+}
+
+//
+// acq_sweep_poll - ACQ_OVF_SWEEP load test step. Call once per buffer
+// set, while no write waits for params_commit().
+//
+void acq_sweep_poll(void)
+{
+#if ACQ_OVF_SWEEP
+    int32_t period = param_value[PARAM_SAMPLE_PERIOD];
+    int32_t next;
+    uint32_t missed = acq_total_missed();
+
+    if(ACQ_SWEEP_DONE == acq_sweepState)
+    {
+        return;
+    }
+
+    if(ACQ_SWEEP_IDLE == acq_sweepState)
+    {
+        acq_sweepDefault = period;
+        acq_sweepDefaultCmpa = param_value[PARAM_SOC_CMPA];
+        acq_sweepMissed = missed;
+        acq_sweepClean = 0;
+        acq_sweepState = ACQ_SWEEP_RUNNING;
+        return;
+    }
+
+    if(missed != acq_sweepMissed)
+    {
+        //
+        // First loss: record the onset and go back to the period the
+        // sweep started from
+        //
+        acq_sweepOnsetTicks = (uint16_t)period;
+        acq_sweepOnsetHz = ACQ_TBCLK_HZ / ((uint32_t)period + 1UL);
+        acq_sweepState = ACQ_SWEEP_DONE;
+        params_write(PARAM_SOC_CMPA, acq_sweepDefaultCmpa);
+        params_write(PARAM_SAMPLE_PERIOD, acq_sweepDefault);
+        return;
+    }
+
+    if(++acq_sweepClean < ACQ_SWEEP_SETS)
+    {
+        return;
+    }
+    acq_sweepClean = 0;
+
+    next = period - (period / ACQ_SWEEP_DIV) - 1L;
+    if(next < param_defs[PARAM_SAMPLE_PERIOD].min)
+    {
+        acq_sweepOnsetTicks = 0;            // No loss down to the minimum
+        acq_sweepOnsetHz = 0;
+        acq_sweepState = ACQ_SWEEP_DONE;
+        params_write(PARAM_SOC_CMPA, acq_sweepDefaultCmpa);
+        params_write(PARAM_SAMPLE_PERIOD, acq_sweepDefault);
+        return;
+    }
+
+    //
+    // SOC in the middle of the new period, to pass the commit rule
+    //
+    params_write(PARAM_SOC_CMPA, next / 2L);
+    params_write(PARAM_SAMPLE_PERIOD, next);
+#endif
+}
+
+#if ACQ_OVF_SWEEP
+//
+// acq_total_missed - Conversions lost on all channels
+//
+static uint32_t acq_total_missed(void)
+{
+    uint32_t total = 0;
+    uint16_t i;
+
+    for(i = 0; i < NUM_CHANNELS; i++)
+    {
+        total += acq_chan[i].missed;
+    }
+
+    return total;
+}
+#endif
+
+//
+// End of File
+//
@@ -0,0 +1,211 @@
+//#############################################################################
+//
+// FILE: acq_gap.h
+//
+// TITLE: Lost-sample accounting and block/gap timestamps of the ADC
+//        channels
+//
+// DESCRIPTION:
+// Every sample is stamped with the time of its SOC, in cycles of the time
+// base (timebase.h): tb_now32() at ISR entry minus the trigger latency
+// measured on the ePWM counter (irq_latency_record()). Two
+// consecutive stamps more than 1.5 sample periods apart mean conversions
+// were lost, whether the ADC flagged an overflow or the ISR was held off
+// long enough to merge interrupts; acq_sample() returns how many, and the
+// ISR then tells the consumers of the channel:
+//
+//     IN_ADC_500VAC   mains_meas_gap(), sogi_pll_gap()
+//     IN_CP_ADC       cp_adc_gap()
+//
+// Each gap is queued (channel, lost conversions, SOC stamp, position in
+// the sample store) for the background; the per-channel totals are in
+// acq_chan[]. Every block (one fill of a sample store) carries the full
+// 64-bit stamps of its first and last sample (tb_extend()) and the
+// conversions lost inside it, so a
+// consumer of a buffer set can see whether it is contiguous:
+// acq_chan[ch].done is the last complete block.
+//
+// Building with ACQ_OVF_SWEEP=1 adds a load test: starting from the
+// sample period parameter, acq_sweep_poll() shortens the period by
+// 1/ACQ_SWEEP_DIV every ACQ_SWEEP_SETS clean buffer sets until
+// conversions are lost, and leaves the onset in acq_sweepOnsetTicks and
+// acq_sweepOnsetHz. Combine with IRQ_LOAD_TEST=1 for the onset under
+// communication load.
+//
+//#############################################################################
+
+#ifndef _acq_gap_h
+#define _acq_gap_h
+
+#include <stdint.h>
+#include "channels.h"
+#include "timebase.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define ACQ_GAP_RING            8U          // Gaps waiting for the background
+#define ACQ_TBCLK_HZ            TBCLK_HZ    // ePWM1/2/4 time base
+
+#ifndef ACQ_OVF_SWEEP
+#define ACQ_OVF_SWEEP           0
+#endif
+#define ACQ_SWEEP_SETS          4U          // Clean buffer sets per step
+#define ACQ_SWEEP_DIV           32U         // Step: period / 32
+
+#define ACQ_SWEEP_IDLE          0U
+#define ACQ_SWEEP_RUNNING       1U
+#define ACQ_SWEEP_DONE          2U
+
+typedef struct
+{
+    uint64_t start;         // SOC time of the first sample
+    uint64_t end;           // SOC time of the last sample
+    uint32_t seq;           // Block number
+    uint16_t missed;        // Conversions lost inside the block
+    uint16_t gaps;
+} AcqBlock;
+
+typedef struct
+{
+    uint32_t last;          // SOC stamp of the previous sample
+    uint32_t missed;        // Conversions lost since acq_gap_init()
+    uint16_t gaps;
+    uint16_t synced;        // last is valid
+    AcqBlock cur;           // Block being filled
+    AcqBlock done;          // Last complete block
+} AcqChan;
+
+typedef struct
+{
+    uint64_t stamp;         // SOC time of the first sample after the gap
+    uint16_t channel;
+    uint16_t missed;
+    uint16_t position;      // Sample store position of that sample
+    uint16_t block;         // Low word of the block number
+} AcqGap;
+
+//
+// Globals
+//
+extern AcqChan acq_chan[NUM_CHANNELS];
+extern uint32_t acq_periodCycles;           // Sample period, SYSCLK
+extern uint16_t acq_periodShift;            // Puts its top bit at bit 31
+extern AcqGap acq_gaps[ACQ_GAP_RING];
+extern volatile uint16_t acq_gapHead;
+extern uint16_t acq_gapTail;
+extern uint16_t acq_gapDropped;             // Ring full
+extern uint16_t acq_sweepState;             // ACQ_SWEEP_*
+extern uint16_t acq_sweepOnsetTicks;        // Period at the first loss
+extern uint32_t acq_sweepOnsetHz;
+
+//
+// Function Prototypes
+//
+void acq_gap_init(uint16_t samplePeriodTicks);
+uint16_t acq_gap_next(AcqGap *gap);
+void acq_sweep_poll(void);
+
+//
+// acq_stamp - SOC stamp of the sample read at ISR entry: now is
+// tb_now32() at entry, latency the TBCLK ticks since the SOC
+//
+#pragma FUNC_ALWAYS_INLINE(acq_stamp)
+static inline uint32_t acq_stamp(uint32_t now, uint16_t latency)
+{
+    return now - (uint32_t)latency * SYSCLK_PER_TBCLK;
+}
+
+//
+// acq_missed - Conversions lost in a stamp delta of more than 1.5
+// periods: round(delta / period) - 1, saturated to 0xFFFF. Shift and
+// subtract over the normalised period, at most 23 steps, so the ISR calls
+// no division routine from flash.
+//
+#pragma FUNC_ALWAYS_INLINE(acq_missed)
+static inline uint16_t acq_missed(uint32_t delta)
+{
+    uint32_t rem = delta + (acq_periodCycles >> 1);
+    uint32_t d = acq_periodCycles << acq_periodShift;
+    uint32_t q = 0;
+    uint16_t i;
+
+    for(i = 0; i <= acq_periodShift; i++)
+    {
+        q <<= 1;
+        if(rem >= d)
+        {
+            rem -= d;
+            q++;
+        }
+        d >>= 1;
+    }
+
+    return (q > 0x10000UL) ? 0xFFFFU : (uint16_t)(q - 1UL);
+}
+
+//
+// acq_sample - Account one sample of channel ch. position is the sample
+// store position it is written to. Returns the conversions lost before
+// it, 0 normally.
+//
+#pragma FUNC_ALWAYS_INLINE(acq_sample)
+static inline uint16_t acq_sample(uint16_t ch, uint32_t stamp,
+                                  uint16_t position)
+{
+    AcqChan *c = &acq_chan[ch];
+    uint32_t delta = stamp - c->last;
+    uint16_t missed = 0;
+    uint16_t next;
+
+    if(c->synced && (delta > acq_periodCycles + (acq_periodCycles >> 1)))
+    {
+        missed = acq_missed(delta);
+        c->missed += missed;
+        c->gaps++;
+        c->cur.missed += missed;
+        c->cur.gaps++;
+
+        next = (acq_gapHead + 1U) & (ACQ_GAP_RING - 1U);
+        if(next == acq_gapTail)
+        {
+            acq_gapDropped++;
+        }
+        else
+        {
+            acq_gaps[acq_gapHead].stamp = tb_extend(stamp);
+            acq_gaps[acq_gapHead].channel = ch;
+            acq_gaps[acq_gapHead].missed = missed;
+            acq_gaps[acq_gapHead].position = position;
+            acq_gaps[acq_gapHead].block = (uint16_t)c->cur.seq;
+            acq_gapHead = next;
+        }
+    }
+
+    if(0U == position)
+    {
+        c->cur.start = tb_extend(stamp);
+    }
+    c->last = stamp;
+    c->synced = 1;
+
+    return missed;
+}
+
+//
+// acq_block_end - The sample store of channel ch wrapped: close the block
+//
+#pragma FUNC_ALWAYS_INLINE(acq_block_end)
+static inline void acq_block_end(uint16_t ch)
+{
+    AcqChan *c = &acq_chan[ch];
+
+    c->cur.end = tb_extend(c->last);
+    c->done = c->cur;
+    c->cur.seq++;
+    c->cur.missed = 0;
+    c->cur.gaps = 0;
+}
+
+#endif
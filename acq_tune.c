@@ -0,0 +1,290 @@
+//#############################################################################
+//
+// FILE: acq_tune.c
+//
+// TITLE: Acquisition window (ACQPS) characterisation and tuning
+//
+// DESCRIPTION:
+// The ACQ_TUNE state machine. Each measurement pushes the sample stores
+// into a tumbling StatsBlock (stats.h) per channel.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "acq_tune.h"
+#include "acq_gap.h"
+#include "params.h"
+#include "adc_timing.h"
+#include "stats.h"
+
+//
+// Defines
+//
+#define ACQ_TUNE_ALL            ((1U << NUM_CHANNELS) - 1U)
+
+//
+// Globals
+//
+AcqTune acq_tune;
+
+#if ACQ_TUNE
+static uint16_t tune_skip;                  // Discard the next buffer set
+static uint16_t tune_pending;               // Channels still measuring, bits
+static StatsBlock tune_stats[NUM_CHANNELS]; // ACQ_TUNE_SETS sets per window
+static StatsSnap tune_snap[NUM_CHANNELS];
+
+//
+// Function Prototypes
+//
+static void tune_start(uint16_t acqps);
+static void tune_next(void);
+static void tune_done(void);
+static uint16_t tune_measure(const SampleStore *const stores[NUM_CHANNELS]);
+#endif
+
+//
+// acq_tune_poll - ACQ_TUNE step. Call once per buffer set, while no write
+// waits for params_commit(), with the sample stores of the channels.
+//
+void acq_tune_poll(const SampleStore *const stores[NUM_CHANNELS])
+{
+#if ACQ_TUNE
+    AcqTuneStep *step = 0;
+    int32_t mean, err;
+    uint16_t noise, ch, bit, unstable = 0;
+    uint16_t period = (uint16_t)param_value[PARAM_SAMPLE_PERIOD] + 1U;
+    uint16_t prescale = (uint16_t)param_value[PARAM_ADC_PRESCALE];
+
+    switch(acq_tune.state)
+    {
+        case ACQ_TUNE_IDLE:
+            acq_tune.startAcqps = (uint16_t)param_value[PARAM_ACQPS];
+            acq_tune.refAcqps = adc_max_acqps(period, prescale);
+            acq_tune.steps = 0;
+            if(acq_tune.refAcqps <= (uint16_t)param_defs[PARAM_ACQPS].min)
+            {
+                acq_tune.state = ACQ_TUNE_NO_ROOM;
+                return;
+            }
+            acq_tune.state = ACQ_TUNE_REFERENCE;
+            tune_start(acq_tune.refAcqps);
+            return;
+
+        case ACQ_TUNE_REFERENCE:
+        case ACQ_TUNE_SWEEP:
+        case ACQ_TUNE_CHECK:
+            if(!tune_measure(stores))
+            {
+                return;
+            }
+            break;
+
+        default:
+            return;                         // Done
+    }
+
+    if(acq_tune.steps < ACQ_TUNE_MAX_STEPS)
+    {
+        step = &acq_tune.curve[acq_tune.steps++];
+        step->acqps = acq_tune.acqps;
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        bit = 1U << ch;
+        mean = tune_snap[ch].meanQ4;
+        noise = tune_snap[ch].stdQ4;
+
+        if(ACQ_TUNE_REFERENCE == acq_tune.state)
+        {
+            acq_tune.refMeanQ4[ch] = mean;
+            acq_tune.refNoiseQ4[ch] = noise;
+            acq_tune.minAcqps[ch] = acq_tune.acqps;
+            if(noise > ACQ_TUNE_MAX_NOISE_Q4)
+            {
+                unstable = 1;
+            }
+        }
+
+        err = mean - acq_tune.refMeanQ4[ch];
+        if(0 != step)
+        {
+            step->errQ4[ch] = (int16_t)((err > 32767L) ? 32767L :
+                                        ((err < -32767L) ? -32767L : err));
+            step->noiseQ4[ch] = noise;
+        }
+
+        if(ACQ_TUNE_CHECK == acq_tune.state)
+        {
+            if((err > ACQ_TUNE_ERR_Q4) || (err < -ACQ_TUNE_ERR_Q4))
+            {
+                unstable = 1;
+            }
+        }
+        else if((ACQ_TUNE_SWEEP == acq_tune.state) && (acq_tune.active & bit))
+        {
+            if((err <= ACQ_TUNE_ERR_Q4) && (err >= -ACQ_TUNE_ERR_Q4) &&
+               (noise <= acq_tune.refNoiseQ4[ch] + ACQ_TUNE_NOISE_Q4))
+            {
+                acq_tune.minAcqps[ch] = acq_tune.acqps;
+            }
+            else
+            {
+                acq_tune.active &= ~bit;    // First failure ends the sweep
+            }
+        }
+    }
+
+    if(unstable)
+    {
+        //
+        // Input moved or too noisy: back to the window the run started
+        // from
+        //
+        acq_tune.acqps = acq_tune.startAcqps;
+        acq_tune.state = ACQ_TUNE_UNSTABLE;
+        params_write(PARAM_ACQPS, acq_tune.startAcqps);
+        return;
+    }
+
+    switch(acq_tune.state)
+    {
+        case ACQ_TUNE_REFERENCE:
+            acq_tune.active = ACQ_TUNE_ALL;
+            acq_tune.state = ACQ_TUNE_SWEEP;
+            tune_next();
+            break;
+
+        case ACQ_TUNE_SWEEP:
+            if((0U == acq_tune.active) ||
+               (acq_tune.acqps <= (uint16_t)param_defs[PARAM_ACQPS].min))
+            {
+                acq_tune.state = ACQ_TUNE_CHECK;
+                tune_start(acq_tune.refAcqps);
+            }
+            else
+            {
+                tune_next();
+            }
+            break;
+
+        default:
+            tune_done();                    // ACQ_TUNE_CHECK
+            break;
+    }
+#else
+    (void)stores;
+#endif
+}
+
+#if ACQ_TUNE
+//
+// tune_start - Request a window for the next buffer sets and clear the
+// measurement
+//
+static void tune_start(uint16_t acqps)
+{
+    acq_tune.acqps = acqps;
+    params_write(PARAM_ACQPS, acqps);
+
+    tune_skip = 1;
+}
+
+//
+// tune_next - Next, shorter window of the sweep
+//
+static void tune_next(void)
+{
+    uint16_t min = (uint16_t)param_defs[PARAM_ACQPS].min;
+    uint16_t step = acq_tune.acqps / ACQ_TUNE_STEP_DIV;
+    uint16_t next;
+
+    if(0U == step)
+    {
+        step = 1U;
+    }
+    next = acq_tune.acqps - step;
+    if((next < min) || (next > acq_tune.acqps))
+    {
+        next = min;
+    }
+
+    tune_start(next);
+}
+
+//
+// tune_done - The reference held: apply the longest of the channel minima
+//
+static void tune_done(void)
+{
+    uint16_t ch;
+    uint16_t prescale = (uint16_t)param_value[PARAM_ADC_PRESCALE];
+
+    acq_tune.chosen = 0;
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        if(acq_tune.minAcqps[ch] > acq_tune.chosen)
+        {
+            acq_tune.chosen = acq_tune.minAcqps[ch];
+        }
+    }
+
+    acq_tune.minPeriodTicks = adc_min_period(acq_tune.chosen, prescale);
+    acq_tune.maxRateHz = ACQ_TBCLK_HZ /
+                         ((uint32_t)acq_tune.minPeriodTicks + 1UL);
+    acq_tune.acqps = acq_tune.chosen;
+    acq_tune.state = ACQ_TUNE_TUNED;
+    params_write(PARAM_ACQPS, acq_tune.chosen);
+}
+
+//
+// tune_measure - Push a buffer set into the block of each channel.
+// Returns 1 when every block has completed its window and left its mean
+// and noise in tune_snap[].
+//
+static uint16_t tune_measure(const SampleStore *const stores[NUM_CHANNELS])
+{
+    const SampleStore *s;
+    uint16_t ch, i, bit;
+
+    if(tune_skip)
+    {
+        tune_skip = 0;                      // Source settling to the window
+        tune_pending = ACQ_TUNE_ALL;
+        for(ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            stats_init(&tune_stats[ch], STATS_TUMBLING,
+                       ACQ_TUNE_SETS * stores[ch]->count);
+        }
+        return 0;
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        bit = 1U << ch;
+        if(0U == (tune_pending & bit))
+        {
+            continue;
+        }
+        s = stores[ch];
+        for(i = 0; i < s->count; i++)
+        {
+            stats_push(&tune_stats[ch], sample_store_get(s, i));
+        }
+        if(stats_snapshot(&tune_stats[ch], &tune_snap[ch]))
+        {
+            tune_pending &= ~bit;
+        }
+    }
+
+    return 0U == tune_pending;
+}
+
+#endif
+
+//
+// End of File
+//
@@ -0,0 +1,114 @@
+//#############################################################################
+//
+// FILE: acq_tune.h
+//
+// TITLE: Acquisition window (ACQPS) characterisation and tuning
+//
+// DESCRIPTION:
+// Building with ACQ_TUNE=1 adds a bench mode that finds the shortest
+// sample window of SOC0..2 for the source impedance actually connected to
+// each channel. Apply a stable input to every channel (a DC level, not
+// the CP PWM or the mains), preferably a different one per channel so the
+// sample capacitor has to move between conversions, then start the
+// firmware. acq_tune_poll(), called once per buffer set while no write
+// waits for params_commit(), then
+//
+//     1. sets PARAM_ACQPS to the longest window that fits the sample
+//        period (acq_tune.refAcqps) and takes the mean and noise of each
+//        channel there as the settled reference
+//     2. shortens the window by 1/ACQ_TUNE_STEP_DIV (at least 1) per step
+//        and measures again. A channel passes a step while its mean is
+//        within ACQ_TUNE_ERR_Q4 of the reference (settling error) and its
+//        noise at most ACQ_TUNE_NOISE_Q4 above it; its first failure ends
+//        its sweep
+//     3. measures the reference window again: if a mean moved by more
+//        than ACQ_TUNE_ERR_Q4 the input was not stable and nothing is
+//        applied (ACQ_TUNE_UNSTABLE)
+//     4. writes the largest of the channel minima to PARAM_ACQPS, which
+//        SOC0..2 share (ACQ_TUNE_TUNED), and leaves the shortest sample
+//        period it allows in acq_tune.minPeriodTicks and acq_tune.maxRateHz
+//
+// Every measurement skips the first buffer set after the change and takes
+// the next ACQ_TUNE_SETS as one tumbling window of a StatsBlock per
+// channel (stats.h). The sample period limits are those of adc_timing.h.
+// The error and noise of every step are kept in acq_tune.curve[] for the
+// watch window. The result is not saved; params_save() keeps it. The
+// self-test (adc_bist.h) pauses while the window leaves it no slot.
+//
+// tests/test_acq_tune.c runs this file on the host against the codes
+// tools/acq_model.py computes from an RC model of the sources and the
+// sample capacitor, one buffer set per window, and checks the curve and
+// the window chosen. ACQ_OVF_SWEEP (acq_gap.h) changes the sample period
+// under the sweep, so the two cannot be built together.
+//
+//#############################################################################
+
+#ifndef _acq_tune_h
+#define _acq_tune_h
+
+#include <stdint.h>
+#include "channels.h"
+#include "sample_store.h"
+#include "acq_gap.h"
+
+//
+// Defines
+//
+#ifndef ACQ_TUNE
+#define ACQ_TUNE                0
+#endif
+
+#if ACQ_TUNE && ACQ_OVF_SWEEP
+#error "ACQ_TUNE and ACQ_OVF_SWEEP cannot be built together"
+#endif
+
+#define ACQ_TUNE_SETS           4U          // Buffer sets per measurement
+#define ACQ_TUNE_STEP_DIV       8U          // Step: window / 8
+#define ACQ_TUNE_MAX_STEPS      48U
+#define ACQ_TUNE_ERR_Q4         8           // 0.5 LSB settling error
+#define ACQ_TUNE_NOISE_Q4       4           // 0.25 LSB added noise
+#define ACQ_TUNE_MAX_NOISE_Q4   64          // Reference noise of a stable input
+
+#define ACQ_TUNE_IDLE           0U
+#define ACQ_TUNE_REFERENCE      1U
+#define ACQ_TUNE_SWEEP          2U
+#define ACQ_TUNE_CHECK          3U
+#define ACQ_TUNE_TUNED          4U          // Done, PARAM_ACQPS written
+#define ACQ_TUNE_UNSTABLE       5U          // Done, input moved or too noisy
+#define ACQ_TUNE_NO_ROOM        6U          // Done, period too short to sweep
+
+typedef struct
+{
+    uint16_t acqps;
+    int16_t errQ4[NUM_CHANNELS];            // Mean - reference, Q4 counts
+    uint16_t noiseQ4[NUM_CHANNELS];         // Standard deviation, Q4 counts
+} AcqTuneStep;
+
+typedef struct
+{
+    uint16_t state;                         // ACQ_TUNE_*
+    uint16_t acqps;                         // Window being measured
+    uint16_t refAcqps;
+    uint16_t startAcqps;                    // PARAM_ACQPS before the run
+    int32_t refMeanQ4[NUM_CHANNELS];
+    uint16_t refNoiseQ4[NUM_CHANNELS];
+    uint16_t minAcqps[NUM_CHANNELS];        // Shortest passing window
+    uint16_t active;                        // Channels still passing, bits
+    uint16_t chosen;                        // Largest of minAcqps[]
+    uint16_t minPeriodTicks;                // Shortest period with chosen
+    uint32_t maxRateHz;
+    uint16_t steps;                         // Entries of curve[]
+    AcqTuneStep curve[ACQ_TUNE_MAX_STEPS];
+} AcqTune;
+
+//
+// Globals
+//
+extern AcqTune acq_tune;
+
+//
+// Function Prototypes
+//
+void acq_tune_poll(const SampleStore *const stores[NUM_CHANNELS]);
+
+#endif
@@ -0,0 +1,355 @@
+//#############################################################################
+//
+// FILE: adc_bist.c
+//
+// TITLE: Periodic ADC built-in self-test on the internal reference channels
+//
+// DESCRIPTION:
+// Slot placement, the background state machine that arms one SOCB trigger
+// per run, the checks against the expected codes, drift tracking and the
+// calibration follow-up.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "adc_bist.h"
+#include "adc_cal.h"
+#include "channels.h"
+#include "flash_log.h"
+#include "timebase.h"
+#include "temp_monitor.h"
+#include "adc_timing.h"
+
+//
+// Defines
+//
+#define BIST_IDLE               0U
+#define BIST_ARMED              1U          // SOCB enabled, not fired yet
+#define BIST_CONVERTING         2U          // Fired, waiting for the results
+#define BIST_OFF                3U          // No slot in the sample period
+
+//
+// Globals
+//
+AdcBist adc_bist;
+
+static uint16_t bist_state;
+static uint32_t bist_atMs;                  // Last run started
+static uint32_t bist_firedAt;               // tb_now32() when SOCB fired
+static int32_t bist_sumLo;                  // Baseline sums
+static int32_t bist_sumMid;
+static uint16_t bist_baseRuns;
+
+//
+// Calibration the drift is applied to, and what was last written back
+//
+static int32_t bist_baseOffset[NUM_CHANNELS];
+static int32_t bist_baseGain[NUM_CHANNELS];
+static int32_t bist_setOffset[NUM_CHANNELS];
+static int32_t bist_setGain[NUM_CHANNELS];
+
+//
+// Function Prototypes
+//
+static void bist_init_soc(void);
+static void bist_check(void);
+#if ADC_BIST_AUTO_CAL
+static void bist_follow_cal(void);
+#endif
+static void bist_rebase(void);
+static int32_t bist_abs(int32_t v);
+
+//
+// adc_bist_init - Place the slot after the fast conversions of a sample
+// period in TBCLK ticks with SOCA at socAt, and set up SOC5..7. acqps and
+// prescale are those of the fast SOCs. Call after init_EPWM1() and
+// initADC_A() with ePWM1 stopped, and again when any of them changes.
+//
+void adc_bist_init(uint16_t samplePeriodTicks, uint16_t socAt,
+                   uint16_t acqps, uint16_t prescale)
+{
+    uint32_t fast, slot, temp, start;
+
+    fast = adc_sysclk_to_tbclk(adc_fast_sysclk(acqps, prescale));
+    slot = adc_sysclk_to_tbclk(ADC_BIST_SLOT_SOCS *
+                               adc_soc_sysclk(ADC_BIST_ACQPS, prescale));
+    temp = adc_sysclk_to_tbclk(adc_temp_sysclk(prescale));
+    start = (uint32_t)socAt + fast + ADC_MARGIN_TBCLK;
+
+    //
+    // The ADC is busy from CMPB at most until start + temp + slot: the
+    // fast conversions end before start unless temperature conversions
+    // went first, and then those are in the budget already
+    //
+    if((start >= samplePeriodTicks) ||
+       ((start + temp + slot + ADC_MARGIN_TBCLK) >
+        ((uint32_t)samplePeriodTicks + socAt)))
+    {
+        adc_bist.cmpb = 0;
+        adc_bist.faults |= ADC_BIST_FAULT_NO_SLOT;
+        bist_state = BIST_OFF;
+    }
+    else
+    {
+        adc_bist.cmpb = (uint16_t)start;
+        adc_bist.faults &= ~ADC_BIST_FAULT_NO_SLOT;
+        bist_state = BIST_IDLE;
+    }
+
+    EALLOW;
+    EPwm1Regs.ETSEL.bit.SOCBEN = 0;
+    EPwm1Regs.ETSEL.bit.SOCBSEL = 4;        // SOCB on up-count CMPB
+    EPwm1Regs.ETPS.bit.SOCBPRD = 1;
+    EPwm1Regs.CMPB.bit.CMPB = adc_bist.cmpb;
+    EPwm1Regs.ETCLR.bit.SOCB = 1;
+    EDIS;
+
+    bist_init_soc();
+    bist_atMs = flog_time_ms();
+}
+
+//
+// adc_bist_poll - Background task: start a run every ADC_BIST_PERIOD_MS,
+// follow it to the results and check them
+//
+void adc_bist_poll(void)
+{
+    uint32_t now = flog_time_ms();
+
+    switch(bist_state)
+    {
+        case BIST_IDLE:
+            if((now - bist_atMs) < ADC_BIST_PERIOD_MS)
+            {
+                break;
+            }
+            bist_atMs = now;
+            EALLOW;
+            EPwm1Regs.ETCLR.bit.SOCB = 1;
+            EPwm1Regs.ETSEL.bit.SOCBEN = 1;
+            EDIS;
+            bist_state = BIST_ARMED;
+            break;
+
+        case BIST_ARMED:
+            if(EPwm1Regs.ETFLG.bit.SOCB)
+            {
+                //
+                // Fired: one set of conversions is in the slot
+                //
+                EALLOW;
+                EPwm1Regs.ETSEL.bit.SOCBEN = 0;
+                EPwm1Regs.ETCLR.bit.SOCB = 1;
+                EDIS;
+                bist_firedAt = tb_now32();
+                bist_state = BIST_CONVERTING;
+            }
+            else if((now - bist_atMs) > ADC_BIST_TIMEOUT_MS)
+            {
+                EALLOW;
+                EPwm1Regs.ETSEL.bit.SOCBEN = 0;
+                EDIS;
+                if(!(adc_bist.faults & ADC_BIST_FAULT_TRIGGER))
+                {
+                    adc_bist.faults |= ADC_BIST_FAULT_TRIGGER;
+                    adc_bist.faultEvents++;
+                }
+                bist_state = BIST_IDLE;
+            }
+            break;
+
+        case BIST_CONVERTING:
+            if((AdcaRegs.ADCSOCFLG1.all & ADC_BIST_SOC_MASK) ||
+               ((tb_now32() - bist_firedAt) <
+                (ADC_BIST_SETTLE_US * TB_CYCLES_PER_US)))
+            {
+                break;
+            }
+            adc_bist.lo = AdcaResultRegs.ADCRESULT5;
+            adc_bist.mid = AdcaResultRegs.ADCRESULT6;
+            adc_bist.temp = AdcaResultRegs.ADCRESULT7;
+            adc_bist.tempRef = AdcaResultRegs.ADCRESULT3;
+            adc_bist.faults &= ~ADC_BIST_FAULT_TRIGGER;
+            adc_bist.runs++;
+            bist_check();
+            bist_state = BIST_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+//
+// bist_check - Compare a run with the expected codes, track the drift and
+// let the calibration follow it
+//
+static void bist_check(void)
+{
+    uint16_t faults = adc_bist.faults &
+                      (ADC_BIST_FAULT_NO_SLOT | ADC_BIST_FAULT_TRIGGER);
+    int32_t lo = (int32_t)adc_bist.lo << 4;
+    int32_t mid = (int32_t)adc_bist.mid << 4;
+
+    if(adc_bist.lo > ADC_BIST_LO_TOL)
+    {
+        faults |= ADC_BIST_FAULT_OFFSET;
+    }
+    if(bist_abs((int32_t)adc_bist.mid - ADC_BIST_MID_CODE) > ADC_BIST_MID_TOL)
+    {
+        faults |= ADC_BIST_FAULT_GAIN;
+    }
+    if(bist_abs((int32_t)adc_bist.temp - (int32_t)adc_bist.tempRef) >
+       ADC_BIST_TEMP_TOL)
+    {
+        faults |= ADC_BIST_FAULT_TEMP;
+    }
+
+    if(bist_baseRuns < ADC_BIST_BASELINE)
+    {
+        //
+        // Baseline: plain average of the first runs
+        //
+        bist_sumLo += lo;
+        bist_sumMid += mid;
+        if(++bist_baseRuns == ADC_BIST_BASELINE)
+        {
+            adc_bist.baseLoQ4 = bist_sumLo / (int32_t)ADC_BIST_BASELINE;
+            adc_bist.baseMidQ4 = bist_sumMid / (int32_t)ADC_BIST_BASELINE;
+            adc_bist.loQ4 = adc_bist.baseLoQ4;
+            adc_bist.midQ4 = adc_bist.baseMidQ4;
+            bist_rebase();
+        }
+    }
+    else
+    {
+        adc_bist.loQ4 += (lo - adc_bist.loQ4) >> ADC_BIST_EWMA_SHIFT;
+        adc_bist.midQ4 += (mid - adc_bist.midQ4) >> ADC_BIST_EWMA_SHIFT;
+        adc_bist.driftLoQ4 = (int16_t)(adc_bist.loQ4 - adc_bist.baseLoQ4);
+        adc_bist.driftMidQ4 = (int16_t)(adc_bist.midQ4 - adc_bist.baseMidQ4);
+
+        if((bist_abs(adc_bist.driftLoQ4) > ADC_BIST_DRIFT_TOL_Q4) ||
+           (bist_abs(adc_bist.driftMidQ4) > ADC_BIST_DRIFT_TOL_Q4))
+        {
+            faults |= ADC_BIST_FAULT_DRIFT;
+        }
+
+#if ADC_BIST_AUTO_CAL
+        if(!(faults & (ADC_BIST_FAULT_OFFSET | ADC_BIST_FAULT_GAIN)))
+        {
+            bist_follow_cal();
+        }
+#endif
+    }
+
+    if(faults & ~adc_bist.faults)
+    {
+        adc_bist.faultEvents++;
+    }
+    adc_bist.faults = faults;
+}
+
+#if ADC_BIST_AUTO_CAL
+//
+// bist_follow_cal - Move the offset and gain of every channel with the
+// converter drift since the baseline. A calibration changed by someone
+// else (adc_cal_fit()) becomes the new baseline.
+//
+static void bist_follow_cal(void)
+{
+    int32_t span0 = adc_bist.baseMidQ4 - adc_bist.baseLoQ4;
+    int32_t span = adc_bist.midQ4 - adc_bist.loQ4;
+    int32_t offset, gain;
+    uint16_t ch, intState;
+
+    if((span0 <= 0) || (span <= 0))
+    {
+        return;
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        if((adc_cal[ch].offset != bist_setOffset[ch]) ||
+           (adc_cal[ch].gain != bist_setGain[ch]))
+        {
+            bist_rebase();
+            return;
+        }
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        offset = adc_bist.loQ4 +
+                 (int32_t)(((int64_t)(bist_baseOffset[ch] - adc_bist.baseLoQ4) *
+                            span) / span0);
+        gain = (int32_t)(((int64_t)bist_baseGain[ch] * span0) / span);
+
+        if((offset != bist_setOffset[ch]) || (gain != bist_setGain[ch]))
+        {
+            intState = __disable_interrupts();
+            adc_cal[ch].offset = offset;
+            adc_cal[ch].gain = gain;
+            __restore_interrupts(intState);
+            bist_setOffset[ch] = offset;
+            bist_setGain[ch] = gain;
+            adc_bist.calAdjusts++;
+        }
+    }
+}
+#endif
+
+//
+// bist_rebase - Take the current calibration and the current filtered codes
+// as the new baseline
+//
+static void bist_rebase(void)
+{
+    uint16_t ch;
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        bist_baseOffset[ch] = adc_cal[ch].offset;
+        bist_baseGain[ch] = adc_cal[ch].gain;
+        bist_setOffset[ch] = adc_cal[ch].offset;
+        bist_setGain[ch] = adc_cal[ch].gain;
+    }
+    adc_bist.baseLoQ4 = adc_bist.loQ4;
+    adc_bist.baseMidQ4 = adc_bist.midQ4;
+}
+
+//
+// bist_init_soc - SOC5..7 on ePWM1 SOCB, no interrupt
+//
+static void bist_init_soc(void)
+{
+    EALLOW;
+
+    AdcaRegs.ADCSOC5CTL.bit.CHSEL = ADC_BIST_LO_CHSEL;
+    AdcaRegs.ADCSOC5CTL.bit.ACQPS = ADC_BIST_ACQPS;
+    AdcaRegs.ADCSOC5CTL.bit.TRIGSEL = ADC_BIST_TRIGSEL;
+
+    AdcaRegs.ADCSOC6CTL.bit.CHSEL = ADC_BIST_MID_CHSEL;
+    AdcaRegs.ADCSOC6CTL.bit.ACQPS = ADC_BIST_ACQPS;
+    AdcaRegs.ADCSOC6CTL.bit.TRIGSEL = ADC_BIST_TRIGSEL;
+
+    AdcaRegs.ADCSOC7CTL.bit.CHSEL = TEMP_SENSOR_CHSEL;
+    AdcaRegs.ADCSOC7CTL.bit.ACQPS = TEMP_ACQPS;
+    AdcaRegs.ADCSOC7CTL.bit.TRIGSEL = ADC_BIST_TRIGSEL;
+
+    EDIS;
+}
+
+//
+// bist_abs - |v|
+//
+static int32_t bist_abs(int32_t v)
+{
+    return (v < 0) ? -v : v;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,135 @@
+//#############################################################################
+//
+// FILE: adc_bist.h
+//
+// TITLE: Periodic ADC built-in self-test on the internal reference channels
+//
+// DESCRIPTION:
+// Every ADC_BIST_PERIOD_MS the background converts, once each,
+//
+//     VREFLO          expected code 0: converter offset, and the ADCOFFTRIM
+//                     loaded by SetVREF() (a wrong trim shows up here)
+//     VREFHI / 2      expected code 2048: gain with the offset
+//     temperature     the A12 sensor again, compared with the latest
+//                     conversion of temp_monitor.h (settling of the high
+//                     impedance source, mux faults)
+//
+// on SOC5..7 (ADC_BIST_SOC_*), triggered by ePWM1 SOCB. SOCB fires at CMPB
+// in the same period as the ePWM1/2/4 SOCAs at CMPA, placed after the
+// three fast conversions have finished. The ADC is round robin, so the
+// temperature conversions (SOC3/4 on Timer 0, temp_monitor.h) can land
+// anywhere in a period, before or between the fast and the self-test
+// ones. CMPB is only accepted if the self-test conversions still end
+// before the next SOCA with TEMP_SOCS temperature conversions in the same
+// period: the self-test never pushes a CP or mains sample into the next
+// period, though like the temperature monitor it can delay one within
+// its period. adc_bist_init() computes CMPB from the sample period, ACQPS
+// and PRESCALE with the conversion times of adc_timing.h; if the idle
+// part is too short the self-test stays off (ADC_BIST_FAULT_NO_SLOT).
+//
+// There is no ADCINT left (ADCINT1..3 are the sample ISRs, ADCINT4 the
+// temperature monitor), so adc_bist_poll() arms SOCB for one trigger,
+// disarms it when ETFLG.SOCB shows that it fired, and reads the results
+// once the SOC flags have cleared and ADC_BIST_SETTLE_US have passed.
+//
+// Each run is checked against the expected codes (ADC_BIST_*_TOL). The
+// first ADC_BIST_BASELINE runs average into a baseline; later runs are
+// filtered (ADC_BIST_EWMA_SHIFT) and their drift from the baseline is
+// tracked. With ADC_BIST_AUTO_CAL=1 the offset and gain of every channel
+// in adc_cal[] follow the drift of the converter:
+//
+//     zero = lo + (zero0 - lo0) * span / span0,   span = mid - lo
+//     gain = gain0 * span0 / span
+//
+// relative to the calibration in place when the baseline was taken
+// (a later adc_cal_fit() starts a new baseline). Faults are kept in
+// adc_bist.faults and each onset is logged (FLOG_EV_ADC_BIST).
+//
+// ADC_BIST_LO_CHSEL and ADC_BIST_MID_CHSEL select the internal VREFLO and
+// VREFHI/2 connections of ADCA. The values 13 and 14 have not been checked
+// against the internal connections table of the F280013x data sheet, so
+// ADC_BIST_AUTO_CAL defaults to 0: the self-test only reports codes, drift
+// and faults and never touches adc_cal[]. Check both channels (the codes
+// must read ~0 and ~2048 on a board) before building with
+// ADC_BIST_AUTO_CAL=1.
+//
+//#############################################################################
+
+#ifndef _adc_bist_h
+#define _adc_bist_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#ifndef ADC_BIST_AUTO_CAL
+#define ADC_BIST_AUTO_CAL       0           // See ADC_BIST_*_CHSEL
+#endif
+
+#define ADC_BIST_PERIOD_MS      100U
+#define ADC_BIST_SETTLE_US      5UL
+#define ADC_BIST_TIMEOUT_MS     20U         // SOCB not seen: ePWM1 stopped
+
+#define ADC_BIST_SOC_LO         5U          // SOC5/ADCRESULT5
+#define ADC_BIST_SOC_MID        6U          // SOC6/ADCRESULT6
+#define ADC_BIST_SOC_TEMP       7U          // SOC7/ADCRESULT7
+#define ADC_BIST_LO_CHSEL       13U         // VREFLO, internal, unverified
+#define ADC_BIST_MID_CHSEL      14U         // VREFHI / 2, internal,
+                                            // unverified
+#define ADC_BIST_ACQPS          63U         // High impedance, as TEMP_ACQPS
+#define ADC_BIST_TRIGSEL        6U          // ePWM1 SOCB
+#define ADC_BIST_SOC_MASK       ((1U << ADC_BIST_SOC_LO) | \
+                                 (1U << ADC_BIST_SOC_MID) | \
+                                 (1U << ADC_BIST_SOC_TEMP))
+
+#define ADC_BIST_SLOT_SOCS      3U
+
+#define ADC_BIST_MID_CODE       2048
+#define ADC_BIST_LO_TOL         8           // Counts
+#define ADC_BIST_MID_TOL        24
+#define ADC_BIST_TEMP_TOL       32
+#define ADC_BIST_DRIFT_TOL_Q4   (4 * 16)    // 4 counts from the baseline
+
+#define ADC_BIST_BASELINE       16U         // Runs averaged
+#define ADC_BIST_EWMA_SHIFT     3U
+
+#define ADC_BIST_FAULT_OFFSET   0x0001U     // VREFLO out of tolerance
+#define ADC_BIST_FAULT_GAIN     0x0002U     // VREFHI/2 out of tolerance
+#define ADC_BIST_FAULT_TEMP     0x0004U     // Sensor readings disagree
+#define ADC_BIST_FAULT_DRIFT    0x0008U     // ADC_BIST_DRIFT_TOL_Q4 exceeded
+#define ADC_BIST_FAULT_NO_SLOT  0x0010U     // Idle part of the period too short
+#define ADC_BIST_FAULT_TRIGGER  0x0020U     // SOCB did not fire
+
+typedef struct
+{
+    uint16_t lo;                            // Last raw codes
+    uint16_t mid;
+    uint16_t temp;
+    uint16_t tempRef;                       // temp_monitor's last code
+    int32_t loQ4;                           // Filtered, Q4 counts
+    int32_t midQ4;
+    int32_t baseLoQ4;                       // Baseline
+    int32_t baseMidQ4;
+    int16_t driftLoQ4;                      // Filtered - baseline
+    int16_t driftMidQ4;
+    uint16_t cmpb;                          // Slot position, 0: none
+    uint16_t faults;                        // ADC_BIST_FAULT_*
+    uint16_t faultEvents;                   // Onsets
+    uint16_t calAdjusts;                    // adc_cal[] updates
+    uint32_t runs;
+} AdcBist;
+
+//
+// Globals
+//
+extern AdcBist adc_bist;
+
+//
+// Function Prototypes
+//
+void adc_bist_init(uint16_t samplePeriodTicks, uint16_t socAt,
+                   uint16_t acqps, uint16_t prescale);
+void adc_bist_poll(void);
+
+#endif
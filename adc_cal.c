@@ -0,0 +1,220 @@
+//#############################################################################
+//
+// FILE: adc_cal.c
+//
+// TITLE: Fixed-point ADC count to millivolt conversion with calibration
+//
+// DESCRIPTION:
+// Seeding, two-point fitting and the flash record of the per-channel
+// gain/offset used by adc_cal_to_mv(). Everything here runs in the
+// background; none of it uses floating point.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "adc_cal.h"
+#include "params.h"
+#include "flash_log.h"
+
+//
+// Defines
+//
+#define ADC_CAL_OTP_OFFTRIM     (*(volatile uint16_t *)((uint32_t)0x7016CU))
+#define ADC_CAL_OTP_SHIFT_3P3   8U          // Internal 3.3 V reference trim
+
+//
+// Globals
+//
+AdcCal adc_cal[NUM_CHANNELS];
+uint16_t adc_cal_otpTrim;
+uint16_t adc_cal_trimMismatch;
+
+//
+// Function Prototypes
+//
+static void adc_cal_load(const AdcCalStore *store);
+
+//
+// adc_cal_nominal - Gain for a front-end span, Q(shift) mV per count.
+//
+static int32_t adc_cal_nominal(int32_t spanMv, uint16_t shift)
+{
+    return(spanMv << (shift - ADC_CAL_RESOLUTION_BITS));
+}
+
+//
+// adc_cal_init - Seed all channels with the nominal front-end values and
+// record the OTP offset trim, then take the fitted channels of the saved
+// flash copy. Call after SetVREF() and params_init().
+//
+// SetVREF() writes the OTP trim into ADCOFFTRIM, so the converter offset is
+// already corrected in hardware and the software offset starts at the
+// nominal mid-scale of each front end. A trim register that does not match
+// OTP means the wrong reference mode was selected; it is flagged in
+// adc_cal_trimMismatch.
+//
+void adc_cal_init(void)
+{
+    uint16_t ch;
+
+    adc_cal_otpTrim = (ADC_CAL_OTP_OFFTRIM >> ADC_CAL_OTP_SHIFT_3P3) & 0xFFU;
+    adc_cal_trimMismatch = (AdcaRegs.ADCOFFTRIM.bit.OFFTRIM != adc_cal_otpTrim);
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        adc_cal[ch].offset = (int32_t)ADC_CAL_Q4(ADC_CAL_NOMINAL_OFFSET);
+        adc_cal[ch].calibrated = 0;
+
+        if(CH_IN_ADC_500VAC == ch)
+        {
+            adc_cal[ch].shift = ADC_CAL_SHIFT_MAINS;
+            adc_cal[ch].gain = adc_cal_nominal(ADC_CAL_MAINS_SPAN_MV,
+                                               ADC_CAL_SHIFT_MAINS);
+        }
+        else
+        {
+            adc_cal[ch].shift = ADC_CAL_SHIFT_CP;
+            adc_cal[ch].gain = adc_cal_nominal(ADC_CAL_CP_SPAN_MV,
+                                               ADC_CAL_SHIFT_CP);
+        }
+    }
+
+    adc_cal_load(params_cal_copy());
+}
+
+//
+// adc_cal_fit - Two-point calibration. countsLowQ4/countsHighQ4 are the
+// averaged readings (Q4 counts) taken with refLowMv/refHighMv applied to
+// the channel input. On success the new gain/offset replace the current
+// ones and 1 is returned; an implausible fit leaves them untouched and
+// returns 0. The result is kept by the next params_save().
+//
+uint16_t adc_cal_fit(uint16_t channel, int32_t refLowMv, uint32_t countsLowQ4,
+                     int32_t refHighMv, uint32_t countsHighQ4)
+{
+    AdcCal *cal;
+    int64_t gain, offsetQ4;
+    int32_t deltaQ4;
+    uint16_t intState;
+
+    if(NUM_CHANNELS <= channel)
+    {
+        return 0;
+    }
+
+    cal = &adc_cal[channel];
+    deltaQ4 = (int32_t)countsHighQ4 - (int32_t)countsLowQ4;
+
+    if((deltaQ4 <= 0) || (refHighMv <= refLowMv))
+    {
+        return 0;
+    }
+
+    //
+    // gain = dMv / dCounts, in Q(shift)
+    //
+    gain = ((int64_t)(refHighMv - refLowMv) << (cal->shift + 4)) / deltaQ4;
+    if((gain <= 0) || (gain > INT32_MAX))
+    {
+        return 0;
+    }
+
+    //
+    // offset = counts at 0 mV = countsLow - refLow / gain
+    //
+    offsetQ4 = (int64_t)countsLowQ4 -
+               (((int64_t)refLowMv << (cal->shift + 4)) / gain);
+    if((offsetQ4 < 0) || (offsetQ4 > (int64_t)ADC_CAL_Q4(4095)))
+    {
+        return 0;
+    }
+
+    intState = __disable_interrupts();
+    cal->gain = (int32_t)gain;
+    cal->offset = (int32_t)offsetQ4;
+    cal->calibrated = 1;
+    __restore_interrupts(intState);
+
+    return 1;
+}
+
+//
+// adc_cal_average_q4 - Mean of the newest samples of a store, in Q4 counts.
+//
+uint32_t adc_cal_average_q4(const SampleStore *store, uint16_t count)
+{
+    uint32_t sum = 0;
+    uint16_t i;
+
+    if(count > store->count)
+    {
+        count = store->count;
+    }
+    if(0 == count)
+    {
+        return 0;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        sum += sample_store_read(store, i);
+    }
+
+    return((sum << 4) / count);
+}
+
+//
+// adc_cal_store - Flash record of the current calibration, for
+// params_save()
+//
+void adc_cal_store(AdcCalStore *store)
+{
+    uint16_t i;
+
+    store->magic = ADC_CAL_STORE_MAGIC;
+    store->count = NUM_CHANNELS;
+    for(i = 0; i < NUM_CHANNELS; i++)
+    {
+        store->cal[i] = adc_cal[i];
+    }
+    for(i = 0; i < ADC_CAL_STORE_PAD; i++)
+    {
+        store->pad[i] = 0xFFFFU;
+    }
+    store->crc = flog_crc((const uint16_t *)store,
+                          (sizeof(AdcCalStore) - 1U));
+}
+
+//
+// adc_cal_load - Take the fitted channels of a saved record whose format
+// and ranges match this build; the others keep the nominal values
+//
+static void adc_cal_load(const AdcCalStore *store)
+{
+    const AdcCal *saved;
+    uint16_t ch;
+
+    if((0 == store) || (ADC_CAL_STORE_MAGIC != store->magic) ||
+       (NUM_CHANNELS != store->count))
+    {
+        return;
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        saved = &store->cal[ch];
+        if((1U == saved->calibrated) && (saved->shift == adc_cal[ch].shift) &&
+           (saved->gain > 0) && (saved->offset >= 0) &&
+           (saved->offset <= (int32_t)ADC_CAL_Q4(4095)))
+        {
+            adc_cal[ch] = *saved;
+        }
+    }
+}
+
+//
+// End of File
+//
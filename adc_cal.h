@@ -0,0 +1,105 @@
+//#############################################################################
+//
+// FILE: adc_cal.h
+//
+// TITLE: Fixed-point ADC count to millivolt conversion with calibration
+//
+// DESCRIPTION:
+// Each channel converts with one multiply and one shift:
+//
+//     mV = ((16 * counts - offset) * gain) >> (shift + 4)
+//
+// offset is the reading at 0 mV in Q4 counts, so a fitted offset keeps its
+// fractional part. gain is the input-referred mV per ADC count in Q24 for
+// the CP channels (less than 128 mV/count) and in Q15 for the 500 VAC
+// channel (several hundred mV/count). adc_cal_to_mv() is integer-only,
+// but the product needs 64 bits, which the C28x does through a run-time
+// support routine in flash: use it in the background only.
+//
+// adc_cal_init() seeds every channel from the nominal front-end design and
+// records the ADC offset trim that SetVREF() loads from OTP (0x7016C).
+// adc_cal_fit() replaces the nominal values with a two-point fit against
+// known reference levels; over CAN, TLM_OP_CAL_LOW and TLM_OP_CAL_HIGH
+// take the two points from the channel mean of stats.h (telemetry.h).
+//
+// params_save() writes adc_cal[] as an AdcCalStore next to the parameter
+// values in the same flash copy, and adc_cal_init() loads the fitted
+// channels back from it (params_cal_copy()), so a fit survives a reset
+// once it has been saved. Call adc_cal_init() after params_init().
+//
+//#############################################################################
+
+#ifndef _adc_cal_h
+#define _adc_cal_h
+
+#include <stdint.h>
+#include "channels.h"
+#include "sample_store.h"
+
+//
+// Defines
+//
+#define ADC_CAL_RESOLUTION_BITS 12
+
+//
+// Nominal input spans of the analog front ends (full ADC scale, input mV)
+//
+#define ADC_CAL_CP_SPAN_MV      24000L      // Level adapter: -12 V .. +12 V
+#define ADC_CAL_MAINS_SPAN_MV   1600000L    // Divider: -800 V .. +800 V peak
+#define ADC_CAL_NOMINAL_OFFSET  2048        // 0 V at mid-scale
+
+#define ADC_CAL_SHIFT_CP        24
+#define ADC_CAL_SHIFT_MAINS     15
+
+//
+// Q4 fixed point for averaged counts
+//
+#define ADC_CAL_Q4(counts)      ((uint32_t)(counts) << 4)
+
+#define ADC_CAL_STORE_MAGIC     0xCA1BU
+#define ADC_CAL_STORE_PAD       3U          // 24-word record
+
+typedef struct
+{
+    int32_t  gain;          // mV per count, Q(shift)
+    int32_t  offset;        // Counts at 0 mV, Q4
+    uint16_t shift;         // ADC_CAL_SHIFT_CP or ADC_CAL_SHIFT_MAINS
+    uint16_t calibrated;    // 1 once adc_cal_fit() succeeded
+} AdcCal;
+
+typedef struct
+{
+    uint16_t magic;         // ADC_CAL_STORE_MAGIC
+    uint16_t count;         // NUM_CHANNELS
+    AdcCal   cal[NUM_CHANNELS];
+    uint16_t pad[ADC_CAL_STORE_PAD];
+    uint16_t crc;           // CRC-16/CCITT of the words above, written last
+} AdcCalStore;
+
+//
+// Globals
+//
+extern AdcCal adc_cal[NUM_CHANNELS];
+extern uint16_t adc_cal_otpTrim;            // OFFTRIM value from OTP
+extern uint16_t adc_cal_trimMismatch;       // ADCOFFTRIM differs from OTP
+
+//
+// Function Prototypes
+//
+void adc_cal_init(void);
+uint16_t adc_cal_fit(uint16_t channel, int32_t refLowMv, uint32_t countsLowQ4,
+                     int32_t refHighMv, uint32_t countsHighQ4);
+uint32_t adc_cal_average_q4(const SampleStore *store, uint16_t count);
+void adc_cal_store(AdcCalStore *store);
+
+//
+// adc_cal_to_mv - Convert a raw 12-bit sample to input millivolts.
+// Background only (64-bit product).
+//
+static inline int32_t adc_cal_to_mv(const AdcCal *cal, uint16_t counts)
+{
+    return((int32_t)(((int64_t)(((int32_t)counts << 4) - cal->offset) *
+                      cal->gain) >> (cal->shift + 4)));
+}
+
+#endif
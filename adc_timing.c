@@ -0,0 +1,111 @@
+//#############################################################################
+//
+// FILE: adc_timing.c
+//
+// TITLE: Conversion time model of ADCA
+//
+// DESCRIPTION:
+// SOC durations, and the sample window and sample period limits that
+// follow from them.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "adc_timing.h"
+#include "params.h"
+#include "temp_monitor.h"
+#include "sysclk.h"
+
+//
+// adc_soc_sysclk - SYSCLK cycles of one SOC with window acqps at
+// ADCCTL2.PRESCALE prescale
+//
+uint32_t adc_soc_sysclk(uint16_t acqps, uint16_t prescale)
+{
+    uint32_t adcclk = (uint32_t)prescale / 2UL + 1UL;   // SYSCLK per ADCCLK
+
+    return (uint32_t)acqps + 1UL + ADC_CONV_ADCCLK * adcclk;
+}
+
+//
+// adc_fast_sysclk - SYSCLK cycles of SOC0..2 with window acqps
+//
+uint32_t adc_fast_sysclk(uint16_t acqps, uint16_t prescale)
+{
+    return ADC_FAST_SOCS * adc_soc_sysclk(acqps, prescale);
+}
+
+//
+// adc_temp_sysclk - SYSCLK cycles of the conversions of one temperature
+// monitor trigger
+//
+uint32_t adc_temp_sysclk(uint16_t prescale)
+{
+    return TEMP_SOCS * adc_soc_sysclk(TEMP_ACQPS, prescale);
+}
+
+//
+// adc_sysclk_to_tbclk - SYSCLK cycles to TBCLK ticks, rounded up
+//
+uint32_t adc_sysclk_to_tbclk(uint32_t sysclk)
+{
+    return (sysclk + SYSCLK_PER_TBCLK - 1UL) / SYSCLK_PER_TBCLK;
+}
+
+//
+// adc_max_acqps - Longest window (ACQPS) of SOC0..2 whose conversions,
+// and those of a temperature trigger, fit a sample period of
+// samplePeriodTicks TBCLK ticks at prescale. Returns 0 if none fits.
+//
+uint16_t adc_max_acqps(uint16_t samplePeriodTicks, uint16_t prescale)
+{
+    uint32_t temp = adc_temp_sysclk(prescale);
+    uint32_t fixed = adc_soc_sysclk(0U, prescale);      // Without the window
+    uint32_t budget, acqps;
+
+    if(samplePeriodTicks <= ADC_MARGIN_TBCLK)
+    {
+        return 0;
+    }
+
+    budget = SYSCLK_PER_TBCLK *
+             ((uint32_t)samplePeriodTicks - ADC_MARGIN_TBCLK);
+    if(budget < temp + ADC_FAST_SOCS * (fixed + 1UL))
+    {
+        return 0;
+    }
+
+    acqps = (budget - temp) / ADC_FAST_SOCS - fixed;
+    if(acqps > (uint32_t)param_defs[PARAM_ACQPS].max)
+    {
+        acqps = (uint32_t)param_defs[PARAM_ACQPS].max;
+    }
+
+    return (uint16_t)acqps;
+}
+
+//
+// adc_min_period - Shortest PARAM_SAMPLE_PERIOD (TBPRD) that leaves room
+// for SOC0..2 with window acqps and a temperature trigger, the inverse of
+// adc_max_acqps()
+//
+uint16_t adc_min_period(uint16_t acqps, uint16_t prescale)
+{
+    uint32_t tbprd = adc_sysclk_to_tbclk(adc_fast_sysclk(acqps, prescale) +
+                                         adc_temp_sysclk(prescale)) +
+                     ADC_MARGIN_TBCLK - 1UL;
+
+    if(tbprd < (uint32_t)param_defs[PARAM_SAMPLE_PERIOD].min)
+    {
+        tbprd = (uint32_t)param_defs[PARAM_SAMPLE_PERIOD].min;
+    }
+
+    return (uint16_t)tbprd;
+}
+
+//
+// End of File
+//
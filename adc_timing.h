@@ -0,0 +1,43 @@
+//#############################################################################
+//
+// FILE: adc_timing.h
+//
+// TITLE: Conversion time model of ADCA
+//
+// DESCRIPTION:
+// One SOC takes its sample window (ACQPS + 1 SYSCLK) plus a 12-bit
+// conversion of ADC_CONV_ADCCLK ADCCLK, ADCCLK being SYSCLK /
+// (PRESCALE / 2 + 1). Every sample period ePWM1/2/4 start SOC0..2
+// (ADC_FAST_SOCS) at CMPA; Timer 0 adds TEMP_SOCS temperature conversions
+// at 100 Hz (temp_monitor.h), which the round robin can place anywhere in
+// a period, so every budget reserves room for them. ADC_MARGIN_TBCLK
+// covers the trigger latency and the rounding to TBCLK ticks.
+//
+// The parameter rules (params.h), the self-test slot (adc_bist.h) and the
+// window sweep (acq_tune.h) all take their timing from here.
+//
+//#############################################################################
+
+#ifndef _adc_timing_h
+#define _adc_timing_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define ADC_FAST_SOCS           3U          // SOC0..2
+#define ADC_CONV_ADCCLK         11U         // 12-bit conversion, rounded up
+#define ADC_MARGIN_TBCLK        8U
+
+//
+// Function Prototypes
+//
+uint32_t adc_soc_sysclk(uint16_t acqps, uint16_t prescale);
+uint32_t adc_fast_sysclk(uint16_t acqps, uint16_t prescale);
+uint32_t adc_temp_sysclk(uint16_t prescale);
+uint32_t adc_sysclk_to_tbclk(uint32_t sysclk);
+uint16_t adc_max_acqps(uint16_t samplePeriodTicks, uint16_t prescale);
+uint16_t adc_min_period(uint16_t acqps, uint16_t prescale);
+
+#endif
@@ -0,0 +1,160 @@
+//#############################################################################
+//
+// FILE: bench.c
+//
+// TITLE: Cycle-count benchmarking on CPU Timer 2
+//
+// DESCRIPTION:
+// Starts CPU Timer 2 as a free-running SYSCLK counter, keeps the per-ISR
+// cycle statistics and runs the flash/RAM kernel benchmark: the
+// per-sample store path of the ADC ISRs (sample_store_append() and
+// sample_store_get()) is inlined into one wrapper in .text and one in
+// HotIsr, and both copies are timed at start-up. In the CPU1_FLASH build bench_kernelDelta
+// is the cost of the flash wait states on that kernel; in the CPU1_RAM
+// build both copies run from RAM and the delta is ~0.
+//
+// The ISR statistics in bench_isr[] give the same comparison for the ADC
+// ISRs when read in a RAM build and in a flash build with HotIsr left in
+// flash (see 280013x_generic_flash_lnk.cmd).
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "bench.h"
+#include "sample_store.h"
+
+//
+// Defines
+//
+#define BENCH_KERNEL_SAMPLES    64
+
+//
+// Globals
+//
+BenchStat bench_isr[BENCH_NUM_ISR];
+uint16_t bench_overhead;
+uint32_t bench_kernelFlash;                 // Cycles, kernel run from .text
+uint32_t bench_kernelRam;                   // Cycles, kernel run from HotIsr
+int32_t bench_kernelDelta;                  // Flash minus RAM
+volatile uint32_t bench_kernelSink;
+
+static uint16_t bench_words[SAMPLE_STORE_WORDS(BENCH_KERNEL_SAMPLES)];
+static SampleStore bench_store;
+
+//
+// Function Prototypes
+//
+static uint32_t bench_kernel_flash(void);
+static uint32_t bench_kernel_ram(void);
+
+#pragma CODE_SECTION(bench_kernel_ram, "HotIsr");
+#pragma FUNC_CANNOT_INLINE(bench_kernel_flash);
+#pragma FUNC_CANNOT_INLINE(bench_kernel_ram);
+
+//
+// bench_kernel - Kernel under test: a block of samples through the store
+// functions the ADC ISRs call per sample. Always inlined, so each wrapper
+// below runs its own copy of the production code from its own memory.
+//
+#pragma FUNC_ALWAYS_INLINE(bench_kernel)
+static inline uint32_t bench_kernel(void)
+{
+    uint16_t i;
+    uint32_t sum = 0;
+
+    for(i = 0; i < BENCH_KERNEL_SAMPLES; i++)
+    {
+        sample_store_append(&bench_store, i * 37U);
+        sum += sample_store_get(&bench_store, i);
+    }
+
+    return sum;
+}
+
+//
+// bench_kernel_flash, bench_kernel_ram - The kernel in .text and in HotIsr
+//
+static uint32_t bench_kernel_flash(void)
+{
+    return bench_kernel();
+}
+
+static uint32_t bench_kernel_ram(void)
+{
+    return bench_kernel();
+}
+
+//
+// bench_init - Start CPU Timer 2 as a free-running cycle counter and
+// measure the cost of a BENCH_NOW() pair.
+//
+void bench_init(void)
+{
+    uint32_t t0, t1;
+    uint16_t i;
+
+    CpuTimer2Regs.TCR.bit.TSS = 1;          // Stop timer
+    CpuTimer2Regs.PRD.all = 0xFFFFFFFF;     // Full 32-bit range
+    CpuTimer2Regs.TPR.all = 0;              // Count SYSCLK
+    CpuTimer2Regs.TPRH.all = 0;
+    CpuTimer2Regs.TCR.bit.TIE = 0;          // No interrupt
+    CpuTimer2Regs.TCR.bit.FREE = 0;         // Stop on debugger halt
+    CpuTimer2Regs.TCR.bit.SOFT = 0;
+    CpuTimer2Regs.TCR.bit.TRB = 1;          // Reload
+    CpuTimer2Regs.TCR.bit.TSS = 0;          // Start
+
+    bench_overhead = 0;
+    t0 = BENCH_NOW();
+    t1 = BENCH_NOW();
+    bench_overhead = (uint16_t)(t0 - t1);
+
+    for(i = 0; i < BENCH_NUM_ISR; i++)
+    {
+        bench_reset(&bench_isr[i]);
+    }
+}
+
+//
+// bench_reset - Clear a statistics record.
+//
+void bench_reset(BenchStat *stat)
+{
+    stat->last = 0;
+    stat->min = 0xFFFFFFFF;
+    stat->max = 0;
+    stat->count = 0;
+}
+
+//
+// bench_run_kernels - Time the flash and RAM copies of the kernel. Must run
+// after InitSysCtrl() has copied the RAM functions.
+//
+void bench_run_kernels(void)
+{
+    uint32_t t0;
+
+    sample_store_init(&bench_store, bench_words, BENCH_KERNEL_SAMPLES);
+
+    //
+    // First call warms the flash prefetch/cache the same way for both
+    //
+    bench_kernelSink = bench_kernel_flash();
+    bench_kernelSink = bench_kernel_ram();
+
+    t0 = BENCH_NOW();
+    bench_kernelSink = bench_kernel_flash();
+    bench_kernelFlash = t0 - BENCH_NOW() - bench_overhead;
+
+    t0 = BENCH_NOW();
+    bench_kernelSink = bench_kernel_ram();
+    bench_kernelRam = t0 - BENCH_NOW() - bench_overhead;
+
+    bench_kernelDelta = (int32_t)bench_kernelFlash - (int32_t)bench_kernelRam;
+}
+
+//
+// End of File
+//
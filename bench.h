@@ -0,0 +1,81 @@
+//#############################################################################
+//
+// FILE: bench.h
+//
+// TITLE: Cycle-count benchmarking on CPU Timer 2
+//
+// DESCRIPTION:
+// CPU Timer 2 runs free at SYSCLK, counting down from 0xFFFFFFFF, and
+// stops while the debugger halts the CPU. BENCH_NOW() reads it; the
+// difference of two readings (earlier minus later) is the elapsed SYSCLK
+// cycles, wrap included.
+//
+// Usage in a function or ISR:
+//
+//     uint32_t t0 = BENCH_NOW();
+//     ...
+//     bench_record(&bench_isr[BENCH_ADCA1], t0);
+//
+//#############################################################################
+
+#ifndef _bench_h
+#define _bench_h
+
+#include "f28x_project.h"
+
+//
+// Defines
+//
+#define BENCH_NOW()         (CpuTimer2Regs.TIM.all)
+
+#define BENCH_ADCA1         0       // adcA1ISR - IN_ADC_500VAC
+#define BENCH_ADCA2         1       // adcA2ISR - IN_CP_ADC
+#define BENCH_ADCA3         2       // adcA3ISR - IN_CP_BORNE
+#define BENCH_PLL           3       // sogi_pll_push() in adcA1ISR
+#define BENCH_NUM_ISR       4
+
+typedef struct
+{
+    uint32_t last;
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+} BenchStat;
+
+//
+// Globals
+//
+extern BenchStat bench_isr[BENCH_NUM_ISR];
+extern uint16_t bench_overhead;
+extern uint32_t bench_kernelFlash;
+extern uint32_t bench_kernelRam;
+extern int32_t bench_kernelDelta;
+
+//
+// Function Prototypes
+//
+void bench_init(void);
+void bench_reset(BenchStat *stat);
+void bench_run_kernels(void);
+
+//
+// bench_record - Account the cycles elapsed since start.
+//
+#pragma FUNC_ALWAYS_INLINE(bench_record)
+static inline void bench_record(BenchStat *stat, uint32_t start)
+{
+    uint32_t cycles = start - BENCH_NOW() - bench_overhead;
+
+    stat->last = cycles;
+    if(cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if(cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    stat->count++;
+}
+
+#endif
@@ -0,0 +1,399 @@
+//#############################################################################
+//
+// FILE: biquad.c
+//
+// TITLE: Fixed-point cascaded biquad filter banks, Q15 and Q31
+//
+// DESCRIPTION:
+// Section kernels, per-sample and block entry points and the start-up
+// benchmark against the host model of tools/bq_design.py.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "biquad.h"
+#include "bq_coefs.h"
+#include "bench.h"
+
+//
+// Defines
+//
+#define BQ_Q15_ROUND            (1L << (BQ_Q15_FRAC - 1U))
+#define BQ_Q31_ROUND            (1LL << (BQ_Q31_FRAC - 1U))
+#define BQ_CHECK_MUL            33UL
+
+//
+// Globals
+//
+BqBenchStat bq_benchStat[BQ_NUM_BANKS];
+uint16_t bq_benchMismatch;
+
+static union
+{
+    int16_t q15[BQ_BENCH_SAMPLES];
+    int32_t q31[BQ_BENCH_SAMPLES];
+} bq_benchBuf;
+static BqQ15State bq_benchState15[BQ_MAX_SECTIONS];
+static BqQ31State bq_benchState31[BQ_MAX_SECTIONS];
+
+//
+// Function Prototypes
+//
+static int16_t bq_sat16(int32_t v);
+static int32_t bq_sat32(int64_t v);
+static int16_t bq_step_q15(const BqQ15Coef *c, BqQ15State *st, int16_t x);
+static int32_t bq_step_q31(const BqQ31Coef *c, BqQ31State *st, int32_t x);
+static void bq_bench_fill(uint16_t q31);
+static void bq_bench_bank(const BqBankDesc *desc, BqBenchStat *stat);
+
+//
+// bq_init_q15 - Attach a coefficient table and state memory, and clear
+// the state
+//
+void bq_init_q15(BqQ15Bank *bank, const BqQ15Coef *coef, BqQ15State *state,
+                 uint16_t sections)
+{
+    bank->coef = coef;
+    bank->state = state;
+    bank->sections = sections;
+    bq_reset_q15(bank);
+}
+
+//
+// bq_init_q31 - Attach a coefficient table and state memory, and clear
+// the state
+//
+void bq_init_q31(BqQ31Bank *bank, const BqQ31Coef *coef, BqQ31State *state,
+                 uint16_t sections)
+{
+    bank->coef = coef;
+    bank->state = state;
+    bank->sections = sections;
+    bq_reset_q31(bank);
+}
+
+//
+// bq_reset_q15 - Zero the delayed samples of all sections
+//
+void bq_reset_q15(BqQ15Bank *bank)
+{
+    uint16_t k;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        bank->state[k].x = 0;
+        bank->state[k].y = 0;
+    }
+}
+
+//
+// bq_reset_q31 - Zero the delayed samples of all sections
+//
+void bq_reset_q31(BqQ31Bank *bank)
+{
+    uint16_t k;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        bank->state[k].x1 = 0;
+        bank->state[k].x2 = 0;
+        bank->state[k].y1 = 0;
+        bank->state[k].y2 = 0;
+    }
+}
+
+//
+// bq_sample_q15 - Filter one sample through the cascade
+//
+int16_t bq_sample_q15(BqQ15Bank *bank, int16_t x)
+{
+    uint16_t k;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        x = bq_step_q15(&bank->coef[k], &bank->state[k], x);
+    }
+
+    return x;
+}
+
+//
+// bq_sample_q31 - Filter one sample through the cascade
+//
+int32_t bq_sample_q31(BqQ31Bank *bank, int32_t x)
+{
+    uint16_t k;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        x = bq_step_q31(&bank->coef[k], &bank->state[k], x);
+    }
+
+    return x;
+}
+
+//
+// bq_block_q15 - Filter n samples in place, one section at a time. On the
+// target the four delayed products of a sample are two DMACs.
+//
+void bq_block_q15(BqQ15Bank *bank, int16_t *data, uint16_t n)
+{
+    uint16_t k, i;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        const BqQ15Coef *c = &bank->coef[k];
+        BqQ15State st = bank->state[k];
+        int32_t b12 = c->b12;
+        int32_t na12 = c->na12;
+        int16_t b0 = c->b0;
+        int32_t acc, acc2;
+        int16_t x, y;
+
+        for(i = 0; i < n; i++)
+        {
+            x = data[i];
+            acc = (int32_t)b0 * x;
+#if defined(__TMS320C28XX__)
+            acc2 = 0;
+            __dmac(st.x, b12, acc, acc2, 0);
+            __dmac(st.y, na12, acc, acc2, 0);
+            acc += acc2;
+#else
+            acc2 = (int32_t)BQ_LO(st.x) * BQ_LO(b12) +
+                   (int32_t)BQ_HI(st.x) * BQ_HI(b12) +
+                   (int32_t)BQ_LO(st.y) * BQ_LO(na12) +
+                   (int32_t)BQ_HI(st.y) * BQ_HI(na12);
+            acc += acc2;
+#endif
+            y = bq_sat16((acc + BQ_Q15_ROUND) >> BQ_Q15_FRAC);
+
+            st.x = (int32_t)(((uint32_t)st.x << 16) | (uint16_t)x);
+            st.y = (int32_t)(((uint32_t)st.y << 16) | (uint16_t)y);
+            data[i] = y;
+        }
+
+        bank->state[k] = st;
+    }
+}
+
+//
+// bq_block_q31 - Filter n samples in place, one section at a time
+//
+void bq_block_q31(BqQ31Bank *bank, int32_t *data, uint16_t n)
+{
+    uint16_t k, i;
+
+    for(k = 0; k < bank->sections; k++)
+    {
+        const BqQ31Coef *c = &bank->coef[k];
+        BqQ31State *st = &bank->state[k];
+
+        for(i = 0; i < n; i++)
+        {
+            data[i] = bq_step_q31(c, st, data[i]);
+        }
+    }
+}
+
+//
+// bq_bench - Time and check every table of bq_coefs.c. Start-up only.
+//
+void bq_bench(void)
+{
+    uint16_t b;
+
+    bq_benchMismatch = 0;
+    for(b = 0; b < BQ_NUM_BANKS; b++)
+    {
+        bq_bench_bank(&bq_banks[b], &bq_benchStat[b]);
+        if(!bq_benchStat[b].match)
+        {
+            bq_benchMismatch++;
+        }
+    }
+}
+
+//
+// bq_bench_bank - Run one table over the stimulus through the block and
+// the per-sample paths
+//
+static void bq_bench_bank(const BqBankDesc *desc, BqBenchStat *stat)
+{
+    BqQ15Bank bank15;
+    BqQ31Bank bank31;
+    uint32_t t0, cycles, check = 0, checkSample = 0;
+    uint16_t i;
+
+    bq_init_q15(&bank15, (const BqQ15Coef *)desc->coef, bq_benchState15,
+                desc->q31 ? 0U : desc->sections);
+    bq_init_q31(&bank31, (const BqQ31Coef *)desc->coef, bq_benchState31,
+                desc->q31 ? desc->sections : 0U);
+
+    //
+    // Block path
+    //
+    bq_bench_fill(desc->q31);
+    if(desc->q31)
+    {
+        t0 = BENCH_NOW();
+        bq_block_q31(&bank31, bq_benchBuf.q31, BQ_BENCH_SAMPLES);
+        cycles = t0 - BENCH_NOW() - bench_overhead;
+        for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+        {
+            check = check * BQ_CHECK_MUL + (uint32_t)bq_benchBuf.q31[i];
+        }
+    }
+    else
+    {
+        t0 = BENCH_NOW();
+        bq_block_q15(&bank15, bq_benchBuf.q15, BQ_BENCH_SAMPLES);
+        cycles = t0 - BENCH_NOW() - bench_overhead;
+        for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+        {
+            check = check * BQ_CHECK_MUL + (uint16_t)bq_benchBuf.q15[i];
+        }
+    }
+    stat->blockCycles = cycles / ((uint32_t)BQ_BENCH_SAMPLES * desc->sections);
+    stat->checksum = check;
+
+    //
+    // Per-sample path
+    //
+    bq_bench_fill(desc->q31);
+    bq_reset_q15(&bank15);
+    bq_reset_q31(&bank31);
+    t0 = BENCH_NOW();
+    if(desc->q31)
+    {
+        for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+        {
+            bq_benchBuf.q31[i] = bq_sample_q31(&bank31, bq_benchBuf.q31[i]);
+        }
+    }
+    else
+    {
+        for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+        {
+            bq_benchBuf.q15[i] = bq_sample_q15(&bank15, bq_benchBuf.q15[i]);
+        }
+    }
+    cycles = t0 - BENCH_NOW() - bench_overhead;
+    stat->sampleCycles = cycles / ((uint32_t)BQ_BENCH_SAMPLES * desc->sections);
+
+    for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+    {
+        checkSample = checkSample * BQ_CHECK_MUL +
+                      (desc->q31 ? (uint32_t)bq_benchBuf.q31[i] :
+                                   (uint32_t)(uint16_t)bq_benchBuf.q15[i]);
+    }
+
+    stat->match = (check == desc->check) && (checkSample == desc->check);
+}
+
+//
+// bq_step_q15 - One Q15 section, one sample
+//
+static int16_t bq_step_q15(const BqQ15Coef *c, BqQ15State *st, int16_t x)
+{
+    int32_t acc;
+    int16_t y;
+
+    acc = (int32_t)c->b0 * x +
+          (int32_t)BQ_LO(st->x) * BQ_LO(c->b12) +
+          (int32_t)BQ_HI(st->x) * BQ_HI(c->b12) +
+          (int32_t)BQ_LO(st->y) * BQ_LO(c->na12) +
+          (int32_t)BQ_HI(st->y) * BQ_HI(c->na12);
+    y = bq_sat16((acc + BQ_Q15_ROUND) >> BQ_Q15_FRAC);
+
+    st->x = (int32_t)(((uint32_t)st->x << 16) | (uint16_t)x);
+    st->y = (int32_t)(((uint32_t)st->y << 16) | (uint16_t)y);
+
+    return y;
+}
+
+//
+// bq_step_q31 - One Q31 section, one sample
+//
+static int32_t bq_step_q31(const BqQ31Coef *c, BqQ31State *st, int32_t x)
+{
+    int64_t acc;
+    int32_t y;
+
+    acc = (int64_t)c->b0 * x +
+          (int64_t)c->b1 * st->x1 +
+          (int64_t)c->b2 * st->x2 +
+          (int64_t)c->na1 * st->y1 +
+          (int64_t)c->na2 * st->y2;
+    y = bq_sat32((acc + BQ_Q31_ROUND) >> BQ_Q31_FRAC);
+
+    st->x2 = st->x1;
+    st->x1 = x;
+    st->y2 = st->y1;
+    st->y1 = y;
+
+    return y;
+}
+
+//
+// bq_sat16 - Clamp to int16
+//
+static int16_t bq_sat16(int32_t v)
+{
+    if(v > 32767L)
+    {
+        return 32767;
+    }
+    if(v < -32768L)
+    {
+        return -32768;
+    }
+    return (int16_t)v;
+}
+
+//
+// bq_sat32 - Clamp to int32
+//
+static int32_t bq_sat32(int64_t v)
+{
+    if(v > 2147483647LL)
+    {
+        return 2147483647L;
+    }
+    if(v < -2147483647LL - 1LL)
+    {
+        return -2147483647L - 1L;
+    }
+    return (int32_t)v;
+}
+
+//
+// bq_bench_fill - Stimulus: 12-bit noise from a 16-bit Galois LFSR (taps
+// 0xB400), as ADC counts from mid-scale scaled to the data format
+//
+static void bq_bench_fill(uint16_t q31)
+{
+    uint16_t i, lfsr = BQ_BENCH_SEED;
+    int16_t d;
+
+    for(i = 0; i < BQ_BENCH_SAMPLES; i++)
+    {
+        lfsr = (lfsr >> 1) ^ ((lfsr & 1U) ? 0xB400U : 0U);
+        d = (int16_t)(lfsr & 0x0FFFU) - 2048;
+        if(q31)
+        {
+            bq_benchBuf.q31[i] = (int32_t)d * (1L << BQ_Q31_IN_SHIFT);
+        }
+        else
+        {
+            bq_benchBuf.q15[i] = (int16_t)(d * (1 << BQ_Q15_IN_SHIFT));
+        }
+    }
+}
+
+//
+// End of File
+//
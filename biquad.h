@@ -0,0 +1,163 @@
+//#############################################################################
+//
+// FILE: biquad.h
+//
+// TITLE: Fixed-point cascaded biquad filter banks, Q15 and Q31
+//
+// DESCRIPTION:
+// A bank is a cascade of second-order sections (direct form I) with const
+// coefficients designed on the host by tools/bq_design.py, which writes
+// bq_coefs.c/.h. Each section computes
+//
+//     y = (b0 x + b1 x1 + b2 x2 + na1 y1 + na2 y2 + round) >> frac
+//
+// with na1 = -a1, na2 = -a2, and saturates y to the data width:
+//
+//     Q15  data int16, coefficients Q14 (|c| < 2), int32 accumulator,
+//          frac 14. The pairs (b1, b2) and (na1, na2) and the states
+//          (x1, x2), (y1, y2) are packed in 32-bit words, low word first,
+//          so the block kernel does the four delayed products with two
+//          dual 16x16 MACs (__dmac); the per-sample path and the host
+//          build use the same integer sums in C
+//     Q31  data int32, coefficients Q30, int64 accumulator, frac 30; for
+//          poles close to the unit circle (a 50 Hz notch at 96 kHz),
+//          where Q14 coefficients are too coarse
+//
+// Inputs are ADC counts from mid-scale shifted by BQ_Q15_IN_SHIFT or
+// BQ_Q31_IN_SHIFT, 12 dB below full scale. For such inputs bq_design.py
+// bounds every accumulator from the peak gain of the cascade and refuses
+// a table that could overflow, so the results are the same integers on
+// the host model and on the target, whatever the order of the additions.
+//
+// bq_sample_*() filter one sample through all sections; bq_block_*()
+// filter a buffer in place one section at a time, which keeps a section's
+// coefficients in registers. The coefficient tables are .const (flash in
+// the CPU1_FLASH build): an ISR calling a bank while the flash log
+// programs would stall, so banks run in the background on the sample
+// stores, or the caller copies the tables to RAM.
+//
+// bq_bench() runs every bank of bq_coefs.h over the stimulus of
+// bq_design.py at start-up, keeps the cycles per sample per section of
+// the block and per-sample paths in bq_benchStat[], and compares the
+// output checksum with the host model (bq_benchMismatch = 0 when bit
+// exact). tests/test_biquad.c runs it on the host build, compares the
+// two paths on blocks of uneven length and checks that bq_coefs.c/.h are
+// what bq_design.py writes (make -C tests).
+//
+//#############################################################################
+
+#ifndef _biquad_h
+#define _biquad_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define BQ_Q15_FRAC             14U
+#define BQ_Q31_FRAC             30U
+#define BQ_Q15_IN_SHIFT         2U          // ADC counts to Q15 data
+#define BQ_Q31_IN_SHIFT         18U         // ADC counts to Q31 data
+#define BQ_Q15_IN_MAX           (2048L << BQ_Q15_IN_SHIFT)
+#define BQ_Q31_IN_MAX           (2048L << BQ_Q31_IN_SHIFT)
+
+//
+// Two int16 in one 32-bit word, lo at the lower address
+//
+#define BQ_PAIR(lo, hi)         ((int32_t)(((uint32_t)(uint16_t)(hi) << 16) | \
+                                           (uint16_t)(lo)))
+#define BQ_LO(p)                ((int16_t)(p))
+#define BQ_HI(p)                ((int16_t)((uint32_t)(p) >> 16))
+
+#define BQ_MAX_SECTIONS         4U          // Longest cascade in bq_coefs.h
+#define BQ_BENCH_SAMPLES        128U
+#define BQ_BENCH_SEED           0xACE1U     // Stimulus LFSR, as bq_design.py
+
+typedef struct
+{
+    int32_t b12;            // BQ_PAIR(b1, b2), Q14
+    int32_t na12;           // BQ_PAIR(-a1, -a2), Q14
+    int16_t b0;             // Q14
+    int16_t rsvd;
+} BqQ15Coef;
+
+typedef struct
+{
+    int32_t x;              // BQ_PAIR(x1, x2)
+    int32_t y;              // BQ_PAIR(y1, y2)
+} BqQ15State;
+
+typedef struct
+{
+    int32_t b0;             // Q30
+    int32_t b1;
+    int32_t b2;
+    int32_t na1;            // -a1
+    int32_t na2;            // -a2
+    int32_t rsvd;
+} BqQ31Coef;
+
+typedef struct
+{
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+} BqQ31State;
+
+typedef struct
+{
+    const BqQ15Coef *coef;
+    BqQ15State *state;
+    uint16_t sections;
+} BqQ15Bank;
+
+typedef struct
+{
+    const BqQ31Coef *coef;
+    BqQ31State *state;
+    uint16_t sections;
+} BqQ31Bank;
+
+//
+// One table of bq_coefs.c, for bq_bench()
+//
+typedef struct
+{
+    const void *coef;       // BqQ15Coef or BqQ31Coef
+    uint16_t sections;
+    uint16_t q31;           // 1: Q31 table
+    uint32_t check;         // Output checksum of the host model
+} BqBankDesc;
+
+typedef struct
+{
+    uint32_t blockCycles;   // Per sample per section
+    uint32_t sampleCycles;
+    uint32_t checksum;      // Of the block path output
+    uint16_t match;         // Block and per-sample paths equal the host
+    uint16_t rsvd;
+} BqBenchStat;
+
+//
+// Globals
+//
+extern BqBenchStat bq_benchStat[];          // One per bq_banks[] entry
+extern uint16_t bq_benchMismatch;           // Tables that differ from host
+
+//
+// Function Prototypes
+//
+void bq_init_q15(BqQ15Bank *bank, const BqQ15Coef *coef, BqQ15State *state,
+                 uint16_t sections);
+void bq_init_q31(BqQ31Bank *bank, const BqQ31Coef *coef, BqQ31State *state,
+                 uint16_t sections);
+void bq_reset_q15(BqQ15Bank *bank);
+void bq_reset_q31(BqQ31Bank *bank);
+int16_t bq_sample_q15(BqQ15Bank *bank, int16_t x);
+int32_t bq_sample_q31(BqQ31Bank *bank, int32_t x);
+void bq_block_q15(BqQ15Bank *bank, int16_t *data, uint16_t n);
+void bq_block_q31(BqQ31Bank *bank, int32_t *data, uint16_t n);
+void bq_bench(void);
+
+#endif
@@ -0,0 +1,82 @@
+//#############################################################################
+//
+// FILE: boot.c
+//
+// TITLE: Boot sequence phase timestamps
+//
+// DESCRIPTION:
+// Phase stamps on the CPU Timer 2 cycle counter and the wait for the
+// analog power-up started earlier in the sequence.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "boot.h"
+#include "bench.h"
+
+//
+// Globals
+//
+uint32_t boot_stamp[BOOT_NUM_PHASES];
+uint32_t boot_waitCycles;
+uint32_t boot_firstDecisionUs;
+uint16_t boot_done;
+
+static uint32_t boot_t0;
+
+//
+// boot_begin - Reference point of the stamps. Call after bench_init().
+//
+void boot_begin(void)
+{
+    uint16_t i;
+
+    boot_t0 = BENCH_NOW();
+
+    for(i = 0; i < BOOT_NUM_PHASES; i++)
+    {
+        boot_stamp[i] = 0;
+    }
+    boot_waitCycles = 0;
+    boot_firstDecisionUs = 0;
+    boot_done = 0;
+}
+
+//
+// boot_mark - Stamp the end of a phase
+//
+void boot_mark(uint16_t phase)
+{
+    boot_stamp[phase] = boot_t0 - BENCH_NOW();
+
+    if(BOOT_PH_FIRST_DECISION == phase)
+    {
+        boot_firstDecisionUs = boot_stamp[phase] / BOOT_CYCLES_PER_US;
+        boot_done = 1;
+    }
+}
+
+//
+// boot_wait_since - Wait until us microseconds have passed since a phase
+// was stamped. Returns at once when the overlapped work took longer.
+//
+void boot_wait_since(uint16_t phase, uint32_t us)
+{
+    uint32_t until = boot_stamp[phase] + us * BOOT_CYCLES_PER_US;
+    uint32_t start = boot_t0 - BENCH_NOW();
+    uint32_t now = start;
+
+    while(now < until)
+    {
+        now = boot_t0 - BENCH_NOW();
+    }
+
+    boot_waitCycles = now - start;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,69 @@
+//#############################################################################
+//
+// FILE: boot.h
+//
+// TITLE: Boot sequence phase timestamps
+//
+// DESCRIPTION:
+// main() starts the slow analog power-ups (ADC core, temperature sensor)
+// right after InitSysCtrl() and tb_init(), and loads the log and the
+// parameters from flash and does the GPIO, PIE, ePWM and software set-up
+// while they settle. boot_wait_since() then only waits for what is left
+// of the power-up time before the first conversion is triggered.
+//
+// The start-up benchmarks (bench_run_kernels(), env_bench(), bq_bench())
+// delay the first CP decision by their run time and are only built with
+// BOOT_BENCH=1; they then run after the peripheral set-up, with CP
+// already driven.
+//
+// boot_mark() stamps each phase in SYSCLK cycles since boot_begin(), which
+// runs right after InitSysCtrl() and bench_init(); the time spent in the
+// boot ROM, C start-up and InitSysCtrl() (PLL lock) is not included.
+// boot_stamp[BOOT_PH_FIRST_DECISION] is the time to the first CP decision:
+// the first CP period classified into its plateau levels (cp_hist.h).
+//
+//#############################################################################
+
+#ifndef _boot_h
+#define _boot_h
+
+#include <stdint.h>
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define BOOT_PH_BEGIN           0   // InitSysCtrl() done, cycle counter on
+#define BOOT_PH_ANALOG_START    1   // ADC and temperature sensor powering up
+#define BOOT_PH_BENCH           2   // Start-up benchmark done, BOOT_BENCH
+#define BOOT_PH_GPIO            3   // Pins muxed, CP at 9 V
+#define BOOT_PH_PIE             4   // PIE and vectors ready
+#define BOOT_PH_PERIPH          5   // ePWM, SOCs, buffers, recorder set up
+#define BOOT_PH_ANALOG_READY    6   // Analog power-up time elapsed
+#define BOOT_PH_RUN             7   // Conversions triggered, watchdog on
+#define BOOT_PH_FIRST_DECISION  8   // First CP period classified
+#define BOOT_NUM_PHASES         9
+
+#ifndef BOOT_BENCH
+#define BOOT_BENCH              0
+#endif
+
+#define BOOT_ADC_POWERUP_US     1000U   // ADC and temperature sensor
+#define BOOT_CYCLES_PER_US      SYSCLK_MHZ
+
+//
+// Globals
+//
+extern uint32_t boot_stamp[BOOT_NUM_PHASES];    // Cycles since boot_begin()
+extern uint32_t boot_waitCycles;                // Spent in boot_wait_since()
+extern uint32_t boot_firstDecisionUs;
+extern uint16_t boot_done;
+
+//
+// Function Prototypes
+//
+void boot_begin(void);
+void boot_mark(uint16_t phase);
+void boot_wait_since(uint16_t phase, uint32_t us);
+
+#endif
@@ -0,0 +1,58 @@
+//#############################################################################
+//
+// FILE: bq_coefs.c
+//
+// TITLE: Biquad coefficient tables
+//
+// DESCRIPTION:
+// Generated by tools/bq_design.py for a sample rate of 95846.6 Hz - do not
+// edit, change the script and run it again. Each table has its section
+// count and the output checksum of the host model on the bq_bench()
+// stimulus (see biquad.h).
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "bq_coefs.h"
+
+//
+// Globals
+//
+
+//
+// CP anti-alias/smoothing, 4th order Butterworth 10 kHz
+//
+const BqQ15Coef bq_cpLowpass[BQ_CP_LOWPASS_SECTIONS] =
+{
+    { BQ_PAIR(2173, 1086), BQ_PAIR(16617, -4578), 1086, 0 },
+    { BQ_PAIR(2754, 1377), BQ_PAIR(21062, -10186), 1377, 0 }
+};
+
+//
+// CP mains hum notch, 50 Hz, Q 2
+//
+const BqQ31Coef bq_cpNotch[BQ_CP_NOTCH_SECTIONS] =
+{
+    { 1072862687L, -2145713849L, 1072862687L, 2145713849L, -1071983551L, 0L }
+};
+
+//
+// 500 VAC low-pass, 2nd order Butterworth 2 kHz
+//
+const BqQ15Coef bq_mainsLowpass[BQ_MAINS_LOWPASS_SECTIONS] =
+{
+    { BQ_PAIR(129, 64), BQ_PAIR(29738, -13611), 64, 0 }
+};
+
+const BqBankDesc bq_banks[BQ_NUM_BANKS] =
+{
+    { bq_cpLowpass, BQ_CP_LOWPASS_SECTIONS, 0U, BQ_CP_LOWPASS_CHECK },
+    { bq_cpNotch, BQ_CP_NOTCH_SECTIONS, 1U, BQ_CP_NOTCH_CHECK },
+    { bq_mainsLowpass, BQ_MAINS_LOWPASS_SECTIONS, 0U, BQ_MAINS_LOWPASS_CHECK }
+};
+
+//
+// End of File
+//
@@ -0,0 +1,39 @@
+//#############################################################################
+//
+// FILE: bq_coefs.h
+//
+// TITLE: Biquad coefficient tables
+//
+// DESCRIPTION:
+// Generated by tools/bq_design.py for a sample rate of 95846.6 Hz - do not
+// edit, change the script and run it again. Each table has its section
+// count and the output checksum of the host model on the bq_bench()
+// stimulus (see biquad.h).
+//
+//#############################################################################
+
+#ifndef _bq_coefs_h
+#define _bq_coefs_h
+
+#include "biquad.h"
+
+//
+// Defines
+//
+#define BQ_CP_LOWPASS_SECTIONS          2U
+#define BQ_CP_LOWPASS_CHECK             0xB3D1CDE2UL
+#define BQ_CP_NOTCH_SECTIONS            1U
+#define BQ_CP_NOTCH_CHECK               0x726461CAUL
+#define BQ_MAINS_LOWPASS_SECTIONS       1U
+#define BQ_MAINS_LOWPASS_CHECK          0xE5EA1D88UL
+#define BQ_NUM_BANKS                    3U
+
+//
+// Globals
+//
+extern const BqQ15Coef bq_cpLowpass[BQ_CP_LOWPASS_SECTIONS];
+extern const BqQ31Coef bq_cpNotch[BQ_CP_NOTCH_SECTIONS];
+extern const BqQ15Coef bq_mainsLowpass[BQ_MAINS_LOWPASS_SECTIONS];
+extern const BqBankDesc bq_banks[BQ_NUM_BANKS];
+
+#endif
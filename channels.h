@@ -0,0 +1,24 @@
+//#############################################################################
+//
+// FILE: channels.h
+//
+// TITLE: Acquisition channel numbering
+//
+// DESCRIPTION:
+// Index of each sampled signal in the per-channel tables of the
+// acquisition modules (flight recorder, calibration, ...).
+//
+//#############################################################################
+
+#ifndef _channels_h
+#define _channels_h
+
+//
+// Defines
+//
+#define CH_IN_ADC_500VAC    0       // A3  - SOC0 - ePWM1 - adcA1ISR
+#define CH_IN_CP_ADC        1       // A2  - SOC1 - ePWM2 - adcA2ISR
+#define CH_IN_CP_BORNE      2       // A11 - SOC2 - ePWM4 - adcA3ISR
+#define NUM_CHANNELS        3
+
+#endif
@@ -0,0 +1,319 @@
+//#############################################################################
+//
+// FILE: cp_cable.c
+//
+// TITLE: Cable-side versus station-side CP comparison
+//
+// DESCRIPTION:
+// Background half of the analyser: plateau levels in mV, amplitude ratio,
+// interpolated edge delay and the fault classification.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "cp_cable.h"
+#include "adc_cal.h"
+#include "channels.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define CPC_TBCLK_NS_NUM        1000UL      // TBCLK ticks to ns
+#define CPC_TBCLK_NS_DEN        TBCLK_MHZ
+#define CPC_MIN_SEP_COUNTS      (4 * CP_ADC_HYSTERESIS)
+
+//
+// Globals
+//
+CpcAcc cpc_acc;
+CpcPeriod cpc_period;
+volatile uint16_t cpc_periodReady;
+uint32_t cpc_dropped;
+CpcResult cpc;
+
+static uint32_t cpc_sampleNs;
+static uint16_t cpc_badRun[CPC_NUM_FAULTS];
+static uint16_t cpc_goodRun[CPC_NUM_FAULTS];
+
+static const uint16_t cpc_channel[CPC_NUM_SIDES] =
+{
+    CH_IN_CP_ADC, CH_IN_CP_BORNE
+};
+
+//
+// Function Prototypes
+//
+static uint16_t cpc_classify(const CpcPeriod *p);
+static void cpc_persist(uint16_t bad);
+static int32_t cpc_mean_mv(uint16_t side, uint32_t sum, uint16_t n);
+static int32_t cpc_frac_q8(uint16_t prev, uint16_t cur, int16_t threshold);
+static int32_t cpc_abs(int32_t v);
+
+//
+// cpc_init - Clear the analyser. samplePeriodTicks is the ePWM4 period in
+// TBCLK ticks. Call before adcA3ISR is enabled, and again with the ISR
+// stopped when the sample period changes.
+//
+void cpc_init(uint16_t samplePeriodTicks)
+{
+    uint16_t s;
+
+    cpc_sampleNs = ((uint32_t)samplePeriodTicks * CPC_TBCLK_NS_NUM) /
+                   CPC_TBCLK_NS_DEN;
+
+    for(s = 0; s < CPC_NUM_SIDES; s++)
+    {
+        cpc_acc.threshold[s] = CP_ADC_THRESHOLD;
+        cpc_acc.level[s] = 0;
+        cpc_acc.last[s] = 0;
+        cpc_acc.since[s] = 0;
+        cpc_acc.sinceRise[s] = 0xFFFFU;
+        cpc_acc.risePrev[s] = 0;
+        cpc_acc.riseCur[s] = 0;
+    }
+    cpc_acc.synced = 0;
+    cpc_restart(&cpc_acc);
+    cpc_periodReady = 0;
+
+    for(s = 0; s < CPC_NUM_FAULTS; s++)
+    {
+        cpc_badRun[s] = 0;
+        cpc_goodRun[s] = 0;
+    }
+    cpc.faults = 0;
+    cpc.pwm = 0;
+    cpc.periods = 0;
+}
+
+//
+// cpc_poll - Background task: evaluate the last period. Returns 1 when a
+// period was evaluated.
+//
+uint16_t cpc_poll(void)
+{
+    CpcPeriod p;
+    uint16_t intState;
+
+    if(!cpc_periodReady)
+    {
+        return 0;
+    }
+
+    intState = __disable_interrupts();
+    p = cpc_period;
+    cpc_periodReady = 0;
+    __restore_interrupts(intState);
+
+    cpc.periods++;
+    cpc_persist(cpc_classify(&p));
+
+    return 1;
+}
+
+//
+// cpc_classify - Levels, ratio and delay of one period, and the faults it
+// shows. Also moves the edge thresholds to the plateau midpoints.
+//
+static uint16_t cpc_classify(const CpcPeriod *p)
+{
+    int32_t ampCable, ampStation, ratio, delayQ8, meanHigh, meanLow;
+    uint16_t s, bad = 0;
+
+    cpc.pwm = (0U != p->samples) && (0U != p->nHigh) && (0U != p->nLow);
+
+    if(!cpc.pwm)
+    {
+        //
+        // DC level: only the plateau the station is at
+        //
+        for(s = 0; s < CPC_NUM_SIDES; s++)
+        {
+            cpc.highMv[s] = (0U != p->nHigh) ?
+                            cpc_mean_mv(s, p->sumHigh[s], p->nHigh) :
+                            cpc_mean_mv(s, p->sumLow[s], p->nLow);
+            cpc.lowMv[s] = cpc.highMv[s];
+        }
+        cpc.diffHighMv = cpc.highMv[CPC_CABLE] - cpc.highMv[CPC_STATION];
+        cpc.diffLowMv = cpc.diffHighMv;
+        cpc.offsetMv = cpc.diffHighMv;
+        cpc.ratioPm = 0;
+        cpc.delayNs = 0;
+
+        if((0U == p->nHigh) && (0U == p->nLow))
+        {
+            return 0;                       // Nothing settled
+        }
+        if(cpc_abs(cpc.offsetMv) > CPC_WIRE_DIFF_MV)
+        {
+            bad |= CPC_FAULT_WIRE;
+        }
+        else if(cpc_abs(cpc.offsetMv) > CPC_GND_OFFSET_MV)
+        {
+            bad |= CPC_FAULT_GROUND;
+        }
+        return bad;
+    }
+
+    for(s = 0; s < CPC_NUM_SIDES; s++)
+    {
+        cpc.highMv[s] = cpc_mean_mv(s, p->sumHigh[s], p->nHigh);
+        cpc.lowMv[s] = cpc_mean_mv(s, p->sumLow[s], p->nLow);
+
+        meanHigh = (int32_t)((p->sumHigh[s] + p->nHigh / 2U) / p->nHigh);
+        meanLow = (int32_t)((p->sumLow[s] + p->nLow / 2U) / p->nLow);
+        if(cpc_abs(meanHigh - meanLow) >= CPC_MIN_SEP_COUNTS)
+        {
+            cpc_acc.threshold[s] = (int16_t)((meanHigh + meanLow) / 2);
+        }
+    }
+
+    cpc.diffHighMv = cpc.highMv[CPC_CABLE] - cpc.highMv[CPC_STATION];
+    cpc.diffLowMv = cpc.lowMv[CPC_CABLE] - cpc.lowMv[CPC_STATION];
+    cpc.offsetMv = (cpc.diffHighMv + cpc.diffLowMv) / 2;
+
+    ampCable = cpc.highMv[CPC_CABLE] - cpc.lowMv[CPC_CABLE];
+    ampStation = cpc.highMv[CPC_STATION] - cpc.lowMv[CPC_STATION];
+    if(ampStation < CPC_MIN_AMP_MV)
+    {
+        cpc.ratioPm = 0;
+        cpc.delayNs = 0;
+        return 0;                           // Too small to compare
+    }
+
+    ratio = (ampCable * 1000L) / ampStation;
+    cpc.ratioPm = (int16_t)((ratio > 32767L) ? 32767L :
+                            ((ratio < -32767L) ? -32767L : ratio));
+
+    if(CPC_NO_EDGE != p->delay)
+    {
+        delayQ8 = (int32_t)p->delay * 256L -
+                  cpc_frac_q8(p->edgePrev[CPC_CABLE], p->edgeCur[CPC_CABLE],
+                              p->threshold[CPC_CABLE]) +
+                  cpc_frac_q8(p->edgePrev[CPC_STATION],
+                              p->edgeCur[CPC_STATION],
+                              p->threshold[CPC_STATION]);
+        cpc.delayNs = (int32_t)(((int64_t)delayQ8 * (int32_t)cpc_sampleNs) /
+                                256);
+    }
+    else
+    {
+        cpc.delayNs = 0;
+    }
+
+    if((0U == p->cableEdges) || (cpc_abs(ratio) < CPC_WIRE_RATIO_PM))
+    {
+        bad |= CPC_FAULT_WIRE;
+    }
+    else if((ratio < CPC_RATIO_MIN_PM) || (ratio > CPC_RATIO_MAX_PM) ||
+            (CPC_NO_EDGE == p->delay) ||
+            (cpc_abs(cpc.delayNs) >
+             (int32_t)(CPC_MAX_DELAY_SAMPLES * cpc_sampleNs)))
+    {
+        bad |= CPC_FAULT_MISWIRED;
+    }
+    else if(cpc_abs(cpc.offsetMv) > CPC_GND_OFFSET_MV)
+    {
+        bad |= CPC_FAULT_GROUND;
+    }
+
+    return bad;
+}
+
+//
+// cpc_persist - Set a fault after CPC_PERSIST bad periods in a row, clear
+// it after CPC_PERSIST good ones
+//
+static void cpc_persist(uint16_t bad)
+{
+    uint16_t k, bit;
+
+    for(k = 0; k < CPC_NUM_FAULTS; k++)
+    {
+        bit = 1U << k;
+        if(bad & bit)
+        {
+            cpc_goodRun[k] = 0;
+            if(cpc_badRun[k] < CPC_PERSIST)
+            {
+                cpc_badRun[k]++;
+            }
+            if((CPC_PERSIST == cpc_badRun[k]) && !(cpc.faults & bit))
+            {
+                cpc.faults |= bit;
+                cpc.faultEvents++;
+            }
+        }
+        else
+        {
+            cpc_badRun[k] = 0;
+            if(cpc_goodRun[k] < CPC_PERSIST)
+            {
+                cpc_goodRun[k]++;
+            }
+            if(CPC_PERSIST == cpc_goodRun[k])
+            {
+                cpc.faults &= ~bit;
+            }
+        }
+    }
+}
+
+//
+// cpc_mean_mv - Mean of n samples of one side in mV, through the Q4 mean
+// and the channel calibration
+//
+static int32_t cpc_mean_mv(uint16_t side, uint32_t sum, uint16_t n)
+{
+    const AdcCal *cal = &adc_cal[cpc_channel[side]];
+    int32_t q4;
+
+    if(0U == n)
+    {
+        return 0;
+    }
+
+    q4 = (int32_t)((ADC_CAL_Q4(sum) + n / 2U) / n);
+    return (int32_t)(((int64_t)(q4 - cal->offset) * cal->gain) >>
+                     (cal->shift + 4U));
+}
+
+//
+// cpc_frac_q8 - Where the threshold was crossed between the two samples of
+// a rising edge, as the fraction of the sample period before the second
+// one, Q8
+//
+static int32_t cpc_frac_q8(uint16_t prev, uint16_t cur, int16_t threshold)
+{
+    int32_t span = (int32_t)cur - (int32_t)prev;
+    int32_t above = (int32_t)cur - threshold;
+
+    if(span <= 0)
+    {
+        return 0;
+    }
+    if(above <= 0)
+    {
+        return 0;
+    }
+    if(above >= span)
+    {
+        return 256;
+    }
+    return (above * 256L) / span;
+}
+
+//
+// cpc_abs - |v|
+//
+static int32_t cpc_abs(int32_t v)
+{
+    return (v < 0) ? -v : v;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,324 @@
+//#############################################################################
+//
+// FILE: cp_cable.h
+//
+// TITLE: Cable-side versus station-side CP comparison
+//
+// DESCRIPTION:
+// IN_CP_BORNE sees the CP at the station connector, IN_CP_ADC the same
+// signal at the cable end. The analyser relates the two per CP period:
+//
+//     plateaus  mean high and low level of each side, and the cable minus
+//               station differences (mV)
+//     ratio     cable / station amplitude (high - low), 0.1 %; negative
+//               when the cable side is inverted
+//     delay     cable rising edge after the station rising edge (ns)
+//
+// and flags, after CPC_PERSIST periods in a row,
+//
+//     CPC_FAULT_WIRE      the station shows the PWM but the cable side has
+//                         no edges or less than CPC_WIRE_RATIO_PM of its
+//                         amplitude (broken CP wire), or at a DC level the
+//                         sides differ by CPC_WIRE_DIFF_MV
+//     CPC_FAULT_GROUND    same amplitude but both plateaus shifted by more
+//                         than CPC_GND_OFFSET_MV (ground resistance lifts
+//                         the cable-side reference)
+//     CPC_FAULT_MISWIRED  inverted or scaled amplitude (ratio outside
+//                         CPC_RATIO_MIN_PM..CPC_RATIO_MAX_PM) or an edge
+//                         delay above CPC_MAX_DELAY_SAMPLES (wrong or
+//                         miswired level adapter)
+//
+// SOC1 (IN_CP_ADC) and SOC2 (IN_CP_BORNE) are triggered by ePWM2 and ePWM4
+// with the same period and SOC position and convert back to back, so
+// adcA3ISR finds the cable sample of the same period in ADCRESULT1 and
+// passes both to cpc_push() as one time-aligned pair; the pair does not
+// depend on adcA2ISR being serviced in time.
+//
+// The ISR half classifies the samples by the station level, skipping
+// CPC_SETTLE samples after an edge of either side, sums the plateaus and
+// notes the rising edges; at each station rising edge (or after
+// CPC_MAX_SAMPLES at a DC level) it hands the period to cpc_poll(). The
+// background converts to mV with adc_cal[], interpolates the edge
+// crossings between the two samples around each edge (the edge delay is
+// then resolved well below the 10.4 us sample period when the front-end
+// filter spreads the edge over a few samples), moves each side's edge
+// threshold to the midpoint of its plateaus and classifies. Periods that
+// arrive while the last one is unread are dropped and counted.
+//
+//#############################################################################
+
+#ifndef _cp_cable_h
+#define _cp_cable_h
+
+#include <stdint.h>
+#include "cp_meas.h"
+
+//
+// Defines
+//
+#define CPC_CABLE               0U          // IN_CP_ADC
+#define CPC_STATION             1U          // IN_CP_BORNE
+#define CPC_NUM_SIDES           2U
+
+#define CPC_SETTLE              3U          // Samples skipped after an edge
+#define CPC_EDGE_WINDOW         8U          // Pair edges closer than this
+#define CPC_MAX_SAMPLES         CP_ADC_MAX_SAMPLES
+#define CPC_NO_EDGE             0x7FFF
+
+#define CPC_PERSIST             8U          // Periods to set / clear a fault
+#define CPC_MIN_AMP_MV          6000L       // Station amplitude to compare
+#define CPC_RATIO_MIN_PM        850
+#define CPC_RATIO_MAX_PM        1150
+#define CPC_GND_OFFSET_MV       600L
+#define CPC_WIRE_DIFF_MV        3000L
+#define CPC_WIRE_RATIO_PM       250         // Below: no cable amplitude
+#define CPC_MAX_DELAY_SAMPLES   2U
+
+#define CPC_FAULT_WIRE          0x0001U
+#define CPC_FAULT_GROUND        0x0002U
+#define CPC_FAULT_MISWIRED      0x0004U
+#define CPC_NUM_FAULTS          3U
+
+//
+// One period, filled by adcA3ISR
+//
+typedef struct
+{
+    uint32_t sumHigh[CPC_NUM_SIDES];        // Counts, station level high
+    uint32_t sumLow[CPC_NUM_SIDES];
+    uint16_t nHigh;                         // Samples in each sum
+    uint16_t nLow;
+    uint16_t samples;                       // Period length, 0: DC level
+    uint16_t cableEdges;                    // Cable rising edges
+    int16_t delay;                          // Samples, CPC_NO_EDGE: none
+    uint16_t edgePrev[CPC_NUM_SIDES];       // Samples around the rising
+    uint16_t edgeCur[CPC_NUM_SIDES];        // edges paired in delay
+    int16_t threshold[CPC_NUM_SIDES];       // Edge thresholds in use
+} CpcPeriod;
+
+//
+// ISR state, owned by adcA3ISR
+//
+typedef struct
+{
+    CpcPeriod cur;
+    int16_t threshold[CPC_NUM_SIDES];       // Counts, set by cpc_poll()
+    uint16_t level[CPC_NUM_SIDES];          // 1: above threshold + hysteresis
+    uint16_t last[CPC_NUM_SIDES];           // Previous sample
+    uint16_t since[CPC_NUM_SIDES];          // Samples since the last edge
+    uint16_t sinceRise[CPC_NUM_SIDES];      // Samples since the last rising
+    uint16_t risePrev[CPC_NUM_SIDES];       // Samples around it
+    uint16_t riseCur[CPC_NUM_SIDES];
+    uint16_t synced;                        // A station rising edge was seen
+} CpcAcc;
+
+typedef struct
+{
+    int32_t highMv[CPC_NUM_SIDES];
+    int32_t lowMv[CPC_NUM_SIDES];
+    int32_t diffHighMv;                     // Cable - station
+    int32_t diffLowMv;
+    int32_t offsetMv;                       // Mean of the two differences
+    int32_t delayNs;                        // Cable edge after station edge
+    int16_t ratioPm;                        // Cable / station amplitude
+    uint16_t pwm;                           // 0: DC level, one plateau
+    uint16_t faults;                        // CPC_FAULT_*
+    uint16_t faultEvents;                   // Fault onsets
+    uint32_t periods;
+} CpcResult;
+
+//
+// Globals
+//
+extern CpcAcc cpc_acc;
+extern CpcPeriod cpc_period;
+extern volatile uint16_t cpc_periodReady;
+extern uint32_t cpc_dropped;               // Periods not read in time
+extern CpcResult cpc;
+
+//
+// Function Prototypes
+//
+void cpc_init(uint16_t samplePeriodTicks);
+uint16_t cpc_poll(void);
+
+//
+// cpc_edge - Follow one side with hysteresis around its threshold.
+// Returns 1 on a rising edge.
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_edge)
+static inline uint16_t cpc_edge(CpcAcc *acc, uint16_t side, uint16_t sample)
+{
+    int16_t d = (int16_t)sample - acc->threshold[side];
+    uint16_t rise = 0;
+
+    if(acc->since[side] < 0xFFFFU)
+    {
+        acc->since[side]++;
+    }
+    if(acc->sinceRise[side] < 0xFFFFU)
+    {
+        acc->sinceRise[side]++;
+    }
+
+    if(acc->level[side])
+    {
+        if(d < -CP_ADC_HYSTERESIS)
+        {
+            acc->level[side] = 0;
+            acc->since[side] = 0;
+        }
+    }
+    else if(d > CP_ADC_HYSTERESIS)
+    {
+        acc->level[side] = 1;
+        acc->since[side] = 0;
+        acc->sinceRise[side] = 0;
+        acc->risePrev[side] = acc->last[side];
+        acc->riseCur[side] = sample;
+        rise = 1;
+    }
+
+    acc->last[side] = sample;
+    return rise;
+}
+
+//
+// cpc_pair - Note the delay of a cable/station rising edge pair
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_pair)
+static inline void cpc_pair(CpcAcc *acc, int16_t delay)
+{
+    uint16_t s;
+
+    acc->cur.delay = delay;
+    for(s = 0; s < CPC_NUM_SIDES; s++)
+    {
+        acc->cur.edgePrev[s] = acc->risePrev[s];
+        acc->cur.edgeCur[s] = acc->riseCur[s];
+    }
+}
+
+//
+// cpc_restart - Start an empty period
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_restart)
+static inline void cpc_restart(CpcAcc *acc)
+{
+    uint16_t s;
+
+    for(s = 0; s < CPC_NUM_SIDES; s++)
+    {
+        acc->cur.sumHigh[s] = 0;
+        acc->cur.sumLow[s] = 0;
+    }
+    acc->cur.nHigh = 0;
+    acc->cur.nLow = 0;
+    acc->cur.samples = 0;
+    acc->cur.cableEdges = 0;
+    acc->cur.delay = CPC_NO_EDGE;
+}
+
+//
+// cpc_handover - End the period: pass it to the background and start the
+// next one
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_handover)
+static inline void cpc_handover(CpcAcc *acc, uint16_t samples)
+{
+    acc->cur.samples = samples;
+    if(cpc_periodReady)
+    {
+        cpc_dropped++;
+    }
+    else
+    {
+        acc->cur.threshold[CPC_CABLE] = acc->threshold[CPC_CABLE];
+        acc->cur.threshold[CPC_STATION] = acc->threshold[CPC_STATION];
+        cpc_period = acc->cur;
+        cpc_periodReady = 1;
+    }
+    cpc_restart(acc);
+}
+
+//
+// cpc_push - Account one time-aligned pair of CP samples
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_push)
+static inline void cpc_push(uint16_t cable, uint16_t station)
+{
+    CpcAcc *acc = &cpc_acc;
+    uint16_t riseCable = cpc_edge(acc, CPC_CABLE, cable);
+    uint16_t riseStation = cpc_edge(acc, CPC_STATION, station);
+
+    acc->cur.samples++;
+
+    if(riseStation)
+    {
+        //
+        // A period ends; a cable edge just before belongs to the new one
+        //
+        if(acc->synced)
+        {
+            cpc_handover(acc, acc->cur.samples);
+        }
+        else
+        {
+            cpc_restart(acc);
+        }
+        acc->synced = 1;
+        if(riseCable)
+        {
+            cpc_pair(acc, 0);
+        }
+        else if(acc->sinceRise[CPC_CABLE] < CPC_EDGE_WINDOW)
+        {
+            cpc_pair(acc, -(int16_t)acc->sinceRise[CPC_CABLE]);
+        }
+    }
+    else if(acc->cur.samples >= CPC_MAX_SAMPLES)
+    {
+        cpc_handover(acc, 0);               // DC level, no PWM
+        acc->synced = 0;
+    }
+    else if(riseCable && (acc->sinceRise[CPC_STATION] < CPC_EDGE_WINDOW))
+    {
+        cpc_pair(acc, (int16_t)acc->sinceRise[CPC_STATION]);
+    }
+
+    if(riseCable)
+    {
+        acc->cur.cableEdges++;
+    }
+
+    if((acc->since[CPC_CABLE] >= CPC_SETTLE) &&
+       (acc->since[CPC_STATION] >= CPC_SETTLE))
+    {
+        if(acc->level[CPC_STATION])
+        {
+            acc->cur.sumHigh[CPC_CABLE] += cable;
+            acc->cur.sumHigh[CPC_STATION] += station;
+            acc->cur.nHigh++;
+        }
+        else
+        {
+            acc->cur.sumLow[CPC_CABLE] += cable;
+            acc->cur.sumLow[CPC_STATION] += station;
+            acc->cur.nLow++;
+        }
+    }
+}
+
+//
+// cpc_gap - Conversions were lost: drop the period in progress
+//
+#pragma FUNC_ALWAYS_INLINE(cpc_gap)
+static inline void cpc_gap(void)
+{
+    cpc_restart(&cpc_acc);
+    cpc_acc.sinceRise[CPC_CABLE] = 0xFFFFU;
+    cpc_acc.sinceRise[CPC_STATION] = 0xFFFFU;
+    cpc_acc.synced = 0;
+}
+
+#endif
@@ -0,0 +1,156 @@
+//#############################################################################
+//
+// FILE: cp_ecap.c
+//
+// TITLE: CP period and duty from eCAP1
+//
+// DESCRIPTION:
+// Pin and X-BAR routing, eCAP1 set-up in continuous delta mode, the
+// per-cycle ISR and the background hand-over to cp_meas.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "cp_ecap.h"
+#include "cp_meas.h"
+#include "irq_nest.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define CP_ECAP_NS_NUM          1000ULL     // SYSCLK ticks to ns
+#define CP_ECAP_NS_DEN          SYSCLK_MHZ
+
+//
+// Globals
+//
+volatile uint32_t cp_ecapLow;
+volatile uint32_t cp_ecapHigh;
+volatile uint16_t cp_ecapReady;
+uint32_t cp_ecapCycles;
+
+static uint16_t cp_ecapSynced;              // First CAP1 is not a low time
+
+//
+// The ISR must not run from flash (see flash_log.h)
+//
+#pragma CODE_SECTION(cp_ecap_isr, "HotIsr");
+
+//
+// cp_ecap_init - Route the pin to eCAP1 and configure the capture. Call
+// after InitPieVectTable(), with interrupts still disabled.
+//
+void cp_ecap_init(void)
+{
+    EALLOW;
+    CpuSysRegs.PCLKCR3.bit.ECAP1 = 1;
+    EDIS;
+
+    GPIO_SetupPinMux(CP_ECAP_GPIO, GPIO_MUX_CPU1, 0);
+    GPIO_SetupPinOptions(CP_ECAP_GPIO, GPIO_INPUT, GPIO_SYNC);
+
+    EALLOW;
+    InputXbarRegs.INPUT7SELECT = CP_ECAP_GPIO;
+
+    ECap1Regs.ECEINT.all = 0;               // No interrupts yet
+    ECap1Regs.ECCLR.all = 0xFFFFU;
+    ECap1Regs.ECCTL2.bit.TSCTRSTOP = 0;     // Counter stopped
+    ECap1Regs.ECCTL1.bit.CAPLDEN = 0;
+
+    ECap1Regs.ECCTL0.bit.INPUTSEL = CP_ECAP_XBAR_INPUT - 1U;
+    ECap1Regs.ECCTL1.bit.PRESCALE = 0;      // Every edge
+    ECap1Regs.ECCTL1.bit.CAP1POL = 0;       // Rising
+    ECap1Regs.ECCTL1.bit.CTRRST1 = 1;       // Delta mode
+    ECap1Regs.ECCTL1.bit.CAP2POL = 1;       // Falling
+    ECap1Regs.ECCTL1.bit.CTRRST2 = 1;
+    ECap1Regs.ECCTL1.bit.FREE_SOFT = 2;     // Run through emulation halts
+
+    ECap1Regs.ECCTL2.bit.CAP_APWM = 0;      // Capture mode
+    ECap1Regs.ECCTL2.bit.CONT_ONESHT = 0;   // Continuous
+    ECap1Regs.ECCTL2.bit.STOP_WRAP = 1;     // Wrap after CEVT2
+    ECap1Regs.ECCTL2.bit.SYNCI_EN = 0;
+
+    PieVectTable.ECAP1_INT = &cp_ecap_isr;
+    EDIS;
+
+    cp_ecapReady = 0;
+    cp_ecapCycles = 0;
+    cp_ecapSynced = 0;
+}
+
+//
+// cp_ecap_start - Start the counter and enable the CEVT2 interrupt
+//
+void cp_ecap_start(void)
+{
+    EALLOW;
+    ECap1Regs.ECCLR.all = 0xFFFFU;
+    ECap1Regs.ECCTL1.bit.CAPLDEN = 1;
+    ECap1Regs.ECCTL2.bit.TSCTRSTOP = 1;
+    ECap1Regs.ECCTL2.bit.REARM = 1;
+    ECap1Regs.ECEINT.bit.CEVT2 = 1;
+    EDIS;
+
+    PieCtrlRegs.PIEIER4.bit.INTx1 = 1;
+    IER |= M_INT4;
+}
+
+//
+// cp_ecap_poll - Background task: report the last captured cycle
+//
+void cp_ecap_poll(void)
+{
+    uint32_t low, high;
+    uint16_t intState;
+
+    if(0 == cp_ecapReady)
+    {
+        return;
+    }
+
+    intState = __disable_interrupts();
+    low = cp_ecapLow;
+    high = cp_ecapHigh;
+    cp_ecapReady = 0;
+    __restore_interrupts(intState);
+
+    cp_meas_report(CP_SRC_ECAP,
+                   (uint32_t)(((uint64_t)(low + high) * CP_ECAP_NS_NUM) /
+                              CP_ECAP_NS_DEN),
+                   (uint32_t)(((uint64_t)high * CP_ECAP_NS_NUM) /
+                              CP_ECAP_NS_DEN));
+}
+
+//
+// cp_ecap_isr - CEVT2: a falling edge closed a cycle
+//
+__interrupt void cp_ecap_isr(void)
+{
+    IrqNestFrame frame;
+
+    irq_nest_enter(&frame, IRQ_ID_ECAP1, IRQ_IER_ACQ,
+                   &PieCtrlRegs.PIEIER4.all, IRQ_PIE_KEEP, PIEACK_GROUP4);
+
+    if(cp_ecapSynced)
+    {
+        cp_ecapLow = ECap1Regs.CAP1;
+        cp_ecapHigh = ECap1Regs.CAP2;
+        cp_ecapReady = 1;
+        cp_ecapCycles++;
+    }
+    cp_ecapSynced = 1;
+
+    ECap1Regs.ECCLR.bit.CEVT2 = 1;
+    ECap1Regs.ECCLR.bit.CEVT1 = 1;
+    ECap1Regs.ECCLR.bit.INT = 1;
+
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER4.all);
+}
+
+//
+// End of File
+//
@@ -0,0 +1,49 @@
+//#############################################################################
+//
+// FILE: cp_ecap.h
+//
+// TITLE: CP period and duty from eCAP1
+//
+// DESCRIPTION:
+// The CP comparator output (the level adapted CP, high while CP > 0 V) is
+// routed from CP_ECAP_GPIO through INPUT X-BAR CP_ECAP_XBAR_INPUT to
+// eCAP1, which runs in continuous delta mode on SYSCLK (8.3 ns):
+//
+//     CEVT1  rising edge   CAP1 = low time,  counter reset
+//     CEVT2  falling edge  CAP2 = high time, counter reset, wrap
+//
+// The only CPU work is cp_ecap_isr() on CEVT2, once per CP cycle (1 kHz):
+// it hands CAP1/CAP2 to the background, where cp_ecap_poll() reports the
+// cycle through cp_meas_report(CP_SRC_ECAP, ...). The ADC samples are not
+// involved. The ISR runs at the acquisition level (irq_nest.h).
+//
+//#############################################################################
+
+#ifndef _cp_ecap_h
+#define _cp_ecap_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define CP_ECAP_GPIO            5U          // CP comparator output
+#define CP_ECAP_XBAR_INPUT      7U          // INPUT X-BAR input, 1..16
+
+//
+// Globals
+//
+extern volatile uint32_t cp_ecapLow;        // Last complete cycle, SYSCLK
+extern volatile uint32_t cp_ecapHigh;
+extern volatile uint16_t cp_ecapReady;
+extern uint32_t cp_ecapCycles;
+
+//
+// Function Prototypes
+//
+void cp_ecap_init(void);
+void cp_ecap_start(void);
+void cp_ecap_poll(void);
+__interrupt void cp_ecap_isr(void);
+
+#endif
@@ -0,0 +1,166 @@
+//#############################################################################
+//
+// FILE: cp_hist.c
+//
+// TITLE: CP plateau levels from a per-period histogram of IN_CP_ADC
+//
+// DESCRIPTION:
+// Histogram banks and the background Otsu split.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "cp_hist.h"
+#include "adc_cal.h"
+
+//
+// Defines
+//
+#define CP_HIST_HALF_BIN        (1U << (CP_HIST_SHIFT - 1U))
+
+//
+// Globals
+//
+CpHistAcc cp_hist_acc;
+volatile uint16_t cp_histReady;
+CpHist cp_hist;
+
+//
+// Function Prototypes
+//
+static uint16_t cp_hist_counts(uint32_t meanQ8);
+
+//
+// cp_hist_init - Empty both banks. Call with adcA2ISR stopped.
+//
+void cp_hist_init(void)
+{
+    uint16_t i;
+
+    for(i = 0; i < CP_HIST_BINS; i++)
+    {
+        cp_hist_acc.bin[0][i] = 0;
+        cp_hist_acc.bin[1][i] = 0;
+    }
+    cp_hist_acc.count[0] = 0;
+    cp_hist_acc.count[1] = 0;
+    cp_hist_acc.active = 0;
+    cp_hist_acc.periods = 0;
+    cp_histReady = 0;
+
+    cp_hist.bimodal = 0;
+    cp_hist.periods = 0;
+    cp_hist.updates = 0;
+}
+
+//
+// cp_hist_poll - Background task: split the histogram handed over by the
+// ISR. Returns 1 when cp_hist was updated.
+//
+uint16_t cp_hist_poll(void)
+{
+    uint16_t *bin;
+    uint32_t n, sum = 0, wLow = 0, sumLow = 0, wHigh;
+    uint32_t meanLow, meanHigh, bestLow = 0, bestHigh = 0, bestWHigh = 0;
+    uint64_t var, best = 0;
+    uint16_t i, bank, split = 0;
+
+    if(0U == cp_histReady)
+    {
+        return 0;
+    }
+
+    bank = cp_hist_acc.active ^ 1U;
+    bin = cp_hist_acc.bin[bank];
+    n = cp_hist_acc.count[bank];
+
+    for(i = 0; i < CP_HIST_BINS; i++)
+    {
+        sum += (uint32_t)i * bin[i];
+    }
+
+    //
+    // Otsu: every split between bin i and i + 1
+    //
+    for(i = 0; (n != 0UL) && (i < CP_HIST_BINS - 1U); i++)
+    {
+        wLow += bin[i];
+        sumLow += (uint32_t)i * bin[i];
+        if(0UL == wLow)
+        {
+            continue;
+        }
+        wHigh = n - wLow;
+        if(0UL == wHigh)
+        {
+            break;
+        }
+
+        meanLow = (sumLow << 8) / wLow;
+        meanHigh = ((sum - sumLow) << 8) / wHigh;
+        var = (uint64_t)(wLow * wHigh) *
+              ((meanHigh - meanLow) * (meanHigh - meanLow));
+        if(var > best)
+        {
+            best = var;
+            split = i + 1U;
+            bestLow = meanLow;
+            bestHigh = meanHigh;
+            bestWHigh = wHigh;
+        }
+    }
+
+    if(n != 0UL)
+    {
+        cp_hist.bimodal = (best != 0U) &&
+                          ((bestHigh - bestLow) >=
+                           ((uint32_t)CP_HIST_MIN_SEP_BINS << 8));
+        if(cp_hist.bimodal)
+        {
+            cp_hist.lowCounts = cp_hist_counts(bestLow);
+            cp_hist.highCounts = cp_hist_counts(bestHigh);
+            cp_hist.splitCounts = split << CP_HIST_SHIFT;
+            cp_hist.dutyPm = (uint16_t)((bestWHigh * 1000UL) / n);
+        }
+        else
+        {
+            cp_hist.lowCounts = cp_hist_counts((sum << 8) / n);
+            cp_hist.highCounts = cp_hist.lowCounts;
+            cp_hist.splitCounts = 0;
+            cp_hist.dutyPm = 0;
+        }
+        cp_hist.lowMv = adc_cal_to_mv(&adc_cal[CH_IN_CP_ADC],
+                                      cp_hist.lowCounts);
+        cp_hist.highMv = adc_cal_to_mv(&adc_cal[CH_IN_CP_ADC],
+                                       cp_hist.highCounts);
+        cp_hist.periods = cp_histReady;
+        cp_hist.updates++;
+    }
+
+    //
+    // Empty the bank before giving it back
+    //
+    for(i = 0; i < CP_HIST_BINS; i++)
+    {
+        bin[i] = 0;
+    }
+    cp_hist_acc.count[bank] = 0;
+    cp_histReady = 0;
+
+    return (n != 0UL) ? 1U : 0U;
+}
+
+//
+// cp_hist_counts - Mean in Q8 bins to counts, bin centre
+//
+static uint16_t cp_hist_counts(uint32_t meanQ8)
+{
+    return (uint16_t)(((meanQ8 << CP_HIST_SHIFT) >> 8) + CP_HIST_HALF_BIN);
+}
+
+//
+// End of File
+//
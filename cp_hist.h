@@ -0,0 +1,121 @@
+//#############################################################################
+//
+// FILE: cp_hist.h
+//
+// TITLE: CP plateau levels from a per-period histogram of IN_CP_ADC
+//
+// DESCRIPTION:
+// cp_hist_push() adds every IN_CP_ADC sample to a 64 bin histogram (bin =
+// counts >> 6), one increment per sample. At the end of each CP period
+// (cp_adc_push(), or CP_ADC_MAX_SAMPLES without an edge at a DC level)
+// cp_hist_period() hands the histogram to the background and continues in
+// the second bank. If the background has not taken the previous one yet,
+// the current bank simply keeps accumulating, so one result may cover
+// several periods; the duty is still the high fraction of the samples.
+//
+// cp_hist_poll() splits the histogram into a low and a high plateau with
+// Otsu's method: the split bin maximising the between-class variance
+//
+//     wLow * wHigh * (meanHigh - meanLow)^2
+//
+// in 32/64-bit integers (means in Q8 bins), O(bins) per period instead of
+// O(samples). It gives the two plateau levels in counts and millivolts
+// and the duty. The classes are accepted as two plateaus when both hold
+// samples and the means are at least CP_HIST_MIN_SEP_BINS apart; the
+// midpoint of the means then becomes the edge threshold of the ADC
+// decoder (cp_adc_acc.threshold), so a 3 V or 6 V plateau, a cable voltage
+// drop or level adapter tolerances do not move the measured duty. Without
+// a second plateau (CP at a DC level) the single level is reported and the
+// threshold is kept.
+//
+// tests/test_cp_hist.c (make -C tests) checks it on the host with
+// synthetic traces: the 12/9/6/3 V plateaus against -12 V, duties
+// 10..96 %, and uniform noise up to +-3 bins.
+//
+//#############################################################################
+
+#ifndef _cp_hist_h
+#define _cp_hist_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define CP_HIST_BITS            6U
+#define CP_HIST_BINS            (1U << CP_HIST_BITS)
+#define CP_HIST_SHIFT           (12U - CP_HIST_BITS)
+#define CP_HIST_MAX_SAMPLES     16384U      // Bank full: stop counting
+#define CP_HIST_MIN_SEP_BINS    8U          // Plateaus at least 512 counts
+                                            // apart (4 x the hysteresis)
+
+typedef struct
+{
+    uint16_t bin[2][CP_HIST_BINS];
+    uint16_t count[2];                      // Samples in each bank
+    uint16_t active;                        // Bank being filled
+    uint16_t periods;                       // Period ends in the active bank
+} CpHistAcc;
+
+typedef struct
+{
+    uint16_t lowCounts;                     // Plateau means
+    uint16_t highCounts;
+    int32_t lowMv;
+    int32_t highMv;
+    uint16_t splitCounts;                   // Otsu split, lower edge of the
+                                            // first high bin
+    uint16_t dutyPm;                        // High samples, 0.1 %
+    uint16_t bimodal;                       // Two plateaus found
+    uint16_t periods;                       // CP periods in the histogram
+    uint32_t updates;
+} CpHist;
+
+//
+// Globals
+//
+extern CpHistAcc cp_hist_acc;
+extern volatile uint16_t cp_histReady;      // Inactive bank to be processed
+extern CpHist cp_hist;
+
+//
+// Function Prototypes
+//
+void cp_hist_init(void);
+uint16_t cp_hist_poll(void);
+
+//
+// cp_hist_push - Count one IN_CP_ADC sample
+//
+#pragma FUNC_ALWAYS_INLINE(cp_hist_push)
+static inline void cp_hist_push(uint16_t sample)
+{
+    CpHistAcc *h = &cp_hist_acc;
+    uint16_t bank = h->active;
+
+    if(h->count[bank] < CP_HIST_MAX_SAMPLES)
+    {
+        h->bin[bank][(sample >> CP_HIST_SHIFT) & (CP_HIST_BINS - 1U)]++;
+        h->count[bank]++;
+    }
+}
+
+//
+// cp_hist_period - A CP period ended: hand the bank over if the background
+// is done with the other one
+//
+#pragma FUNC_ALWAYS_INLINE(cp_hist_period)
+static inline void cp_hist_period(void)
+{
+    CpHistAcc *h = &cp_hist_acc;
+
+    h->periods++;
+    if(!cp_histReady)
+    {
+        h->active ^= 1U;
+        cp_histReady = h->periods;
+        h->periods = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,191 @@
+//#############################################################################
+//
+// FILE: cp_meas.c
+//
+// TITLE: CP frequency and duty measurement, ADC and eCAP sources
+//
+// DESCRIPTION:
+// Common report path of the CP measurement sources, the background half of
+// the ADC decoder and the cross-check between the sources.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "cp_meas.h"
+#include "flash_log.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define CP_TBCLK_NS_NUM         1000UL      // TBCLK ticks to ns
+#define CP_TBCLK_NS_DEN         TBCLK_MHZ
+
+//
+// Globals
+//
+CpMeas cp_meas[CP_NUM_SRC];
+CpAdcAcc cp_adc_acc;
+volatile uint16_t cp_adcCycleSamples;
+volatile uint16_t cp_adcCycleHigh;
+volatile uint16_t cp_adcCycleReady;
+uint16_t cp_meas_agree;
+uint16_t cp_meas_mismatches;
+
+static uint32_t cp_sampleNs;                // ADC sample period
+
+//
+// Function Prototypes
+//
+static void cp_meas_check(void);
+static uint32_t cp_abs_diff(uint32_t a, uint32_t b);
+
+//
+// cp_meas_init - Clear both sources. samplePeriodTicks is the ePWM2
+// period in TBCLK ticks. Call before adcA2ISR is enabled, and again with
+// the ISR stopped when the sample period changes.
+//
+void cp_meas_init(uint16_t samplePeriodTicks)
+{
+    uint16_t i;
+
+    cp_sampleNs = ((uint32_t)samplePeriodTicks * CP_TBCLK_NS_NUM) /
+                  CP_TBCLK_NS_DEN;
+
+    cp_adc_acc.count = 0;
+    cp_adc_acc.high = 0;
+    cp_adc_acc.level = 0;
+    cp_adc_acc.synced = 0;
+    cp_adc_acc.threshold = CP_ADC_THRESHOLD;
+    cp_adcCycleReady = 0;
+    cp_hist_init();
+
+    for(i = 0; i < CP_NUM_SRC; i++)
+    {
+        cp_meas[i].periodNs = 0;
+        cp_meas[i].highNs = 0;
+        cp_meas[i].dutyPm = 0;
+        cp_meas[i].freqHz = 0;
+        cp_meas[i].valid = 0;
+        cp_meas[i].cycles = 0;
+        cp_meas[i].atMs = 0;
+    }
+
+    cp_meas_agree = 0;
+    cp_meas_mismatches = 0;
+}
+
+//
+// cp_meas_report - One complete CP cycle measured by a source
+//
+void cp_meas_report(uint16_t src, uint32_t periodNs, uint32_t highNs)
+{
+    CpMeas *m = &cp_meas[src];
+
+    if((0UL == periodNs) || (highNs > periodNs))
+    {
+        m->valid = 0;
+        return;
+    }
+
+    m->periodNs = periodNs;
+    m->highNs = highNs;
+    m->dutyPm = (uint16_t)(((uint64_t)highNs * 1000U) / periodNs);
+    m->freqHz = (uint16_t)((1000000000UL + periodNs / 2UL) / periodNs);
+    m->valid = 1;
+    m->cycles++;
+    m->atMs = flog_time_ms();
+}
+
+//
+// cp_meas_poll - Background task: report the last ADC cycle, follow the
+// plateaus with the ADC threshold, time out the silent sources and
+// cross-check
+//
+void cp_meas_poll(void)
+{
+    uint32_t now;
+    uint16_t samples, high, intState, i;
+
+    if(cp_adcCycleReady)
+    {
+        intState = __disable_interrupts();
+        samples = cp_adcCycleSamples;
+        high = cp_adcCycleHigh;
+        cp_adcCycleReady = 0;
+        __restore_interrupts(intState);
+
+        cp_meas_report(CP_SRC_ADC, samples * cp_sampleNs, high * cp_sampleNs);
+    }
+
+    if(cp_hist_poll() && cp_hist.bimodal)
+    {
+        cp_adc_acc.threshold = (int16_t)((cp_hist.lowCounts +
+                                          cp_hist.highCounts) / 2U);
+    }
+
+    now = flog_time_ms();
+    for(i = 0; i < CP_NUM_SRC; i++)
+    {
+        if(cp_meas[i].valid && ((now - cp_meas[i].atMs) > CP_MEAS_TIMEOUT_MS))
+        {
+            cp_meas[i].valid = 0;
+        }
+    }
+
+    cp_meas_check();
+}
+
+//
+// cp_meas_check - Compare the sources while both are valid. Only the
+// newest cycle of each is compared; on a duty change they may briefly
+// describe different cycles, so a single miss is not an error.
+//
+static void cp_meas_check(void)
+{
+    const CpMeas *adc = &cp_meas[CP_SRC_ADC];
+    const CpMeas *cap = &cp_meas[CP_SRC_ECAP];
+    uint32_t tol = CP_MEAS_TOL_SAMPLES * cp_sampleNs;
+    static uint32_t checkedAdc, checkedCap;
+    static uint16_t missRun;
+
+    if(!adc->valid || !cap->valid)
+    {
+        cp_meas_agree = 0;
+        missRun = 0;
+        return;
+    }
+    if((adc->cycles == checkedAdc) && (cap->cycles == checkedCap))
+    {
+        return;                             // Nothing new
+    }
+    checkedAdc = adc->cycles;
+    checkedCap = cap->cycles;
+
+    cp_meas_agree = (cp_abs_diff(adc->periodNs, cap->periodNs) <= tol) &&
+                    (cp_abs_diff(adc->highNs, cap->highNs) <= tol);
+
+    if(cp_meas_agree)
+    {
+        missRun = 0;
+    }
+    else if(2U == ++missRun)
+    {
+        cp_meas_mismatches++;               // Second miss in a row
+    }
+}
+
+//
+// cp_abs_diff - |a - b|
+//
+static uint32_t cp_abs_diff(uint32_t a, uint32_t b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+//
+// End of File
+//
@@ -0,0 +1,151 @@
+//#############################################################################
+//
+// FILE: cp_meas.h
+//
+// TITLE: CP frequency and duty measurement, ADC and eCAP sources
+//
+// DESCRIPTION:
+// The CP PWM is measured by two independent sources that report through
+// the same call, cp_meas_report(source, periodNs, highNs):
+//
+//     CP_SRC_ADC   cp_adc_push() in adcA2ISR follows the IN_CP_ADC samples
+//                  with hysteresis around a threshold and counts the
+//                  samples of each cycle (resolution one sample period,
+//                  10.4 us by default). The threshold starts at
+//                  CP_ADC_THRESHOLD and then follows the midpoint of the
+//                  plateaus found by the per-period histogram (cp_hist.h)
+//     CP_SRC_ECAP  eCAP1 timestamps the edges of the CP comparator
+//                  output (cp_ecap.h, resolution one SYSCLK, 8.3 ns)
+//
+// Both ISR halves only hand over the last complete cycle; cp_meas_poll()
+// converts it to nanoseconds, duty and frequency in the background and
+// cross-checks the sources: while both have reported within
+// CP_MEAS_TIMEOUT_MS, period and high time must agree within two ADC
+// sample periods. A disagreement (broken comparator, ADC channel or
+// level adapter) is counted in cp_meas_mismatches.
+//
+// A source that sees no cycle for CP_MEAS_TIMEOUT_MS (CP at a DC level,
+// no PWM) is marked invalid. After lost conversions (acq_gap.h)
+// cp_adc_gap() drops the ADC cycle in progress.
+//
+//#############################################################################
+
+#ifndef _cp_meas_h
+#define _cp_meas_h
+
+#include <stdint.h>
+#include "cp_hist.h"
+
+//
+// Defines
+//
+#define CP_SRC_ADC              0U
+#define CP_SRC_ECAP             1U
+#define CP_NUM_SRC              2U
+
+#define CP_ADC_THRESHOLD        2048        // Counts, 0 V of the CP
+#define CP_ADC_HYSTERESIS       128
+#define CP_ADC_MAX_SAMPLES      1000U       // Longest cycle accepted, ~10 ms
+
+#define CP_MEAS_TIMEOUT_MS      10U
+#define CP_MEAS_TOL_SAMPLES     2U          // Cross-check, ADC sample periods
+
+typedef struct
+{
+    uint32_t periodNs;
+    uint32_t highNs;
+    uint16_t dutyPm;        // High time, 0.1 %
+    uint16_t freqHz;
+    uint16_t valid;         // A cycle within CP_MEAS_TIMEOUT_MS
+    uint16_t rsvd;
+    uint32_t cycles;        // Reports
+    uint32_t atMs;          // flog_time_ms() of the last report
+} CpMeas;
+
+//
+// ADC decoder state, owned by adcA2ISR
+//
+typedef struct
+{
+    uint16_t count;         // Samples since the last rising edge
+    uint16_t high;          // Samples above the threshold in the cycle
+    uint16_t level;         // 1: above threshold + hysteresis
+    uint16_t synced;        // A rising edge was seen
+    int16_t threshold;      // Counts, set by cp_meas_poll()
+} CpAdcAcc;
+
+//
+// Globals
+//
+extern CpMeas cp_meas[CP_NUM_SRC];
+extern CpAdcAcc cp_adc_acc;
+extern volatile uint16_t cp_adcCycleSamples;    // Last complete cycle
+extern volatile uint16_t cp_adcCycleHigh;
+extern volatile uint16_t cp_adcCycleReady;
+extern uint16_t cp_meas_agree;              // Last cross-check passed
+extern uint16_t cp_meas_mismatches;
+
+//
+// Function Prototypes
+//
+void cp_meas_init(uint16_t samplePeriodTicks);
+void cp_meas_report(uint16_t src, uint32_t periodNs, uint32_t highNs);
+void cp_meas_poll(void);
+
+//
+// cp_adc_push - Account one IN_CP_ADC sample. A cycle ends at each rising
+// edge; it also ends the histogram period.
+//
+#pragma FUNC_ALWAYS_INLINE(cp_adc_push)
+static inline void cp_adc_push(uint16_t sample)
+{
+    CpAdcAcc *acc = &cp_adc_acc;
+    int16_t d = (int16_t)sample - acc->threshold;
+
+    cp_hist_push(sample);
+    acc->count++;
+
+    if(acc->level)
+    {
+        acc->high++;
+        if(d < -CP_ADC_HYSTERESIS)
+        {
+            acc->level = 0;
+        }
+    }
+    else if(d > CP_ADC_HYSTERESIS)
+    {
+        acc->level = 1;
+        if(acc->synced)
+        {
+            cp_adcCycleSamples = acc->count;
+            cp_adcCycleHigh = acc->high;
+            cp_adcCycleReady = 1;
+        }
+        acc->synced = 1;
+        acc->count = 0;
+        acc->high = 0;
+        cp_hist_period();
+    }
+
+    if(acc->count >= CP_ADC_MAX_SAMPLES)
+    {
+        acc->synced = 0;                    // DC level, no PWM
+        acc->count = 0;
+        acc->high = 0;
+        cp_hist_period();
+    }
+}
+
+//
+// cp_adc_gap - Conversions were lost: restart at the next rising edge
+//
+#pragma FUNC_ALWAYS_INLINE(cp_adc_gap)
+static inline void cp_adc_gap(void)
+{
+    cp_adc_acc.synced = 0;
+    cp_adc_acc.count = 0;
+    cp_adc_acc.high = 0;
+}
+
+#endif
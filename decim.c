@@ -0,0 +1,114 @@
+//#############################################################################
+//
+// FILE: decim.c
+//
+// TITLE: Multi-rate CIC decimation of the ADC channels
+//
+// DESCRIPTION:
+// Stream buffers, set-up and the consumer side of the decimated streams.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "decim.h"
+#include "memory_plan.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define DEC_TBCLK_HZ            TBCLK_HZ
+
+//
+// Globals
+//
+DecChan dec[NUM_CHANNELS];
+uint32_t dec_rateHz[DEC_NUM_STAGES];
+
+static int16_t dec_ringTlm[NUM_CHANNELS][DEC_RING_TLM];
+
+PLAN_CHECK(dec_ring_tlm, (DEC_RING_TLM & (DEC_RING_TLM - 1U)) == 0U);
+
+//
+// dec_init - Clear the filters and empty the streams for a sample period
+// in TBCLK ticks. Call with the ADC ISRs stopped; readers must be set up
+// again with dec_reader_init().
+//
+void dec_init(uint16_t samplePeriodTicks)
+{
+    uint16_t ch;
+    uint32_t fs;
+    DecChan *d;
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        d = &dec[ch];
+        d->i1 = 0;
+        d->i2 = 0;
+        d->i3 = 0;
+        d->c1 = 0;
+        d->c2 = 0;
+        d->c3 = 0;
+        d->x1 = 0;
+        d->x2 = 0;
+        d->j1 = 0;
+        d->j2 = 0;
+        d->d1 = 0;
+        d->d2 = 0;
+        d->phase1 = 0;
+        d->phase2 = 0;
+
+        d->out[DEC_STAGE_TLM].buf = dec_ringTlm[ch];
+        d->out[DEC_STAGE_TLM].mask = DEC_RING_TLM - 1U;
+        d->out[DEC_STAGE_TLM].head = 0;
+    }
+
+    fs = DEC_TBCLK_HZ / ((samplePeriodTicks != 0U) ? samplePeriodTicks : 1U);
+    dec_rateHz[DEC_STAGE_TLM] = fs / (DEC_R1 * DEC_R2);
+}
+
+//
+// dec_reader_init - Start reading a stream at its next sample
+//
+void dec_reader_init(const DecStream *s, DecReader *r)
+{
+    r->next = s->head;
+    r->lost = 0;
+}
+
+//
+// dec_read - Take the oldest unread sample of a stream. Returns 0 when the
+// reader has caught up. A reader overrun by the ISR skips to the oldest
+// sample still in the ring and adds the skipped ones to r->lost. The ISR
+// may overwrite the slot between the check and the read if the reader is
+// preempted for a whole ring; keep readers well within DEC_RING_TLM.
+//
+uint16_t dec_read(const DecStream *s, DecReader *r, int16_t *sample)
+{
+    uint16_t head = s->head;
+    uint16_t behind = head - r->next;
+    uint16_t size = s->mask + 1U;
+
+    if(behind == 0U)
+    {
+        return 0;
+    }
+
+    if(behind > size)
+    {
+        r->lost += behind - size;
+        r->next = head - size;
+    }
+
+    *sample = s->buf[r->next & s->mask];
+    r->next++;
+
+    return 1;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,176 @@
+//#############################################################################
+//
+// FILE: decim.h
+//
+// TITLE: Multi-rate CIC decimation of the ADC channels
+//
+// DESCRIPTION:
+// Each ADC ISR passes its ADCRESULT once to dec_push(), which feeds a
+// decimated stream per channel next to the full-rate consumers
+// (protection triggers, flight recorder, mains_meas and sogi_pll) and the
+// per-period CP decoder:
+//
+//     stage 1  3rd order CIC, decimation DEC_R1 (16): 6.0 kS/s at the
+//              default sample period. A 3-tap FIR [-a, 1 + 2a, -a],
+//              a = 0.15, compensates the CIC droop: flat within 1 % up
+//              to 1 kHz. Not kept as a stream, only the input of stage 2
+//     stage 2  2nd order CIC on the stage 1 output, decimation DEC_R2
+//              (6): 1.0 kS/s, read by tlm_poll() and sent as the
+//              per-channel means of the TLM_ID_LEVELS frame (telemetry.h)
+//
+// The mains analysis stays on the raw samples: mains_meas interpolates
+// the zero crossings and sogi_pll tracks the phase at the sample rate,
+// and both would lose resolution at 6 kS/s.
+//
+// The integrators run at the input rate (three adds), the combs and the
+// FIR once per output sample, so a push costs a few cycles and at most
+// ~60 at the end of a stage 2 period; everything runs in the ISR. The
+// integrators of both stages are uint32 and wrap; the combs take
+// differences modulo 2^32, which are exact as long as the CIC output fits
+// (4095 * 16^3 and 32767 * 6^2 are far below 2^31).
+//
+// Output samples are counts in Q3 (counts * 8), int16, unity gain at DC.
+// Each stream is a ring written by the ISR and read by any number of
+// consumers with their own read index (dec_read()), so one stream fans
+// out to several tasks; a consumer that falls more than DEC_RING_TLM behind
+// skips to the oldest sample still in the ring and counts the lost ones.
+// tlm_dec_init() has to follow every dec_init(), which restarts the
+// rings. The output rates follow the sample period parameter and are in
+// dec_rateHz[]. Lost conversions (acq_gap.h) are not filled in: the
+// stream then runs short by missed / R samples.
+//
+//#############################################################################
+
+#ifndef _decim_h
+#define _decim_h
+
+#include <stdint.h>
+#include "channels.h"
+
+//
+// Defines
+//
+#define DEC_R1                  16U         // Stage 1 decimation
+#define DEC_R2                  6U          // Stage 2 decimation
+#define DEC_OUT_SHIFT           9U          // 16^3 / 2^9 = 8: Q3 counts
+#define DEC_FIR_A_Q14           2458L       // Compensator a = 0.15
+#define DEC_FIR_C_Q14           (16384L + 2L * DEC_FIR_A_Q14)
+#define DEC_R2_GAIN_Q14         455L        // 1 / (6^2), Q14
+
+#define DEC_STAGE_TLM           0U
+#define DEC_NUM_STAGES          1U
+
+#define DEC_RING_TLM            32U         // Power of two, 32 ms
+
+typedef struct
+{
+    int16_t *buf;
+    uint16_t mask;                          // Ring size - 1
+    volatile uint16_t head;                 // Samples written, free running
+} DecStream;
+
+typedef struct
+{
+    uint32_t i1, i2, i3;                    // Stage 1 integrators
+    uint32_t c1, c2, c3;                    // Stage 1 comb delays
+    int32_t x1, x2;                         // Compensator delays
+    uint32_t j1, j2;                        // Stage 2 integrators
+    uint32_t d1, d2;                        // Stage 2 comb delays
+    uint16_t phase1;
+    uint16_t phase2;
+    DecStream out[DEC_NUM_STAGES];
+} DecChan;
+
+typedef struct
+{
+    uint16_t next;                          // head of the stream to read
+    uint16_t lost;                          // Samples skipped on overrun
+} DecReader;
+
+//
+// Globals
+//
+extern DecChan dec[NUM_CHANNELS];
+extern uint32_t dec_rateHz[DEC_NUM_STAGES];
+
+//
+// Function Prototypes
+//
+void dec_init(uint16_t samplePeriodTicks);
+void dec_reader_init(const DecStream *s, DecReader *r);
+uint16_t dec_read(const DecStream *s, DecReader *r, int16_t *sample);
+
+//
+// dec_sat - Clamp to int16
+//
+#pragma FUNC_ALWAYS_INLINE(dec_sat)
+static inline int16_t dec_sat(int32_t v)
+{
+    return (v > 32767L) ? 32767 : ((v < -32768L) ? -32768 : (int16_t)v);
+}
+
+//
+// dec_put - Append one output sample to a stream
+//
+#pragma FUNC_ALWAYS_INLINE(dec_put)
+static inline void dec_put(DecStream *s, int16_t v)
+{
+    s->buf[s->head & s->mask] = v;
+    s->head++;
+}
+
+//
+// dec_push - Account one ADC sample of a channel
+//
+#pragma FUNC_ALWAYS_INLINE(dec_push)
+static inline void dec_push(DecChan *d, uint16_t sample)
+{
+    uint32_t c0, c1, c2, c3, e1, e2;
+    int32_t s, y;
+
+    d->i1 += sample;
+    d->i2 += d->i1;
+    d->i3 += d->i2;
+    if(++d->phase1 < DEC_R1)
+    {
+        return;
+    }
+    d->phase1 = 0;
+
+    //
+    // Stage 1 combs and compensator
+    //
+    c0 = d->i3;
+    c1 = c0 - d->c1;
+    d->c1 = c0;
+    c2 = c1 - d->c2;
+    d->c2 = c1;
+    c3 = c2 - d->c3;
+    d->c3 = c2;
+
+    s = (int32_t)((c3 + (1UL << (DEC_OUT_SHIFT - 1U))) >> DEC_OUT_SHIFT);
+    y = (DEC_FIR_C_Q14 * d->x1 - DEC_FIR_A_Q14 * (s + d->x2) +
+         (1L << 13)) >> 14;
+    d->x2 = d->x1;
+    d->x1 = s;
+
+    //
+    // Stage 2
+    //
+    d->j1 += (uint32_t)y;
+    d->j2 += d->j1;
+    if(++d->phase2 < DEC_R2)
+    {
+        return;
+    }
+    d->phase2 = 0;
+
+    e1 = d->j2 - d->d1;
+    d->d1 = d->j2;
+    e2 = e1 - d->d2;
+    d->d2 = e1;
+    dec_put(&d->out[DEC_STAGE_TLM],
+            dec_sat(((int32_t)e2 * DEC_R2_GAIN_Q14 + (1L << 13)) >> 14));
+}
+
+#endif
@@ -0,0 +1,145 @@
+//#############################################################################
+//
+// FILE: envelope.c
+//
+// TITLE: Sliding-window min/max envelope of the CP channels
+//
+// DESCRIPTION:
+// Tracker set-up and the start-up benchmark against the naive rescan.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "envelope.h"
+#include "bench.h"
+
+//
+// Globals
+//
+EnvTracker env[ENV_NUM];
+uint32_t env_benchDeque;
+uint32_t env_benchNaive;
+uint16_t env_benchMismatch;
+
+static uint16_t env_benchTrace[ENV_BENCH_SAMPLES];
+static uint16_t env_benchMin[ENV_BENCH_SAMPLES];
+static uint16_t env_benchMax[ENV_BENCH_SAMPLES];
+static EnvTracker env_benchTracker;
+
+//
+// Function Prototypes
+//
+static void env_bench_trace(void);
+
+//
+// env_init - Empty a tracker and set its window, 2..ENV_CAPACITY samples.
+// Call with the ISR that pushes to it stopped or masked.
+//
+void env_init(EnvTracker *e, uint16_t window)
+{
+    if(window < 2U)
+    {
+        window = 2U;
+    }
+    if(window > ENV_CAPACITY)
+    {
+        window = ENV_CAPACITY;
+    }
+
+    e->hi.front = 0;
+    e->hi.back = 0;
+    e->lo.front = 0;
+    e->lo.back = 0;
+    e->n = 0;
+    e->window = window;
+    e->min = 0;
+    e->max = 0;
+}
+
+//
+// env_bench - Time the deque tracker and the naive rescan over the same
+// trace and compare their envelopes. Start-up only.
+//
+void env_bench(void)
+{
+    uint32_t t0, cycles;
+    uint16_t i, j, lo, hi, first;
+
+    env_bench_trace();
+
+    //
+    // Deque tracker
+    //
+    env_init(&env_benchTracker, ENV_BENCH_WINDOW);
+    t0 = BENCH_NOW();
+    for(i = 0; i < ENV_BENCH_SAMPLES; i++)
+    {
+        env_push(&env_benchTracker, env_benchTrace[i]);
+        env_benchMin[i] = env_benchTracker.min;
+        env_benchMax[i] = env_benchTracker.max;
+    }
+    cycles = t0 - BENCH_NOW() - bench_overhead;
+    env_benchDeque = cycles / ENV_BENCH_SAMPLES;
+
+    //
+    // Naive: rescan the window at every sample
+    //
+    env_benchMismatch = 0;
+    t0 = BENCH_NOW();
+    for(i = 0; i < ENV_BENCH_SAMPLES; i++)
+    {
+        first = (i >= ENV_BENCH_WINDOW - 1U) ? (i - (ENV_BENCH_WINDOW - 1U)) : 0U;
+        lo = env_benchTrace[first];
+        hi = lo;
+        for(j = first + 1U; j <= i; j++)
+        {
+            if(env_benchTrace[j] < lo)
+            {
+                lo = env_benchTrace[j];
+            }
+            if(env_benchTrace[j] > hi)
+            {
+                hi = env_benchTrace[j];
+            }
+        }
+        if((lo != env_benchMin[i]) || (hi != env_benchMax[i]))
+        {
+            env_benchMismatch++;
+        }
+    }
+    cycles = t0 - BENCH_NOW() - bench_overhead;
+    env_benchNaive = cycles / ENV_BENCH_SAMPLES;
+}
+
+//
+// env_bench_trace - Synthetic CP cycle: 96 samples at 30 % duty, overshoot
+// and ringing after each edge, and a little noise
+//
+static void env_bench_trace(void)
+{
+    uint16_t i, phase, noise = 0x1D3U;
+    int16_t v;
+
+    for(i = 0; i < ENV_BENCH_SAMPLES; i++)
+    {
+        phase = i % 96U;
+        noise = (noise >> 1) ^ ((noise & 1U) ? 0xB400U : 0U);
+
+        if(phase < 29U)
+        {
+            v = 3584 + ((phase < 4U) ? (int16_t)(160 >> phase) : 0);
+        }
+        else
+        {
+            v = 300 - ((phase < 33U) ? (int16_t)(160 >> (phase - 29U)) : 0);
+        }
+        env_benchTrace[i] = (uint16_t)(v + (int16_t)(noise & 0x1FU) - 16);
+    }
+}
+
+//
+// End of File
+//
@@ -0,0 +1,128 @@
+//#############################################################################
+//
+// FILE: envelope.h
+//
+// TITLE: Sliding-window min/max envelope of the CP channels
+//
+// DESCRIPTION:
+// env_push() in adcA2ISR and adcA3ISR keeps the minimum and maximum of the
+// last env_window samples of IN_CP_ADC and IN_CP_BORNE, for the overshoot,
+// undershoot and plateau flatness (max - min) checks, without rescanning
+// the sample stores.
+//
+// Each bound is a monotonic deque of (sample number, value): for the
+// maximum the values decrease from front to back. A new sample removes
+// the entries at the back it dominates, since they can no longer be the
+// maximum of any window that contains it, and is appended; the front
+// leaves when it falls out of the window. The front is then the maximum.
+// Every sample enters and leaves each deque once, so the cost is O(1)
+// amortised per sample, and at most env_window pops for one sample (a new
+// extreme after a monotonic run). The minimum works the same way with the
+// order reversed.
+//
+// The deques are rings of ENV_CAPACITY entries, fixed at compile time; the
+// window is PARAM_ENV_WINDOW (params.h), 2..ENV_CAPACITY samples.
+//
+// env_bench() times the tracker against the naive O(N*W) rescan of each
+// window on the same synthetic CP trace at start-up and checks that both
+// give the same envelope: env_benchDeque and env_benchNaive are the
+// cycles per sample.
+//
+//#############################################################################
+
+#ifndef _envelope_h
+#define _envelope_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define ENV_CAPACITY            64U         // Power of two, longest window
+#define ENV_WINDOW_DEFAULT      16U
+
+#define ENV_CP_ADC              0U
+#define ENV_CP_BORNE            1U
+#define ENV_NUM                 2U
+
+#define ENV_BENCH_SAMPLES       256U
+#define ENV_BENCH_WINDOW        32U
+
+typedef struct
+{
+    uint16_t at[ENV_CAPACITY];              // Sample numbers
+    uint16_t value[ENV_CAPACITY];
+    uint16_t front;                         // Free running, masked on use
+    uint16_t back;                          // One past the newest entry
+} EnvDeque;
+
+typedef struct
+{
+    EnvDeque hi;                            // Decreasing values
+    EnvDeque lo;                            // Increasing values
+    uint16_t n;                             // Number of the next sample
+    uint16_t window;
+    uint16_t min;                           // Of the last window samples
+    uint16_t max;
+} EnvTracker;
+
+//
+// Globals
+//
+extern EnvTracker env[ENV_NUM];
+extern uint32_t env_benchDeque;             // Cycles per sample
+extern uint32_t env_benchNaive;
+extern uint16_t env_benchMismatch;          // Samples where the two differ
+
+//
+// Function Prototypes
+//
+void env_init(EnvTracker *e, uint16_t window);
+void env_bench(void);
+
+//
+// env_push - Account one sample and update e->min and e->max
+//
+#pragma FUNC_ALWAYS_INLINE(env_push)
+static inline void env_push(EnvTracker *e, uint16_t sample)
+{
+    EnvDeque *hi = &e->hi;
+    EnvDeque *lo = &e->lo;
+    uint16_t n = e->n++;
+
+    //
+    // Drop the fronts that leave the window, then the dominated backs
+    //
+    if((hi->front != hi->back) &&
+       ((uint16_t)(n - hi->at[hi->front & (ENV_CAPACITY - 1U)]) >= e->window))
+    {
+        hi->front++;
+    }
+    while((hi->front != hi->back) &&
+          (hi->value[(hi->back - 1U) & (ENV_CAPACITY - 1U)] <= sample))
+    {
+        hi->back--;
+    }
+    hi->at[hi->back & (ENV_CAPACITY - 1U)] = n;
+    hi->value[hi->back & (ENV_CAPACITY - 1U)] = sample;
+    hi->back++;
+
+    if((lo->front != lo->back) &&
+       ((uint16_t)(n - lo->at[lo->front & (ENV_CAPACITY - 1U)]) >= e->window))
+    {
+        lo->front++;
+    }
+    while((lo->front != lo->back) &&
+          (lo->value[(lo->back - 1U) & (ENV_CAPACITY - 1U)] >= sample))
+    {
+        lo->back--;
+    }
+    lo->at[lo->back & (ENV_CAPACITY - 1U)] = n;
+    lo->value[lo->back & (ENV_CAPACITY - 1U)] = sample;
+    lo->back++;
+
+    e->max = hi->value[hi->front & (ENV_CAPACITY - 1U)];
+    e->min = lo->value[lo->front & (ENV_CAPACITY - 1U)];
+}
+
+#endif
@@ -80,6 +80,22 @@
 //#define USE_PLL_SRC_XTAL
 #define USE_PLL_SRC_INTOSC
 
+//
+// Flash read wait states programmed by InitFlash(). Can be raised from the
+// build options (--define=FLASH_RWAIT=n), e.g. to measure the wait-state
+// sensitivity of code running from flash. It must not go below the minimum
+// characterized for the CPU rate in the datasheet.
+//
+#define FLASH_RWAIT_MIN     0x2
+
+#ifndef FLASH_RWAIT
+#define FLASH_RWAIT         FLASH_RWAIT_MIN
+#endif
+
+#if (FLASH_RWAIT < FLASH_RWAIT_MIN)
+#error "FLASH_RWAIT is below the minimum wait states for this CPU rate"
+#endif
+
 //
 // InitSysCtrl - Initialization of system resources.
 //
@@ -93,7 +109,8 @@ void InitSysCtrl(void)
 #ifdef _FLASH
     //
     // Copy time critical code and Flash setup code to RAM. This includes the
-    // following functions: InitFlash()
+    // following functions: InitFlash(), and everything placed in the HotIsr
+    // section (ADC ISRs and per-sample kernels).
     //
     // The  RamfuncsLoadStart, RamfuncsLoadSize, and RamfuncsRunStart
     // symbols are created by the linker. Refer to the device .cmd file.
@@ -266,13 +283,7 @@ EALLOW;
     // must be characterized by TI. Refer to the datasheet for the latest
     // information.
     //
-#if CPU_FRQ_100MHZ
-        Flash0CtrlRegs.FRDCNTL.bit.RWAIT = 0x2;
-        
-#elif CPU_FRQ_120MHZ
-        Flash0CtrlRegs.FRDCNTL.bit.RWAIT = 0x2;
-        
-#endif
+    Flash0CtrlRegs.FRDCNTL.bit.RWAIT = FLASH_RWAIT;
 
     //
     // Enable Cache and prefetch mechanism to improve performance of code
@@ -0,0 +1,467 @@
+//#############################################################################
+//
+// FILE: flash_log.c
+//
+// TITLE: Persistent fault and session log in on-chip flash
+//
+// DESCRIPTION:
+// RAM ring, start-up scan and the background writer of the flash log.
+// The Flash API calls and the waits on the flash state machine are the
+// only code that runs while the bank is busy; they are in .TI.ramfunc.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "flash_log.h"
+#include "timebase.h"
+#include "memory_plan.h"
+#include "sysclk.h"
+#include "supervisor.h"
+
+#if FLOG_USE_FLASH
+#include "FlashTech_F280013x_C28x.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_flash.h"
+#endif
+
+//
+// Defines
+//
+#define FLOG_FLASH_WORDS        8U          // 128-bit program unit
+#define FLOG_ERASED             0xFFFFU
+
+//
+// Write protection of sectors 32..127 is one bit per 8 sectors
+// (CMDWEPROTB): clear bits 3..11 to open sectors 56..127, the parameter
+// sectors (params.h) and the log
+//
+#define FLOG_WEPROTB_OPEN       0xFFFFF007UL
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t reserved;
+    uint32_t sequence;      // Sector sequence, increases at every erase
+    uint32_t eraseCount;    // Erases of this sector
+    uint16_t pad;
+    uint16_t crc;
+} FlogHeader;
+
+//
+// Globals
+//
+volatile uint32_t flog_sequence;
+uint16_t flog_sector;
+uint16_t flog_slot;
+uint32_t flog_written;
+uint16_t flog_dropped;
+uint16_t flog_errors;
+uint16_t flog_flashReady;
+
+#pragma DATA_SECTION(flog_ring, "TelemetryRing");
+static FlogRecord flog_ring[FLOG_RAM_RECORDS];
+static volatile uint16_t flog_head;         // Next to fill
+static volatile uint16_t flog_tail;         // Next to write
+static uint16_t flog_bootCount;
+static uint32_t flog_sectorSeq;
+
+PLAN_CHECK(flash_log_record, sizeof(FlogRecord) == FLOG_RECORD_WORDS);
+PLAN_CHECK(flash_log_header, sizeof(FlogHeader) == FLOG_FLASH_WORDS);
+PLAN_CHECK(flash_log_ring, sizeof(flog_ring) <= PLAN_TELEMETRY_WORDS);
+
+//
+// Function Prototypes
+//
+static const uint16_t *flog_addr(uint16_t sector, uint16_t slot);
+
+#if FLOG_USE_FLASH
+static uint16_t flog_hw_init(void);
+static void flog_scan(void);
+static void flog_next_sector(void);
+
+#pragma CODE_SECTION(flog_hw_init, ".TI.ramfunc");
+#pragma CODE_SECTION(flog_hw_erase, ".TI.ramfunc");
+#pragma CODE_SECTION(flog_hw_program, ".TI.ramfunc");
+#endif
+
+//
+// flog_init - Find where the log continues and start the session
+//
+void flog_init(uint16_t bootCount)
+{
+    flog_head = 0;
+    flog_tail = 0;
+    flog_written = 0;
+    flog_dropped = 0;
+    flog_errors = 0;
+    flog_bootCount = bootCount;
+
+    flog_sequence = 0;
+    flog_sector = 0;
+    flog_slot = 0;
+    flog_sectorSeq = 0;
+    flog_flashReady = 0;
+
+#if FLOG_USE_FLASH
+    flog_flashReady = flog_hw_init();
+    if(flog_flashReady)
+    {
+        flog_scan();
+    }
+#endif
+}
+
+//
+// flog_time_ms - Milliseconds of the time base
+//
+uint32_t flog_time_ms(void)
+{
+    return tb_to_ms(tb_now());
+}
+
+//
+// flog_append - Queue a record. For the background: the record is built
+// and its CRC computed with the interrupts enabled (tb_to_us() and
+// flog_crc() take longer than a sample period); they are masked only to
+// take the ring slot and copy the record in. Should an append from an
+// interrupt come in between, the record is built again with the next
+// sequence number, so the ring stays in sequence order. When the ring is
+// full the record is dropped (flash build) or replaces the oldest one
+// (RAM build).
+//
+void flog_append(uint16_t type, uint16_t a, uint16_t b, uint16_t c,
+                 uint16_t d)
+{
+    FlogRecord rec;
+    uint64_t now = tb_now();
+    uint32_t sequence;
+    uint16_t intState, next;
+
+    rec.magic = FLOG_RECORD_MAGIC;
+    rec.type = type;
+    rec.timeUs = tb_to_us(now);
+    rec.bootCount = flog_bootCount;
+    rec.arg[0] = a;
+    rec.arg[1] = b;
+    rec.arg[2] = c;
+    rec.arg[3] = d;
+    rec.arg[4] = 0;
+    rec.arg[5] = 0;
+
+    for(;;)
+    {
+        sequence = flog_sequence;
+        rec.sequence = sequence;
+        rec.crc = flog_crc((const uint16_t *)&rec, FLOG_RECORD_WORDS - 1U);
+
+        intState = __disable_interrupts();
+        if(sequence == flog_sequence)
+        {
+            break;
+        }
+        __restore_interrupts(intState);
+    }
+
+    next = (flog_head + 1U) % FLOG_RAM_RECORDS;
+    if(next == flog_tail)
+    {
+#if FLOG_USE_FLASH
+        flog_dropped++;
+        __restore_interrupts(intState);
+        return;
+#else
+        flog_tail = (flog_tail + 1U) % FLOG_RAM_RECORDS;
+#endif
+    }
+
+    flog_ring[flog_head] = rec;
+    flog_sequence = sequence + 1UL;
+    flog_head = next;
+
+    __restore_interrupts(intState);
+}
+
+//
+// flog_poll - Background writer: at most one erase or one record per call
+//
+void flog_poll(void)
+{
+#if FLOG_USE_FLASH
+    {
+        const FlogRecord *rec;
+        const uint16_t *dst;
+        uint32_t address;
+        uint16_t ok;
+
+        if((!flog_flashReady) || (flog_tail == flog_head))
+        {
+            return;
+        }
+
+        if(FLOG_RECORDS_PER_SECTOR <= flog_slot)
+        {
+            flog_next_sector();
+            return;
+        }
+
+        rec = &flog_ring[flog_tail];
+        dst = flog_addr(flog_sector, flog_slot);
+        address = (uint32_t)dst;
+
+        //
+        // First half, then the half holding the CRC: a cut in between
+        // leaves a slot that fails the CRC check
+        //
+        ok = flog_hw_program(address, (const uint16_t *)rec);
+        if(ok)
+        {
+            ok = flog_hw_program(address + FLOG_FLASH_WORDS,
+                                 (const uint16_t *)rec + FLOG_FLASH_WORDS);
+        }
+        if(ok)
+        {
+            ok = (rec->crc == dst[FLOG_RECORD_WORDS - 1U]) &&
+                 (rec->crc == flog_crc(dst, FLOG_RECORD_WORDS - 1U));
+        }
+
+        if(ok)
+        {
+            flog_written++;
+            flog_tail = (flog_tail + 1U) % FLOG_RAM_RECORDS;
+        }
+        else
+        {
+            flog_errors++;                  // Retry the record in the next slot
+        }
+        flog_slot++;
+    }
+#endif
+}
+
+//
+// flog_addr - Address of a record slot (slot 0 is the first record, the
+// sector header sits in front of it)
+//
+static const uint16_t *flog_addr(uint16_t sector, uint16_t slot)
+{
+    return((const uint16_t *)(FLOG_BASE +
+                              ((uint32_t)sector * FLOG_SECTOR_WORDS) +
+                              ((uint32_t)(slot + 1U) * FLOG_RECORD_WORDS)));
+}
+
+//
+// flog_crc - CRC-16/CCITT (0x1021, initial 0xFFFF) over 16-bit words
+//
+uint16_t flog_crc(const uint16_t *words, uint16_t count)
+{
+    uint16_t crc = 0xFFFFU;
+    uint16_t i, bit;
+
+    for(i = 0; i < count; i++)
+    {
+        crc ^= words[i];
+        for(bit = 0; bit < 16U; bit++)
+        {
+            if(crc & 0x8000U)
+            {
+                crc = (crc << 1) ^ 0x1021U;
+            }
+            else
+            {
+                crc <<= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+#if FLOG_USE_FLASH
+//
+// flog_scan - Continue after the newest valid record
+//
+static void flog_scan(void)
+{
+    const FlogHeader *hdr;
+    const FlogRecord *rec;
+    uint16_t sector, slot, found = 0;
+    uint32_t best = 0;
+
+    for(sector = 0; sector < FLOG_NUM_SECTORS; sector++)
+    {
+        hdr = (const FlogHeader *)(FLOG_BASE +
+                                   ((uint32_t)sector * FLOG_SECTOR_WORDS));
+        if((FLOG_SECTOR_MAGIC == hdr->magic) &&
+           (hdr->crc == flog_crc((const uint16_t *)hdr,
+                                 FLOG_FLASH_WORDS - 1U)) &&
+           ((!found) || (hdr->sequence > best)))
+        {
+            best = hdr->sequence;
+            flog_sector = sector;
+            found = 1;
+        }
+    }
+
+    if(!found)
+    {
+        //
+        // Empty log: the first flog_poll() erases sector 0
+        //
+        flog_sector = FLOG_NUM_SECTORS - 1U;
+        flog_slot = FLOG_RECORDS_PER_SECTOR;
+        flog_sectorSeq = 0;
+        return;
+    }
+
+    flog_sectorSeq = best;
+
+    //
+    // First erased slot; programmed slots, valid or not, are never reused
+    //
+    for(slot = 0; slot < FLOG_RECORDS_PER_SECTOR; slot++)
+    {
+        const uint16_t *w = flog_addr(flog_sector, slot);
+        uint16_t i, erased = 1;
+
+        for(i = 0; i < FLOG_RECORD_WORDS; i++)
+        {
+            if(FLOG_ERASED != w[i])
+            {
+                erased = 0;
+                break;
+            }
+        }
+        if(erased)
+        {
+            break;
+        }
+
+        rec = (const FlogRecord *)w;
+        if((FLOG_RECORD_MAGIC == rec->magic) &&
+           (rec->crc == flog_crc(w, FLOG_RECORD_WORDS - 1U)) &&
+           (rec->sequence >= flog_sequence))
+        {
+            flog_sequence = rec->sequence + 1UL;
+        }
+    }
+    flog_slot = slot;
+}
+
+//
+// flog_next_sector - Erase the sector after the current one and write its
+// header
+//
+static void flog_next_sector(void)
+{
+    FlogHeader hdr;
+    const FlogHeader *old;
+    uint16_t next = (flog_sector + 1U) % FLOG_NUM_SECTORS;
+    uint32_t address = FLOG_BASE + ((uint32_t)next * FLOG_SECTOR_WORDS);
+
+    old = (const FlogHeader *)address;
+    hdr.eraseCount = 1;
+    if((FLOG_SECTOR_MAGIC == old->magic) &&
+       (old->crc == flog_crc((const uint16_t *)old, FLOG_FLASH_WORDS - 1U)))
+    {
+        hdr.eraseCount = old->eraseCount + 1UL;
+    }
+
+    if(!flog_hw_erase(address))
+    {
+        flog_errors++;
+        return;
+    }
+
+    hdr.magic = FLOG_SECTOR_MAGIC;
+    hdr.reserved = FLOG_ERASED;
+    hdr.sequence = ++flog_sectorSeq;
+    hdr.pad = FLOG_ERASED;
+    hdr.crc = flog_crc((const uint16_t *)&hdr, FLOG_FLASH_WORDS - 1U);
+
+    if(!flog_hw_program(address, (const uint16_t *)&hdr))
+    {
+        flog_errors++;                      // Sector reused at next boot
+    }
+
+    flog_sector = next;
+    flog_slot = 0;
+}
+
+//
+// flog_hw_init - Initialize the Flash API for SYSCLK and bank 0
+//
+static uint16_t flog_hw_init(void)
+{
+    Fapi_StatusType status;
+
+    EALLOW;
+    status = Fapi_initializeAPI(FlashTech_CPU0_BASE_ADDRESS, SYSCLK_MHZ);
+    if(Fapi_Status_Success == status)
+    {
+        status = Fapi_setActiveFlashBank(Fapi_FlashBank0);
+    }
+    EDIS;
+
+    return(Fapi_Status_Success == status);
+}
+
+//
+// flog_hw_erase - Erase one sector, wait for the state machine with the
+// supervisor serviced
+//
+uint16_t flog_hw_erase(uint32_t address)
+{
+    Fapi_StatusType status;
+
+    EALLOW;
+    Fapi_setupBankSectorEnable(FLASH_WRAPPER_PROGRAM_BASE + FLASH_O_CMDWEPROTA,
+                               0xFFFFFFFFUL);
+    Fapi_setupBankSectorEnable(FLASH_WRAPPER_PROGRAM_BASE + FLASH_O_CMDWEPROTB,
+                               FLOG_WEPROTB_OPEN);
+    status = Fapi_issueAsyncCommandWithAddress(Fapi_EraseSector,
+                                               (uint32 *)address);
+    sup_wait_begin();
+    while(Fapi_Status_FsmReady != Fapi_checkFsmForReady())
+    {
+        sup_wait_poll();
+    }
+    sup_wait_end();
+    EDIS;
+
+    return((Fapi_Status_Success == status) && (0 == Fapi_getFsmStatus()));
+}
+
+//
+// flog_hw_program - Program one 128-bit word with ECC, wait for the state
+// machine
+//
+uint16_t flog_hw_program(uint32_t address, const uint16_t *data)
+{
+    Fapi_StatusType status;
+
+    EALLOW;
+    Fapi_setupBankSectorEnable(FLASH_WRAPPER_PROGRAM_BASE + FLASH_O_CMDWEPROTA,
+                               0xFFFFFFFFUL);
+    Fapi_setupBankSectorEnable(FLASH_WRAPPER_PROGRAM_BASE + FLASH_O_CMDWEPROTB,
+                               FLOG_WEPROTB_OPEN);
+    status = Fapi_issueProgrammingCommand((uint32 *)address, (uint16 *)data,
+                                          FLOG_FLASH_WORDS, 0, 0,
+                                          Fapi_AutoEccGeneration);
+    sup_wait_begin();
+    while(Fapi_Status_FsmReady != Fapi_checkFsmForReady())
+    {
+        sup_wait_poll();
+    }
+    sup_wait_end();
+    EDIS;
+
+    return((Fapi_Status_Success == status) && (0 == Fapi_getFsmStatus()));
+}
+#endif
+
+//
+// End of File
+//
@@ -0,0 +1,138 @@
+//#############################################################################
+//
+// FILE: flash_log.h
+//
+// TITLE: Persistent fault and session log in on-chip flash
+//
+// DESCRIPTION:
+// Fixed-size records are queued in a RAM ring by flog_append() and written
+// to flash sectors 64..127 (0x090000..0x09FFFF) by flog_poll() from the
+// background loop, one flash operation per call. flog_append() builds the
+// record and its CRC with the interrupts enabled and masks them only to
+// copy the record into the ring, so logging never costs a conversion.
+//
+// Layout: every sector starts with a header slot (sector sequence number
+// and erase count) followed by FLOG_RECORDS_PER_SECTOR record slots of
+// FLOG_RECORD_WORDS words. The sectors are used as one circular log: when
+// the current sector is full, the next one (holding the oldest records) is
+// erased and gets a header with the next sequence number. Every sector is
+// erased exactly once per turn of the log, which spreads the wear evenly.
+//
+// Power-fail safety: a record is programmed in two 128-bit writes and its
+// last word is a CRC over the rest, so a write cut short by a power loss
+// leaves a slot that fails the CRC and is skipped. At start-up flog_init()
+// finds the sector with the highest valid sequence number and continues
+// after its last programmed slot. A sector whose header did not make it
+// is treated as erased and reused.
+//
+// Records are stamped in microseconds of the time base (timebase.h), the
+// clock of the acquisition block and gap stamps and of the CP level
+// changes, so log entries and samples line up.
+//
+// Flash programming only runs in the CPU1_FLASH build (FLOG_USE_FLASH),
+// with the TI Flash API executing from RAM (.TI.ramfunc). The background
+// loop waits for each operation to finish: about 50 us for a record, one
+// sector erase for a sector change. The wait keeps the watchdog serviced
+// and the background tasks credited (sup_wait_poll(), supervisor.h) as
+// long as the acquisition runs and the wait stays within
+// SUP_DEADLINE_FLASH_MS. The single flash bank cannot be read
+// meanwhile, so everything an enabled ISR executes or reads must be RAM
+// resident: the ISRs and fr_push()/fr_trigger() are in HotIsr and their
+// inline helpers are always inlined. In the RAM build the ring keeps the
+// newest FLOG_RAM_RECORDS records and nothing is written.
+//
+//#############################################################################
+
+#ifndef _flash_log_h
+#define _flash_log_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#ifndef FLOG_USE_FLASH
+#if defined(_FLASH)
+#define FLOG_USE_FLASH          1
+#else
+#define FLOG_USE_FLASH          0
+#endif
+#endif
+
+#define FLOG_BASE               0x090000UL  // Sector 64
+#define FLOG_NUM_SECTORS        64U         // Sectors 64..127
+#define FLOG_SECTOR_WORDS       0x400U
+#define FLOG_RECORD_WORDS       16U         // Two 128-bit flash words
+#define FLOG_RECORDS_PER_SECTOR ((FLOG_SECTOR_WORDS / FLOG_RECORD_WORDS) - 2U)
+                                            // Header slot, and the last slot
+                                            // of sector 127 is reserved
+#define FLOG_RAM_RECORDS        8U
+
+#define FLOG_RECORD_MAGIC       0xC5A2U     // 0xC5A1: timeMs records
+#define FLOG_SECTOR_MAGIC       0x5EC7U
+
+//
+// Record types
+//
+#define FLOG_EV_BOOT            1   // a: reset cause, b: boot count,
+                                    // c: lockup, d: watchdog resets
+#define FLOG_EV_SUP_TRIP        2   // a: failed tasks, b: hang to safe ms,
+                                    // c: trips since power-on
+#define FLOG_EV_CP_STATE        3   // a: old CP_LEVEL_*, b: new CP_LEVEL_*
+#define FLOG_EV_FR_CAPTURE      4   // a: channel, b: cause, c: sequence
+                                    // (mains sag, CP out of band)
+#define FLOG_EV_DERATE          5   // a: rating, b: temperature Q4
+#define FLOG_EV_SUMMARY         6   // a: max temperature Q4, b: rating,
+                                    // c: trigger count, d: dropped triggers
+#define FLOG_EV_ADC_GAP         7   // a: channel, b: lost conversions,
+                                    // c: store position, d: block number
+#define FLOG_EV_CP_WIRING       8   // a: CPC_FAULT_*, b: high plateau
+                                    // difference mV, c: low plateau
+                                    // difference mV, d: amplitude ratio 0.1 %
+#define FLOG_EV_ADC_BIST        9   // a: ADC_BIST_FAULT_*, b: VREFLO code,
+                                    // c: VREFHI/2 code, d: offset drift Q4
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t type;
+    uint32_t sequence;      // Record number since the log was created
+    uint64_t timeUs;        // Since boot, time base (timebase.h)
+    uint16_t bootCount;
+    uint16_t arg[6];
+    uint16_t crc;           // CRC-16/CCITT of the words above, written last
+} FlogRecord;
+
+//
+// Globals
+//
+extern volatile uint32_t flog_sequence;     // Next record number
+extern uint16_t flog_sector;                // Sector being filled (0..63)
+extern uint16_t flog_slot;                  // Next free slot in it
+extern uint32_t flog_written;
+extern uint16_t flog_dropped;               // Ring full
+extern uint16_t flog_errors;                // Erase/program/verify failures
+extern uint16_t flog_flashReady;            // Flash API initialized
+
+//
+// Function Prototypes
+//
+void flog_init(uint16_t bootCount);
+void flog_append(uint16_t type, uint16_t a, uint16_t b, uint16_t c,
+                 uint16_t d);
+void flog_poll(void);
+uint32_t flog_time_ms(void);
+uint16_t flog_crc(const uint16_t *words, uint16_t count);
+
+//
+// Flash primitives, also used by params.c. Background only, after
+// flog_init(); each call blocks until the flash state machine is done,
+// with the supervisor serviced from RAM.
+// flog_hw_program() writes 8 words at an 8-word aligned address.
+//
+#if FLOG_USE_FLASH
+uint16_t flog_hw_erase(uint32_t address);
+uint16_t flog_hw_program(uint32_t address, const uint16_t *data);
+#endif
+
+#endif
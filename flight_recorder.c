@@ -0,0 +1,299 @@
+//#############################################################################
+//
+// FILE: flight_recorder.c
+//
+// TITLE: Pre-trigger event capture ("flight recorder") for the ADC channels
+//
+// DESCRIPTION:
+// fr_push() is called from the ADC ISRs with every new sample. It feeds the
+// per-channel history ring, completes any capture in progress and evaluates
+// the band and sag triggers. Other causes (CP state change, ADC overflow)
+// are reported through fr_trigger(). Captures are read from the background
+// loop with fr_find_ready()/fr_get_capture() (telemetry.c streams them over
+// CAN) and handed back with fr_release_capture().
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "flight_recorder.h"
+#include "memory_plan.h"
+#include "sysclk.h"
+
+//
+// Globals
+//
+#pragma DATA_SECTION(fr_slots, "SampleStore");
+#pragma DATA_SECTION(fr_channels, "SampleStore");
+FR_Slot fr_slots[FR_NUM_SLOTS];
+FR_Channel fr_channels[FR_NUM_CHANNELS];
+volatile uint32_t fr_triggerCount;
+volatile uint32_t fr_droppedTriggers;
+
+PLAN_CHECK(flight_recorder,
+           (sizeof(fr_slots) + sizeof(fr_channels)) <= PLAN_FLIGHT_RECORDER_WORDS);
+
+//
+// fr_push runs in every ADC ISR, fr_trigger from it: both must not touch
+// flash while flash_log.c programs it
+//
+#pragma CODE_SECTION(fr_push, "HotIsr");
+#pragma CODE_SECTION(fr_trigger, "HotIsr");
+
+//
+// fr_init - Clear all history and release every capture slot.
+//
+void fr_init(void)
+{
+    uint16_t i;
+
+    memset(fr_slots, 0, sizeof(fr_slots));
+    memset(fr_channels, 0, sizeof(fr_channels));
+
+    for(i = 0; i < FR_NUM_CHANNELS; i++)
+    {
+        fr_channels[i].recordingSlot = -1;
+    }
+
+    fr_triggerCount = 0;
+    fr_droppedTriggers = 0;
+}
+
+//
+// fr_set_band - Arm the band trigger of a channel. A capture is taken the
+// first time a sample leaves [low, high]; the trigger re-arms once the
+// signal is back inside the band.
+//
+void fr_set_band(uint16_t channel, uint16_t low, uint16_t high)
+{
+    FR_Channel *ch = &fr_channels[channel];
+
+    ch->bandLow = low;
+    ch->bandHigh = high;
+    ch->outOfBand = 0;
+    ch->bandEnabled = 1;
+}
+
+//
+// fr_set_sag - Arm the sag trigger of a channel. The peak deviation from
+// mid is measured over one FR_MAINS_HZ period, rounded up to whole samples
+// of samplePeriodTicks (TBPRD + 1); a capture is taken the first window
+// the peak falls below threshold.
+//
+void fr_set_sag(uint16_t channel, uint16_t mid, uint16_t threshold,
+                uint16_t samplePeriodTicks)
+{
+    FR_Channel *ch = &fr_channels[channel];
+    uint32_t ticks = FR_MAINS_HZ * (uint32_t)samplePeriodTicks;
+
+    ch->sagWindow = (uint16_t)((TBCLK_HZ + ticks - 1UL) / ticks);
+    ch->sagMid = mid;
+    ch->sagThreshold = threshold;
+    ch->sagPeak = 0;
+    ch->sagCount = 0;
+    ch->sagActive = 0;
+    ch->sagEnabled = 1;
+}
+
+//
+// fr_push - Store one sample. Must be called from the ISR of the channel.
+//
+void fr_push(uint16_t channel, uint16_t sample)
+{
+    FR_Channel *ch = &fr_channels[channel];
+    FR_Slot *slot;
+    uint16_t cause = FR_CAUSE_NONE;
+    uint16_t deviation;
+
+    //
+    // Complete a capture in progress
+    //
+    if(ch->recordingSlot >= 0)
+    {
+        slot = &fr_slots[ch->recordingSlot];
+        slot->samples[FR_PRE_SAMPLES + slot->postCount] = sample;
+        slot->postCount++;
+
+        if(FR_POST_SAMPLES <= slot->postCount)
+        {
+            ch->recordingSlot = -1;
+            slot->state = FR_SLOT_READY;
+        }
+    }
+
+    //
+    // History ring
+    //
+    ch->history[ch->head] = sample;
+    ch->head = (ch->head + 1) & (FR_PRE_SAMPLES - 1);
+
+    //
+    // Band trigger (CP plateau out of range)
+    //
+    if(ch->bandEnabled)
+    {
+        if((sample < ch->bandLow) || (sample > ch->bandHigh))
+        {
+            if(!ch->outOfBand)
+            {
+                ch->outOfBand = 1;
+                cause = FR_CAUSE_PLATEAU_BAND;
+            }
+        }
+        else
+        {
+            ch->outOfBand = 0;
+        }
+    }
+
+    //
+    // Sag trigger (mains peak too low over one period)
+    //
+    if(ch->sagEnabled)
+    {
+        deviation = (sample >= ch->sagMid) ? (sample - ch->sagMid) :
+                                             (ch->sagMid - sample);
+        if(deviation > ch->sagPeak)
+        {
+            ch->sagPeak = deviation;
+        }
+
+        if(ch->sagWindow <= ++ch->sagCount)
+        {
+            if(ch->sagPeak < ch->sagThreshold)
+            {
+                if(!ch->sagActive)
+                {
+                    ch->sagActive = 1;
+                    cause = FR_CAUSE_MAINS_SAG;
+                }
+            }
+            else
+            {
+                ch->sagActive = 0;
+            }
+            ch->sagPeak = 0;
+            ch->sagCount = 0;
+        }
+    }
+
+    if(FR_CAUSE_NONE != cause)
+    {
+        fr_trigger(channel, cause);
+    }
+}
+
+//
+// fr_trigger - Freeze the history of a channel into a free slot and start
+// the post-trigger recording. Returns 1 when a capture was started, 0 when
+// the channel is already recording or no slot is free.
+//
+uint16_t fr_trigger(uint16_t channel, uint16_t cause)
+{
+    FR_Channel *ch = &fr_channels[channel];
+    FR_Slot *slot;
+    int16_t freeSlot = -1;
+    uint16_t i, idx, intState;
+
+    if(ch->recordingSlot >= 0)
+    {
+        fr_droppedTriggers++;
+        return 0;
+    }
+
+    //
+    // Claim a slot. The ADC ISRs of different channels may trigger at the
+    // same time once interrupt nesting is enabled.
+    //
+    intState = __disable_interrupts();
+    for(i = 0; i < FR_NUM_SLOTS; i++)
+    {
+        if(FR_SLOT_FREE == fr_slots[i].state)
+        {
+            fr_slots[i].state = FR_SLOT_RECORDING;
+            fr_slots[i].sequence = ++fr_triggerCount;
+            freeSlot = (int16_t)i;
+            break;
+        }
+    }
+    if(freeSlot < 0)
+    {
+        fr_droppedTriggers++;
+    }
+    __restore_interrupts(intState);
+
+    if(freeSlot < 0)
+    {
+        return 0;
+    }
+
+    slot = &fr_slots[freeSlot];
+    slot->channel = channel;
+    slot->cause = cause;
+    slot->postCount = 0;
+
+    //
+    // Unroll the history, oldest sample first. head points at the oldest
+    // entry once the ring has wrapped.
+    //
+    idx = ch->head;
+    for(i = 0; i < FR_PRE_SAMPLES; i++)
+    {
+        slot->samples[i] = ch->history[idx];
+        idx = (idx + 1) & (FR_PRE_SAMPLES - 1);
+    }
+
+    ch->recordingSlot = freeSlot;
+
+    return 1;
+}
+
+//
+// fr_find_ready - Return the index of the oldest completed capture, or -1.
+//
+int16_t fr_find_ready(void)
+{
+    int16_t found = -1;
+    uint16_t i;
+
+    for(i = 0; i < FR_NUM_SLOTS; i++)
+    {
+        if((FR_SLOT_READY == fr_slots[i].state) &&
+           ((found < 0) || (fr_slots[i].sequence < fr_slots[found].sequence)))
+        {
+            found = (int16_t)i;
+        }
+    }
+
+    return found;
+}
+
+//
+// fr_get_capture - Return a completed capture, or 0 if the slot is not ready.
+//
+const FR_Slot *fr_get_capture(uint16_t slot)
+{
+    if((FR_NUM_SLOTS <= slot) || (FR_SLOT_READY != fr_slots[slot].state))
+    {
+        return 0;
+    }
+
+    return &fr_slots[slot];
+}
+
+//
+// fr_release_capture - Hand a completed capture back to the recorder.
+//
+void fr_release_capture(uint16_t slot)
+{
+    if((slot < FR_NUM_SLOTS) && (FR_SLOT_READY == fr_slots[slot].state))
+    {
+        fr_slots[slot].state = FR_SLOT_FREE;
+    }
+}
+
+//
+// End of File
+//
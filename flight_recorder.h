@@ -0,0 +1,118 @@
+//#############################################################################
+//
+// FILE: flight_recorder.h
+//
+// TITLE: Pre-trigger event capture ("flight recorder") for the ADC channels
+//
+// DESCRIPTION:
+// Each channel keeps a short circular history. When a trigger fires, the
+// last FR_PRE_SAMPLES samples are frozen into a free capture slot and the
+// next FR_POST_SAMPLES samples are appended to it. Completed slots stay
+// untouched until they are read out and released: over CAN with
+// TLM_OP_FR_READ (telemetry.h), or by a debugger from fr_slots[] followed
+// by fr_release_capture(). With all slots full further triggers are
+// counted in fr_droppedTriggers.
+//
+//#############################################################################
+
+#ifndef _flight_recorder_h
+#define _flight_recorder_h
+
+#include <stdint.h>
+#include "channels.h"
+
+//
+// Defines
+//
+#define FR_NUM_CHANNELS     NUM_CHANNELS
+#define FR_NUM_SLOTS        4
+#define FR_PRE_SAMPLES      64      // Must be a power of two (history ring)
+#define FR_POST_SAMPLES     192
+#define FR_SLOT_SAMPLES     (FR_PRE_SAMPLES + FR_POST_SAMPLES)
+
+#define FR_CH_IN_ADC_500VAC CH_IN_ADC_500VAC
+#define FR_CH_IN_CP_ADC     CH_IN_CP_ADC
+#define FR_CH_IN_CP_BORNE   CH_IN_CP_BORNE
+
+//
+// Mains sag detection window: one period of FR_MAINS_HZ, in samples of the
+// current sample period (fr_set_sag())
+//
+#define FR_MAINS_HZ         50UL
+
+//
+// Trigger causes
+//
+#define FR_CAUSE_NONE           0
+#define FR_CAUSE_CP_STATE       1   // CP state change (reported by the decoder)
+#define FR_CAUSE_PLATEAU_BAND   2   // CP sample left the configured band
+#define FR_CAUSE_MAINS_SAG      3   // Mains peak below the sag threshold
+#define FR_CAUSE_OVERFLOW       4   // ADC interrupt overflow
+#define FR_CAUSE_MANUAL         5
+
+//
+// Slot states
+//
+#define FR_SLOT_FREE        0
+#define FR_SLOT_RECORDING   1
+#define FR_SLOT_READY       2
+
+typedef struct
+{
+    volatile uint16_t state;
+    uint16_t channel;
+    uint16_t cause;
+    uint16_t postCount;                     // Post-trigger samples stored
+    uint32_t sequence;                      // Capture number, 1-based
+    uint16_t samples[FR_SLOT_SAMPLES];      // Oldest sample first
+} FR_Slot;
+
+typedef struct
+{
+    uint16_t history[FR_PRE_SAMPLES];
+    uint16_t head;                          // Next write position
+    int16_t  recordingSlot;                 // -1 when not recording
+
+    //
+    // Band trigger: fires once when a sample leaves [bandLow, bandHigh]
+    //
+    uint16_t bandEnabled;
+    uint16_t bandLow;
+    uint16_t bandHigh;
+    uint16_t outOfBand;
+
+    //
+    // Sag trigger: fires when the peak deviation from sagMid over one
+    // window of sagWindow samples drops below sagThreshold
+    //
+    uint16_t sagEnabled;
+    uint16_t sagWindow;
+    uint16_t sagMid;
+    uint16_t sagThreshold;
+    uint16_t sagPeak;
+    uint16_t sagCount;
+    uint16_t sagActive;
+} FR_Channel;
+
+//
+// Globals
+//
+extern FR_Slot fr_slots[FR_NUM_SLOTS];
+extern FR_Channel fr_channels[FR_NUM_CHANNELS];
+extern volatile uint32_t fr_triggerCount;
+extern volatile uint32_t fr_droppedTriggers;
+
+//
+// Function Prototypes
+//
+void fr_init(void);
+void fr_set_band(uint16_t channel, uint16_t low, uint16_t high);
+void fr_set_sag(uint16_t channel, uint16_t mid, uint16_t threshold,
+                uint16_t samplePeriodTicks);
+void fr_push(uint16_t channel, uint16_t sample);
+uint16_t fr_trigger(uint16_t channel, uint16_t cause);
+int16_t fr_find_ready(void);
+const FR_Slot *fr_get_capture(uint16_t slot);
+void fr_release_capture(uint16_t slot);
+
+#endif
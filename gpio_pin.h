@@ -0,0 +1,76 @@
+//#############################################################################
+//
+// FILE: gpio_pin.h
+//
+// TITLE: Compile-time GPIO pin access
+//
+// DESCRIPTION:
+// GPIO_WritePin() and GPIO_ReadPin() (f280013x_gpio.c) work out the port
+// with a divide and a modulo on every call, and the bitfield form
+// GpioDataRegs.GPADAT.bit.GPIOn = x is a read-modify-write of the whole
+// port that can undo a concurrent change to another pin.
+//
+// The macros below take a constant pin number, so the port address and
+// the bit mask fold at compile time:
+//
+//     GPIO_SET(pin)       one 32-bit store to GPySET
+//     GPIO_CLEAR(pin)     one 32-bit store to GPyCLEAR
+//     GPIO_TOGGLE(pin)    one 32-bit store to GPyTOGGLE
+//     GPIO_READ(pin)      one load of GPyDAT and a mask (pin level, not latch)
+//
+// The group variants update several outputs of one port with one store
+// per direction; GPIO_PORT_CHECK() fails the build when the pins of a group
+// are not on the same port.
+//
+//#############################################################################
+
+#ifndef _gpio_pin_h
+#define _gpio_pin_h
+
+#include "f28x_project.h"
+
+//
+// Defines
+//
+#define GPIO_PORT(pin)              ((pin) / 32U)
+#define GPIO_MASK(pin)              (1UL << ((pin) % 32U))
+
+//
+// Data register reg (GPYDAT, GPYSET, GPYCLEAR, GPYTOGGLE) of port
+//
+#define GPIO_PORT_REG(port, reg)                                            \
+    (((volatile uint32_t *)&GpioDataRegs)[((port) * GPY_DATA_OFFSET) + (reg)])
+
+#define GPIO_SET(pin)       (GPIO_PORT_REG(GPIO_PORT(pin), GPYSET) = GPIO_MASK(pin))
+#define GPIO_CLEAR(pin)     (GPIO_PORT_REG(GPIO_PORT(pin), GPYCLEAR) = GPIO_MASK(pin))
+#define GPIO_TOGGLE(pin)    (GPIO_PORT_REG(GPIO_PORT(pin), GPYTOGGLE) = GPIO_MASK(pin))
+#define GPIO_READ(pin)                                                      \
+    ((uint16_t)((GPIO_PORT_REG(GPIO_PORT(pin), GPYDAT) & GPIO_MASK(pin)) != 0UL))
+
+#define GPIO_WRITE(pin, value)                                              \
+    do                                                                      \
+    {                                                                       \
+        if(value)                                                           \
+        {                                                                   \
+            GPIO_SET(pin);                                                  \
+        }                                                                   \
+        else                                                                \
+        {                                                                   \
+            GPIO_CLEAR(pin);                                                \
+        }                                                                   \
+    } while(0)
+
+//
+// Groups of pins on one port: mask built with GPIO_MASK()
+//
+#define GPIO_SET_GROUP(port, mask)      (GPIO_PORT_REG(port, GPYSET) = (mask))
+#define GPIO_CLEAR_GROUP(port, mask)    (GPIO_PORT_REG(port, GPYCLEAR) = (mask))
+#define GPIO_READ_GROUP(port, mask)     (GPIO_PORT_REG(port, GPYDAT) & (mask))
+
+//
+// GPIO_PORT_CHECK - Compile-time check that two pins share a port
+//
+#define GPIO_PORT_CHECK(name, a, b)                                         \
+    typedef char gpio_port_check_##name[(GPIO_PORT(a) == GPIO_PORT(b)) ? 1 : -1]
+
+#endif
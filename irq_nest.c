@@ -0,0 +1,103 @@
+//#############################################################################
+//
+// FILE: irq_nest.c
+//
+// TITLE: Nested interrupt priorities - statistics and load test
+//
+// DESCRIPTION:
+// Holds the per-ISR statistics and, with IRQ_LOAD_TEST=1, a
+// communication-level ISR on ePWM3 that keeps the CPU busy for
+// IRQ_LOAD_BURN_US every millisecond. With nesting the ADC ISRs preempt
+// it and irq_stat[IRQ_ID_LOAD].preempted counts the interruptions; with
+// IRQ_NESTING=0 the same load shows up as ADC latency and overflows.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "irq_nest.h"
+
+//
+// Globals
+//
+IrqStat irq_stat[IRQ_NUM_ISR];
+volatile uint16_t irq_active;
+volatile uint16_t irq_depth;
+
+#if IRQ_LOAD_TEST
+//
+// Function Prototypes
+//
+__interrupt void irq_load_isr(void);
+#endif
+
+//
+// irq_nest_init - Clear the statistics. Call before the ISRs are enabled.
+//
+void irq_nest_init(void)
+{
+    uint16_t i;
+
+    for(i = 0; i < IRQ_NUM_ISR; i++)
+    {
+        irq_stat[i].entries = 0;
+        irq_stat[i].preempted = 0;
+        irq_stat[i].maxDepth = 0;
+        irq_stat[i].latencyLast = 0;
+        irq_stat[i].latencyMax = 0;
+    }
+
+    irq_active = IRQ_ID_NONE;
+    irq_depth = 0;
+}
+
+//
+// irq_load_start - Start the load-test interrupt (IRQ_LOAD_TEST=1 only).
+// Call after TBCLKSYNC is set.
+//
+void irq_load_start(void)
+{
+#if IRQ_LOAD_TEST
+    EALLOW;
+    PieVectTable.EPWM3_INT = &irq_load_isr;
+
+    EPwm3Regs.TBCTL.bit.CTRMODE = 3;        // Freeze counter
+    EPwm3Regs.TBCTL.bit.HSPCLKDIV = 1;      // TBCLK = SYSCLK / 2
+    EPwm3Regs.TBCTL.bit.CLKDIV = 0;
+    EPwm3Regs.TBPRD = IRQ_LOAD_PERIOD - 1U;
+    EPwm3Regs.TBCTR = 0;
+    EPwm3Regs.ETSEL.bit.INTSEL = 1;         // Interrupt on TBCTR = 0
+    EPwm3Regs.ETPS.bit.INTPRD = 1;          // Every event
+    EPwm3Regs.ETCLR.bit.INT = 1;
+    EPwm3Regs.ETSEL.bit.INTEN = 1;
+    EPwm3Regs.TBCTL.bit.CTRMODE = 0;        // Up count
+    EDIS;
+
+    PieCtrlRegs.PIEIER3.bit.INTx3 = 1;
+    IER |= M_INT3;
+#endif
+}
+
+#if IRQ_LOAD_TEST
+//
+// irq_load_isr - Communication-level CPU load
+//
+__interrupt void irq_load_isr(void)
+{
+    IrqNestFrame frame;
+
+    irq_nest_enter(&frame, IRQ_ID_LOAD, IRQ_IER_COMM,
+                   &PieCtrlRegs.PIEIER3.all, IRQ_PIE_KEEP, PIEACK_GROUP3);
+
+    DELAY_US(IRQ_LOAD_BURN_US);
+    EPwm3Regs.ETCLR.bit.INT = 1;
+
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER3.all);
+}
+#endif
+
+//
+// End of File
+//
@@ -0,0 +1,207 @@
+//#############################################################################
+//
+// FILE: irq_nest.h
+//
+// TITLE: Nested interrupt priorities for protection, acquisition and
+//        communication ISRs
+//
+// DESCRIPTION:
+// The C28x takes no interrupt while an ISR runs unless the ISR re-enables
+// INTM. irq_nest_enter() does that after restricting IER (and, for a PIE
+// group shared between levels, the group's PIEIER) to the groups of the
+// strictly higher levels:
+//
+//     IRQ_LEVEL_PROTECT  trip zones / comparator trips   never preempted
+//     IRQ_LEVEL_ACQ      ADC, CP capture, time base      by PROTECT
+//     IRQ_LEVEL_COMM     telemetry, load test            by PROTECT, ACQ
+//
+// ISRs of the same level never preempt each other. The PIE group of the
+// running ISR is acknowledged on entry, so an ISR using irq_nest_enter()
+// must not acknowledge it again.
+//
+// Usage in an ISR:
+//
+//     IrqNestFrame frame;
+//     irq_nest_enter(&frame, IRQ_ID_ADCA2, IRQ_IER_ACQ,
+//                    &PieCtrlRegs.PIEIER10.all, IRQ_PIE_KEEP,
+//                    PIEACK_GROUP10);
+//     ...
+//     irq_nest_exit(&frame, &PieCtrlRegs.PIEIER10.all);
+//
+// Build with IRQ_NESTING=0 to keep INTM set for the whole ISR (the old
+// behaviour); the bookkeeping and statistics are kept either way.
+//
+// Each ISR has an IrqStat record in irq_stat[]: entries, the number of
+// times it was preempted, the deepest nesting seen and, for the ADC ISRs,
+// the trigger-to-entry latency in TBCLK ticks (16.7 ns). Building with
+// IRQ_LOAD_TEST=1 adds a communication-level ISR on ePWM3 that burns
+// IRQ_LOAD_BURN_US every millisecond, for measuring the worst-case
+// acquisition latency under load.
+//
+//#############################################################################
+
+#ifndef _irq_nest_h
+#define _irq_nest_h
+
+#include "f28x_project.h"
+
+//
+// Defines
+//
+#ifndef IRQ_NESTING
+#define IRQ_NESTING             1
+#endif
+
+#ifndef IRQ_LOAD_TEST
+#define IRQ_LOAD_TEST           0
+#endif
+#define IRQ_LOAD_BURN_US        200U
+#define IRQ_LOAD_PERIOD         60000U      // TBCLK ticks, 1 ms
+
+#define IRQ_LEVEL_PROTECT       0
+#define IRQ_LEVEL_ACQ           1
+#define IRQ_LEVEL_COMM          2
+
+//
+// CPU interrupt groups served at each level
+//
+#define IRQ_GROUPS_PROTECT      (M_INT2)                    // ePWM TZ
+#define IRQ_GROUPS_ACQ          (M_INT1 | M_INT4 | M_INT10 | M_INT13)
+#define IRQ_GROUPS_COMM         (M_INT3 | M_INT9)           // Load test, CAN
+
+//
+// IER while an ISR of a level runs: only strictly higher levels
+//
+#define IRQ_IER_PROTECT         0U
+#define IRQ_IER_ACQ             (IRQ_GROUPS_PROTECT)
+#define IRQ_IER_COMM            (IRQ_GROUPS_PROTECT | IRQ_GROUPS_ACQ)
+
+//
+// PIEIER mask for an ISR whose group holds no source of a higher level
+//
+#define IRQ_PIE_KEEP            0xFFFFU
+
+//
+// ISR identifiers (index of irq_stat[])
+//
+#define IRQ_ID_ADCA1            0           // adcA1ISR - IN_ADC_500VAC
+#define IRQ_ID_ADCA2            1           // adcA2ISR - IN_CP_ADC
+#define IRQ_ID_ADCA3            2           // adcA3ISR - IN_CP_BORNE
+#define IRQ_ID_LOAD             3           // irq_load_isr
+#define IRQ_ID_CAN              4           // tlm_isr - CAN telemetry
+#define IRQ_ID_ECAP1            5           // cp_ecap_isr - CP capture
+#define IRQ_NUM_ISR             6
+#define IRQ_ID_NONE             0xFFFFU     // Background
+
+typedef struct
+{
+    uint32_t entries;
+    uint32_t preempted;     // Times a higher level interrupted this ISR
+    uint16_t maxDepth;      // Deepest nesting level on entry (1 = none)
+    uint16_t latencyLast;   // Trigger to entry, TBCLK ticks
+    uint16_t latencyMax;
+} IrqStat;
+
+typedef struct
+{
+    uint16_t ier;
+    uint16_t pieier;
+    uint16_t prevActive;
+} IrqNestFrame;
+
+//
+// Globals
+//
+extern IrqStat irq_stat[IRQ_NUM_ISR];
+extern volatile uint16_t irq_active;        // ISR being serviced
+extern volatile uint16_t irq_depth;
+
+//
+// Function Prototypes
+//
+void irq_nest_init(void);
+void irq_load_start(void);
+
+//
+// irq_nest_enter - Account the entry of ISR id, mask everything but the
+// higher levels and re-enable interrupts.
+//
+#pragma FUNC_ALWAYS_INLINE(irq_nest_enter)
+static inline void irq_nest_enter(IrqNestFrame *frame, uint16_t id,
+                                  uint16_t ierMask, volatile uint16_t *pieier,
+                                  uint16_t pieMask, uint16_t ackGroup)
+{
+    IrqStat *stat = &irq_stat[id];
+
+    frame->ier = IER;
+    frame->pieier = *pieier;
+    frame->prevActive = irq_active;
+
+    if(IRQ_ID_NONE != irq_active)
+    {
+        irq_stat[irq_active].preempted++;
+    }
+    irq_active = id;
+    irq_depth++;
+
+    stat->entries++;
+    if(irq_depth > stat->maxDepth)
+    {
+        stat->maxDepth = irq_depth;
+    }
+
+    IER &= ierMask;
+    *pieier &= pieMask;
+    PieCtrlRegs.PIEACK.all = ackGroup;
+
+#if IRQ_NESTING
+    __asm(" NOP");                          // Let the PIEACK write complete
+    EINT;
+#endif
+}
+
+//
+// irq_nest_exit - Mask interrupts again and restore the masks saved on entry
+//
+#pragma FUNC_ALWAYS_INLINE(irq_nest_exit)
+static inline void irq_nest_exit(IrqNestFrame *frame, volatile uint16_t *pieier)
+{
+    DINT;
+    *pieier = frame->pieier;
+    IER = frame->ier;
+
+    irq_depth--;
+    irq_active = frame->prevActive;
+}
+
+//
+// irq_latency_record - Trigger-to-entry latency of an ePWM triggered ISR.
+// counter is TBCTR read on entry, socAt the counter value of the SOC event
+// and period the TBPRD of the up-counting ePWM. Returns the latency.
+//
+#pragma FUNC_ALWAYS_INLINE(irq_latency_record)
+static inline uint16_t irq_latency_record(uint16_t id, uint16_t counter,
+                                      uint16_t socAt, uint16_t period)
+{
+    IrqStat *stat = &irq_stat[id];
+    uint16_t ticks;
+
+    if(counter >= socAt)
+    {
+        ticks = counter - socAt;
+    }
+    else
+    {
+        ticks = counter + period + 1U - socAt;
+    }
+
+    stat->latencyLast = ticks;
+    if(ticks > stat->latencyMax)
+    {
+        stat->latencyMax = ticks;
+    }
+
+    return ticks;
+}
+
+#endif
@@ -0,0 +1,142 @@
+//#############################################################################
+//
+// FILE: mains_meas.c
+//
+// TITLE: Mains RMS voltage and frequency from the 500 VAC samples
+//
+// DESCRIPTION:
+// Background half of the mains measurement: square root, scaling to volts
+// with the 500 VAC calibration and the frequency from the cycle length.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "mains_meas.h"
+#include "adc_cal.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define MAINS_TBCLK_HZ          ((uint64_t)TBCLK_HZ)   // ePWM1 time base
+
+//
+// Globals
+//
+MainsAcc mains_acc;
+volatile uint32_t mains_cycleSumSq;
+volatile uint16_t mains_cycleCount;
+volatile uint16_t mains_cycleReady;
+uint16_t mains_rmsDv;
+uint16_t mains_freqCHz;
+uint32_t mains_cycles;
+
+static uint16_t mains_periodTicks;
+
+//
+// Function Prototypes
+//
+static uint32_t mains_isqrt(uint32_t x);
+
+//
+// mains_meas_init - Take the mid-scale from the 500 VAC calibration. Call
+// after adc_cal_init(), before adcA1ISR is enabled. samplePeriodTicks is
+// the ePWM1 period in TBCLK ticks.
+//
+void mains_meas_init(uint16_t samplePeriodTicks)
+{
+    const AdcCal *cal = &adc_cal[CH_IN_ADC_500VAC];
+
+    mains_periodTicks = samplePeriodTicks;
+
+    mains_acc.sumSq = 0;
+    mains_acc.count = 0;
+    mains_acc.mid = (uint16_t)((cal->offset + 8) >> 4);
+    mains_acc.positive = 0;
+    mains_acc.synced = 0;
+
+    mains_cycleReady = 0;
+    mains_rmsDv = 0;
+    mains_freqCHz = 0;
+    mains_cycles = 0;
+}
+
+//
+// mains_meas_poll - Background task. Converts the last complete cycle.
+// Returns 1 if a cycle was processed.
+//
+uint16_t mains_meas_poll(void)
+{
+    const AdcCal *cal = &adc_cal[CH_IN_ADC_500VAC];
+    uint32_t sumSq, rmsQ4;
+    uint16_t count, intState;
+    int64_t mv;
+
+    if(0 == mains_cycleReady)
+    {
+        return 0;
+    }
+
+    intState = __disable_interrupts();
+    sumSq = mains_cycleSumSq;
+    count = mains_cycleCount;
+    mains_cycleReady = 0;
+    __restore_interrupts(intState);
+
+    if(0 == count)
+    {
+        mains_rmsDv = 0;
+        mains_freqCHz = 0;
+        return 1;
+    }
+
+    //
+    // mean of d^2 >> 4, times 4096, is (16 * rms)^2
+    //
+    rmsQ4 = mains_isqrt((sumSq / count) << 12);
+    mv = ((int64_t)rmsQ4 * cal->gain) >> (cal->shift + 4);
+    mains_rmsDv = (uint16_t)(mv / 100);
+
+    mains_freqCHz = (uint16_t)((MAINS_TBCLK_HZ * 100ULL) /
+                               ((uint32_t)mains_periodTicks * count));
+    mains_cycles++;
+
+    return 1;
+}
+
+//
+// mains_isqrt - Integer square root, bit by bit
+//
+static uint32_t mains_isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+
+    while(0 != bit)
+    {
+        if(x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,114 @@
+//#############################################################################
+//
+// FILE: mains_meas.h
+//
+// TITLE: Mains RMS voltage and frequency from the 500 VAC samples
+//
+// DESCRIPTION:
+// mains_meas_push() runs in adcA1ISR for every sample: it accumulates the
+// squared deviation from the calibrated mid-scale and closes a cycle at
+// each positive-going crossing (with MAINS_HYSTERESIS counts of
+// hysteresis). The sum and length of the last complete cycle are handed
+// to the background, where mains_meas_poll() turns them into RMS volts
+// and frequency; the square root and divides never run in the ISR.
+//
+// Without crossings for MAINS_MAX_SAMPLES samples (no mains, or below
+// ~24 Hz) the cycle is closed anyway and reported as no mains.
+//
+// After lost conversions (acq_gap.h) mains_meas_gap() drops the cycle in
+// progress, so no RMS or frequency is computed across the gap.
+//
+//#############################################################################
+
+#ifndef _mains_meas_h
+#define _mains_meas_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define MAINS_HYSTERESIS        64          // Counts, ~25 V at the divider
+#define MAINS_MAX_SAMPLES       4000U       // Longest cycle accepted
+#define MAINS_SQ_SHIFT          4U          // Square scaling, no overflow
+                                            // over MAINS_MAX_SAMPLES
+
+typedef struct
+{
+    uint32_t sumSq;         // Sum of (deviation^2 >> MAINS_SQ_SHIFT)
+    uint16_t count;         // Samples in the cycle
+    uint16_t mid;           // 0 V in counts
+    uint16_t positive;      // Above +hysteresis since the last crossing
+    uint16_t synced;        // A crossing was seen, count is a full cycle
+} MainsAcc;
+
+//
+// Globals
+//
+extern MainsAcc mains_acc;
+extern volatile uint32_t mains_cycleSumSq;  // Last complete cycle
+extern volatile uint16_t mains_cycleCount;  // 0: no mains
+extern volatile uint16_t mains_cycleReady;
+extern uint16_t mains_rmsDv;                // RMS, 0.1 V
+extern uint16_t mains_freqCHz;              // Frequency, 0.01 Hz
+extern uint32_t mains_cycles;
+
+//
+// Function Prototypes
+//
+void mains_meas_init(uint16_t samplePeriodTicks);
+uint16_t mains_meas_poll(void);
+
+//
+// mains_meas_push - Account one sample of the 500 VAC channel.
+//
+#pragma FUNC_ALWAYS_INLINE(mains_meas_push)
+static inline void mains_meas_push(uint16_t sample)
+{
+    MainsAcc *acc = &mains_acc;
+    int16_t d = (int16_t)sample - (int16_t)acc->mid;
+    uint16_t close = 0;
+
+    acc->sumSq += ((uint32_t)((int32_t)d * d)) >> MAINS_SQ_SHIFT;
+    acc->count++;
+
+    if(d < -MAINS_HYSTERESIS)
+    {
+        acc->positive = 0;
+    }
+    else if((d > MAINS_HYSTERESIS) && (0 == acc->positive))
+    {
+        acc->positive = 1;
+        close = 1;
+    }
+
+    if(close || (acc->count >= MAINS_MAX_SAMPLES))
+    {
+        if(close && (0 == acc->synced))
+        {
+            acc->synced = 1;                // First crossing, partial cycle
+        }
+        else
+        {
+            mains_cycleSumSq = acc->sumSq;
+            mains_cycleCount = close ? acc->count : 0U;
+            mains_cycleReady = 1;
+            acc->synced = close;
+        }
+        acc->sumSq = 0;
+        acc->count = 0;
+    }
+}
+
+//
+// mains_meas_gap - Conversions were lost: restart at the next crossing
+//
+#pragma FUNC_ALWAYS_INLINE(mains_meas_gap)
+static inline void mains_meas_gap(void)
+{
+    mains_acc.sumSq = 0;
+    mains_acc.count = 0;
+    mains_acc.synced = 0;
+}
+
+#endif
@@ -0,0 +1,85 @@
+//#############################################################################
+//
+// FILE: memory_plan.h
+//
+// TITLE: RAM budget of the application sections
+//
+// DESCRIPTION:
+// The linker command files place the application data and code in named
+// sections:
+//
+//   SampleStore   - packed channel buffers, flight recorder   -> RAMLS1
+//   TelemetryRing - rings drained by the background/telemetry -> RAMM1
+//   NoInit        - records kept across warm resets           -> RAMM1
+//                   (TYPE = NOINIT, never cleared by the C start-up)
+//   HotIsr        - ADC ISRs and the per-sample kernels       -> RAMM0 (RAM)
+//                   Flash build: loaded in flash and copied to RAMLS0 at
+//                   boot with .TI.ramfunc, so it runs without wait states
+//
+// Tag a function as RAM-resident with
+//     #pragma CODE_SECTION(function, "HotIsr");
+//
+// Buffer sizes are derived from the budgets below, so growing a budget
+// grows the buffers with it. The checks at the end fail the compile when
+// the budgets no longer fit the physical memory, instead of leaving it to
+// a link error. Keep the PLAN_*_WORDS lengths in sync with the MEMORY
+// blocks of 280013x_generic_ram_lnk.cmd and 280013x_generic_flash_lnk.cmd.
+//
+// The headroom left in each section is reported after every build by
+// tools/mem_report.py (post-build step of both configurations).
+//
+//#############################################################################
+
+#ifndef _memory_plan_h
+#define _memory_plan_h
+
+//
+// Physical memory (16-bit words)
+//
+#define PLAN_RAMLS1_WORDS           0x1FF8U
+#define PLAN_RAMM1_WORDS            0x03F8U
+#define PLAN_STACK_WORDS            0x0200U     // Linker STACK_SIZE
+
+//
+// Section budgets (16-bit words)
+//
+#define PLAN_SAMPLESTORE_WORDS      0x1000U     // Half of RAMLS1, rest for .text
+#define PLAN_TELEMETRY_WORDS        0x01E0U     // RAMM1 above the stack
+#define PLAN_NOINIT_WORDS           0x0010U     // Rest of RAMM1
+
+//
+// Part of SampleStore reserved for the flight recorder slots and history
+//
+#define PLAN_FLIGHT_RECORDER_WORDS  0x0540U
+
+//
+// Derived sizes: three packed channel buffers share what is left of the
+// SampleStore budget (4 samples per 3 words)
+//
+#define PLAN_STORE_WORDS_PER_CHANNEL \
+    ((PLAN_SAMPLESTORE_WORDS - PLAN_FLIGHT_RECORDER_WORDS) / 3U)
+#define PLAN_STORE_SAMPLES_PER_CHANNEL \
+    ((PLAN_STORE_WORDS_PER_CHANNEL / 3U) * 4U)
+
+//
+// Budget checks
+//
+#if (PLAN_SAMPLESTORE_WORDS > PLAN_RAMLS1_WORDS)
+#error "memory_plan.h: SampleStore budget exceeds RAMLS1"
+#endif
+
+#if ((PLAN_STACK_WORDS + PLAN_TELEMETRY_WORDS + PLAN_NOINIT_WORDS) > \
+     PLAN_RAMM1_WORDS)
+#error "memory_plan.h: stack, TelemetryRing and NoInit budgets exceed RAMM1"
+#endif
+
+#if (PLAN_FLIGHT_RECORDER_WORDS >= PLAN_SAMPLESTORE_WORDS)
+#error "memory_plan.h: flight recorder leaves no room for the channel buffers"
+#endif
+
+//
+// PLAN_CHECK - Compile-time check for conditions involving sizeof()
+//
+#define PLAN_CHECK(name, cond)  typedef char plan_check_##name[(cond) ? 1 : -1]
+
+#endif
@@ -0,0 +1,402 @@
+//#############################################################################
+//
+// FILE: params.c
+//
+// TITLE: Runtime parameter table with a versioned register map
+//
+// DESCRIPTION:
+// Parameter definitions, pending/active values, the commit rules and the
+// two-copy flash store.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "params.h"
+#include "flash_log.h"
+#include "memory_plan.h"
+#include "telemetry.h"
+#include "envelope.h"
+#include "adc_timing.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define PARAM_FLASH_WORDS       8U          // Program unit of flog_hw_program()
+#define PARAM_STORE_WORDS       (sizeof(ParamStore))
+#define PARAM_CAL_WORDS         (sizeof(AdcCalStore))
+
+//
+// Globals
+//
+const ParamDef param_defs[PARAM_COUNT] =
+{
+    //  type         flags              min                 max                 default
+    { PARAM_T_U16, PARAM_F_READONLY,  PARAM_MAP_VERSION,  PARAM_MAP_VERSION,  PARAM_MAP_VERSION },
+    { PARAM_T_U16, 0U,                TLM_PERIOD_MIN_MS,  TLM_PERIOD_MAX_MS,  TLM_STATUS_MS_DEFAULT },
+    { PARAM_T_U16, 0U,                TLM_PERIOD_MIN_MS,  TLM_PERIOD_MAX_MS,  TLM_MAINS_MS_DEFAULT },
+    { PARAM_T_U16, 0U,                0L,                 4095L,              100L },   // CP band low
+    { PARAM_T_U16, 0U,                0L,                 4095L,              3995L },  // CP band high
+    { PARAM_T_U16, 0U,                1L,                 2047L,              1400L },  // ~70 % of nominal peak
+    { PARAM_T_U16, 0U,                300L,               65534L,             625L },   // 10.4 us
+    { PARAM_T_U16, 0U,                1L,                 65534L,             312L },
+    { PARAM_T_U16, 0U,                9L,                 511L,               9L },     // 10 SYSCLK
+    { PARAM_T_U16, 0U,                2L,                 15L,                6L },     // ADCCLK /4
+    { PARAM_T_U16, 0U,                256L,               PLAN_STORE_SAMPLES_PER_CHANNEL,
+                                                                              PLAN_STORE_SAMPLES_PER_CHANNEL },
+    { PARAM_T_U16, 0U,                2L,                 ENV_CAPACITY,       ENV_WINDOW_DEFAULT }
+};
+
+int32_t param_value[PARAM_COUNT];
+uint32_t param_pendingMask;
+uint16_t param_loadStatus;
+uint16_t param_commits;
+uint16_t param_rejected;
+
+static int32_t param_pending[PARAM_COUNT];
+static uint32_t param_sequence;             // Of the newest flash copy
+static uint32_t param_storeAddr;            // Address of the newest copy
+
+PLAN_CHECK(params_store, PARAM_STORE_WORDS == (4U * PARAM_FLASH_WORDS));
+PLAN_CHECK(params_cal, PARAM_CAL_WORDS == (3U * PARAM_FLASH_WORDS));
+PLAN_CHECK(params_slots, PARAM_COUNT <= PARAM_STORE_SLOTS);
+PLAN_CHECK(params_mask, PARAM_COUNT <= 32U);
+
+//
+// Function Prototypes
+//
+static const ParamStore *params_check_copy(uint32_t address);
+static uint16_t params_in_range(uint16_t id, int32_t value);
+static uint16_t params_rules_ok(const int32_t *value);
+
+//
+// params_init - Load the defaults, then the newest valid flash copy
+//
+void params_init(void)
+{
+    const ParamStore *a = params_check_copy(PARAM_FLASH_A);
+    const ParamStore *b = params_check_copy(PARAM_FLASH_B);
+    const ParamStore *use;
+    uint16_t i;
+
+    for(i = 0; i < PARAM_COUNT; i++)
+    {
+        param_value[i] = param_defs[i].def;
+        param_pending[i] = param_defs[i].def;
+    }
+    param_pendingMask = 0;
+    param_commits = 0;
+    param_rejected = 0;
+    param_loadStatus = PARAM_LOAD_DEFAULTS;
+
+    use = a;
+    if((0 != b) && ((0 == a) || (b->sequence > a->sequence)))
+    {
+        use = b;
+    }
+
+    param_sequence = 0;
+    param_storeAddr = PARAM_FLASH_B;        // First save goes to A
+    if(0 == use)
+    {
+        return;
+    }
+    param_sequence = use->sequence;
+    param_storeAddr = (uint32_t)use;
+
+    if(PARAM_MAP_VERSION != use->version)
+    {
+        param_loadStatus = PARAM_LOAD_VERSION;
+        return;
+    }
+
+    for(i = 0; (i < use->count) && (i < PARAM_COUNT); i++)
+    {
+        if((0U == (param_defs[i].flags & PARAM_F_READONLY)) &&
+           params_in_range(i, use->value[i]))
+        {
+            param_value[i] = use->value[i];
+            param_pending[i] = use->value[i];
+        }
+    }
+    param_loadStatus = PARAM_LOAD_FLASH;
+
+    if(!params_rules_ok(param_value))
+    {
+        for(i = 0; i < PARAM_COUNT; i++)
+        {
+            param_value[i] = param_defs[i].def;
+            param_pending[i] = param_defs[i].def;
+        }
+        param_loadStatus = PARAM_LOAD_RULE;
+    }
+}
+
+//
+// params_read - Active value of a register
+//
+uint16_t params_read(uint16_t id, int32_t *value)
+{
+    if(id >= PARAM_COUNT)
+    {
+        return PARAM_ERR_ID;
+    }
+
+    *value = param_value[id];
+    return PARAM_OK;
+}
+
+//
+// params_write - Check a value against the limits and queue it for the
+// next params_commit()
+//
+uint16_t params_write(uint16_t id, int32_t value)
+{
+    if(id >= PARAM_COUNT)
+    {
+        return PARAM_ERR_ID;
+    }
+    if(param_defs[id].flags & PARAM_F_READONLY)
+    {
+        return PARAM_ERR_READONLY;
+    }
+    if(!params_in_range(id, value))
+    {
+        return PARAM_ERR_RANGE;
+    }
+
+    param_pending[id] = value;
+    param_pendingMask |= 1UL << id;
+
+    return PARAM_OK;
+}
+
+//
+// params_defaults - Queue the defaults of every register
+//
+uint16_t params_defaults(void)
+{
+    uint16_t i;
+
+    for(i = 0; i < PARAM_COUNT; i++)
+    {
+        param_pending[i] = param_defs[i].def;
+        param_pendingMask |= 1UL << i;
+    }
+
+    return PARAM_OK;
+}
+
+//
+// params_commit - Apply the pending values as one set. Call at a safe
+// point. Returns the mask of the registers whose value changed.
+//
+uint32_t params_commit(void)
+{
+    uint32_t changed = 0;
+    uint16_t i;
+
+    if(0UL == param_pendingMask)
+    {
+        return 0;
+    }
+
+    for(i = 0; i < PARAM_COUNT; i++)
+    {
+        if(0UL == (param_pendingMask & (1UL << i)))
+        {
+            param_pending[i] = param_value[i];
+        }
+    }
+    param_pendingMask = 0;
+
+    if(!params_rules_ok(param_pending))
+    {
+        for(i = 0; i < PARAM_COUNT; i++)
+        {
+            param_pending[i] = param_value[i];
+        }
+        param_rejected++;
+        return 0;
+    }
+
+    for(i = 0; i < PARAM_COUNT; i++)
+    {
+        if(param_pending[i] != param_value[i])
+        {
+            param_value[i] = param_pending[i];
+            changed |= 1UL << i;
+        }
+    }
+    param_commits++;
+
+    return changed;
+}
+
+//
+// params_save - Write the active values and the ADC calibration over the
+// older flash copy
+//
+uint16_t params_save(void)
+{
+#if FLOG_USE_FLASH
+    ParamStore store;
+    AdcCalStore cal;
+    const uint16_t *words = (const uint16_t *)&store;
+    const uint16_t *calWords = (const uint16_t *)&cal;
+    uint32_t address;
+    uint16_t i;
+
+    if(!flog_flashReady)
+    {
+        return PARAM_ERR_FLASH;
+    }
+
+    address = (PARAM_FLASH_A == param_storeAddr) ? PARAM_FLASH_B :
+                                                   PARAM_FLASH_A;
+
+    store.magic = PARAM_STORE_MAGIC;
+    store.version = PARAM_MAP_VERSION;
+    store.sequence = param_sequence + 1UL;
+    store.count = PARAM_COUNT;
+    store.reserved = 0xFFFFU;
+    for(i = 0; i < PARAM_STORE_SLOTS; i++)
+    {
+        store.value[i] = (i < PARAM_COUNT) ? param_value[i] : -1L;
+    }
+    store.pad = 0xFFFFU;
+    store.crc = flog_crc(words, PARAM_STORE_WORDS - 1U);
+    adc_cal_store(&cal);
+
+    if(!flog_hw_erase(address))
+    {
+        return PARAM_ERR_FLASH;
+    }
+
+    //
+    // The calibration first: the parameter CRC, in the last program unit
+    // of the copy header, makes the copy valid
+    //
+    for(i = 0; i < PARAM_CAL_WORDS; i += PARAM_FLASH_WORDS)
+    {
+        if(!flog_hw_program(address + PARAM_STORE_WORDS + i, &calWords[i]))
+        {
+            return PARAM_ERR_FLASH;
+        }
+    }
+    for(i = 0; i < PARAM_STORE_WORDS; i += PARAM_FLASH_WORDS)
+    {
+        if(!flog_hw_program(address + i, &words[i]))
+        {
+            return PARAM_ERR_FLASH;
+        }
+    }
+
+    if(0 == params_check_copy(address))
+    {
+        return PARAM_ERR_FLASH;
+    }
+
+    param_sequence = store.sequence;
+    param_storeAddr = address;
+
+    return PARAM_OK;
+#else
+    return PARAM_ERR_FLASH;
+#endif
+}
+
+//
+// params_cal_copy - The ADC calibration saved with the loaded parameter
+// copy, or 0 if there is none or its CRC is wrong
+//
+const AdcCalStore *params_cal_copy(void)
+{
+    const AdcCalStore *cal;
+
+    if(0 == params_check_copy(param_storeAddr))
+    {
+        return 0;
+    }
+
+    cal = (const AdcCalStore *)(param_storeAddr + PARAM_STORE_WORDS);
+    if(cal->crc != flog_crc((const uint16_t *)cal, PARAM_CAL_WORDS - 1U))
+    {
+        return 0;
+    }
+
+    return cal;
+}
+
+//
+// params_check_copy - A flash copy with a valid header and CRC, or 0
+//
+static const ParamStore *params_check_copy(uint32_t address)
+{
+    const ParamStore *store = (const ParamStore *)address;
+
+    if((PARAM_STORE_MAGIC != store->magic) ||
+       (store->count > PARAM_STORE_SLOTS) ||
+       (store->crc != flog_crc((const uint16_t *)store,
+                               PARAM_STORE_WORDS - 1U)))
+    {
+        return 0;
+    }
+
+    return store;
+}
+
+//
+// params_rules_ok - Rules between registers (params.h) of a full set
+//
+static uint16_t params_rules_ok(const int32_t *value)
+{
+    uint16_t period = (uint16_t)value[PARAM_SAMPLE_PERIOD];
+
+    if((value[PARAM_SOC_CMPA] >= value[PARAM_SAMPLE_PERIOD]) ||
+       (value[PARAM_CP_BAND_LOW] >= value[PARAM_CP_BAND_HIGH]))
+    {
+        return 0;
+    }
+
+    if(adc_min_period((uint16_t)value[PARAM_ACQPS],
+                       (uint16_t)value[PARAM_ADC_PRESCALE]) > period)
+    {
+        return 0;
+    }
+
+    //
+    // Buffer set time in TBCLK ticks against PARAM_SET_MAX_MS
+    //
+    if(((uint32_t)period + 1UL) * (uint32_t)value[PARAM_BUFFER_SAMPLES] >
+       (uint32_t)PARAM_SET_MAX_MS * (TBCLK_HZ / 1000UL))
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+//
+// params_in_range - Limits of one register
+//
+static uint16_t params_in_range(uint16_t id, int32_t value)
+{
+    if((value < param_defs[id].min) || (value > param_defs[id].max))
+    {
+        return 0;
+    }
+    if((PARAM_BUFFER_SAMPLES == id) && (0L != (value & 3L)))
+    {
+        return 0;                           // Sample store packing
+    }
+
+    return 1;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,147 @@
+//#############################################################################
+//
+// FILE: params.h
+//
+// TITLE: Runtime parameter table with a versioned register map
+//
+// DESCRIPTION:
+// The tunable settings of the acquisition and telemetry are entries of a
+// parameter table. Each entry has a type, limits and a default (params.c);
+// the position of an entry is its register number on the telemetry link
+// and changes only together with PARAM_MAP_VERSION.
+//
+// Writes are range-checked and stored as pending values. params_commit()
+// applies all pending values at once; it is called from the main loop at
+// a safe point, the first pass after a CP period boundary (cp_hist.h),
+// and returns the mask of the registers that changed so the caller can
+// reprogram the hardware. A pending set that breaks a rule between
+// registers is discarded as a whole:
+//
+//     - CMPA below the sample period, CP band low below high
+//     - SOC0..2 with PARAM_ACQPS, and a temperature conversion, fit the
+//       sample period (adc_min_period())
+//     - a buffer set (period x PARAM_BUFFER_SAMPLES) takes at most
+//       PARAM_SET_MAX_MS: the CP task checks in with the supervisor once
+//       per set and must stay within SUP_DEADLINE_CP_MS, the rest is left
+//       for the processing of the set
+//
+// params_init() applies the same rules to the saved copy and falls back
+// to the defaults (PARAM_LOAD_RULE) rather than boot into a set that
+// would lose conversions or starve the watchdog.
+//
+// params_save() stores the active values in flash sectors 62 and 63
+// (0x08F800, 0x08FC00), alternately: the older copy is erased and
+// rewritten, so a power loss during a save leaves the other copy intact.
+// Each copy also holds the ADC calibration (AdcCalStore, adc_cal.h) right
+// after the values; params_cal_copy() returns the one of the loaded copy.
+// params_init() loads the valid copy with the highest sequence number if
+// it was saved with the same PARAM_MAP_VERSION, and the defaults
+// otherwise. Saving needs the CPU1_FLASH build (FLOG_USE_FLASH).
+//
+//#############################################################################
+
+#ifndef _params_h
+#define _params_h
+
+#include <stdint.h>
+#include "adc_cal.h"
+#include "supervisor.h"
+
+//
+// Defines
+//
+#define PARAM_MAP_VERSION       1U
+
+//
+// Register map
+//
+#define PARAM_VERSION           0U      // Read only: PARAM_MAP_VERSION
+#define PARAM_TLM_STATUS_MS     1U      // Status frame period, ms
+#define PARAM_TLM_MAINS_MS      2U      // Mains frame period, ms
+#define PARAM_CP_BAND_LOW       3U      // Flight recorder CP band, counts
+#define PARAM_CP_BAND_HIGH      4U
+#define PARAM_SAG_THRESHOLD     5U      // Mains sag trigger, counts
+#define PARAM_SAMPLE_PERIOD     6U      // ePWM1/2/4 TBPRD, 16.7 ns ticks
+#define PARAM_SOC_CMPA          7U      // ePWM CMPA, SOC position
+#define PARAM_ACQPS             8U      // Sample window of SOC0..2 - 1, SYSCLK
+#define PARAM_ADC_PRESCALE      9U      // ADCCTL2.PRESCALE
+#define PARAM_BUFFER_SAMPLES    10U     // Samples per buffer set, multiple of 4
+#define PARAM_ENV_WINDOW        11U     // CP min/max envelope window, samples
+#define PARAM_COUNT             12U
+
+#define PARAM_T_U16             0U
+#define PARAM_T_I32             1U
+
+#define PARAM_F_READONLY        0x0001U
+
+//
+// Status of a read, write or commit
+//
+#define PARAM_OK                0U
+#define PARAM_ERR_ID            1U      // No such register
+#define PARAM_ERR_RANGE         2U      // Outside the limits, not stored
+#define PARAM_ERR_READONLY      3U
+#define PARAM_ERR_RULE          4U      // Pending set discarded at commit
+#define PARAM_ERR_FLASH         5U      // Save failed or not available
+
+//
+// Where the values came from at boot
+//
+#define PARAM_LOAD_DEFAULTS     0U      // No valid copy in flash
+#define PARAM_LOAD_FLASH        1U
+#define PARAM_LOAD_VERSION      2U      // Copy of another map version
+#define PARAM_LOAD_RULE         3U      // Copy breaks a commit rule
+
+#define PARAM_SET_MAX_MS        (SUP_DEADLINE_CP_MS - 10U)  // Buffer set
+
+//
+// Flash copy
+//
+#define PARAM_FLASH_A           0x08F800UL  // Sector 62
+#define PARAM_FLASH_B           0x08FC00UL  // Sector 63
+#define PARAM_STORE_MAGIC       0x9A7EU
+#define PARAM_STORE_SLOTS       12U         // >= PARAM_COUNT, 32-word record
+
+typedef struct
+{
+    uint16_t type;          // PARAM_T_*
+    uint16_t flags;         // PARAM_F_*
+    int32_t  min;
+    int32_t  max;
+    int32_t  def;
+} ParamDef;
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t version;       // PARAM_MAP_VERSION when saved
+    uint32_t sequence;
+    uint16_t count;
+    uint16_t reserved;
+    int32_t  value[PARAM_STORE_SLOTS];
+    uint16_t pad;
+    uint16_t crc;           // CRC-16/CCITT of the words above, written last
+} ParamStore;
+
+//
+// Globals
+//
+extern const ParamDef param_defs[PARAM_COUNT];
+extern int32_t param_value[PARAM_COUNT];    // Active values
+extern uint32_t param_pendingMask;
+extern uint16_t param_loadStatus;           // PARAM_LOAD_*
+extern uint16_t param_commits;
+extern uint16_t param_rejected;             // Sets discarded at commit
+
+//
+// Function Prototypes
+//
+void params_init(void);
+uint16_t params_read(uint16_t id, int32_t *value);
+uint16_t params_write(uint16_t id, int32_t value);
+uint16_t params_defaults(void);
+uint32_t params_commit(void);
+uint16_t params_save(void);
+const AdcCalStore *params_cal_copy(void);
+
+#endif
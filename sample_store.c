@@ -0,0 +1,82 @@
+//#############################################################################
+//
+// FILE: sample_store.c
+//
+// TITLE: Bit-packed circular store for 12-bit ADC samples
+//
+// DESCRIPTION:
+// Non-inline part of the packed sample store: initialisation and the
+// background-side accessors that address samples by age.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "sample_store.h"
+
+//
+// sample_store_init - Attach a store to its backing words and clear it.
+//
+void sample_store_init(SampleStore *store, uint16_t *words, uint16_t capacity)
+{
+    store->words = words;
+    store->capacity = capacity & ~3U;
+    store->head = 0;
+    store->count = 0;
+
+    memset(words, 0, SAMPLE_STORE_WORDS(store->capacity));
+}
+
+//
+// sample_store_read - Read a sample by age: 0 is the newest sample,
+// count - 1 the oldest. Returns 0 for ages beyond the valid samples.
+//
+uint16_t sample_store_read(const SampleStore *store, uint16_t age)
+{
+    uint16_t pos;
+
+    if(age >= store->count)
+    {
+        return 0;
+    }
+
+    pos = (store->head > age) ? (store->head - 1U - age) :
+                                (store->head + store->capacity - 1U - age);
+
+    return sample_store_get(store, pos);
+}
+
+//
+// sample_store_copy - Unpack the newest samples into dest, oldest first.
+// Returns the number of samples copied.
+//
+uint16_t sample_store_copy(const SampleStore *store, uint16_t *dest,
+                           uint16_t count)
+{
+    uint16_t i, pos;
+
+    if(count > store->count)
+    {
+        count = store->count;
+    }
+
+    pos = (store->head >= count) ? (store->head - count) :
+                                   (store->head + store->capacity - count);
+
+    for(i = 0; i < count; i++)
+    {
+        dest[i] = sample_store_get(store, pos);
+        if(store->capacity <= ++pos)
+        {
+            pos = 0;
+        }
+    }
+
+    return count;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,114 @@
+//#############################################################################
+//
+// FILE: sample_store.h
+//
+// TITLE: Bit-packed circular store for 12-bit ADC samples
+//
+// DESCRIPTION:
+// Four 12-bit samples are packed into three 16-bit words:
+//
+//   word 0 : s1[3:0]  | s0[11:0]
+//   word 1 : s2[7:0]  | s1[11:4]
+//   word 2 : s3[11:0] | s2[11:8]
+//
+// sample_store_append() and sample_store_get() are always inlined, also
+// with the optimizer off, so they can be used from the ADC ISRs without a
+// call into flash. The capacity must be a multiple
+// of 4 samples.
+//
+//#############################################################################
+
+#ifndef _sample_store_h
+#define _sample_store_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define SAMPLE_STORE_WORDS(samples)   (((samples) / 4U) * 3U)
+
+typedef struct
+{
+    uint16_t *words;        // SAMPLE_STORE_WORDS(capacity) words
+    uint16_t capacity;      // Samples, multiple of 4
+    uint16_t head;          // Next write position
+    uint16_t count;         // Valid samples, saturates at capacity
+} SampleStore;
+
+//
+// Function Prototypes
+//
+void sample_store_init(SampleStore *store, uint16_t *words, uint16_t capacity);
+uint16_t sample_store_read(const SampleStore *store, uint16_t age);
+uint16_t sample_store_copy(const SampleStore *store, uint16_t *dest,
+                           uint16_t count);
+
+//
+// sample_store_put - Write a sample at an absolute position. Sample k of a
+// group of four starts at bit 12 k of its three words; the position is
+// decoded with shifts and masks, not a switch, which the compiler may
+// turn into a .switch table in flash read from the ISRs.
+//
+#pragma FUNC_ALWAYS_INLINE(sample_store_put)
+static inline void sample_store_put(SampleStore *store, uint16_t pos,
+                                    uint16_t sample)
+{
+    uint16_t bit = (pos & 3U) * 12U;
+    uint16_t *w = store->words + (pos >> 2) * 3U + (bit >> 4);
+    uint16_t sh = bit & 15U;
+
+    sample &= 0x0FFFU;
+
+    w[0] = (uint16_t)(w[0] & ~(uint16_t)(0x0FFFU << sh)) |
+           (uint16_t)(sample << sh);
+    if(sh > 4U)
+    {
+        w[1] = (uint16_t)(w[1] & ~(uint16_t)(0x0FFFU >> (16U - sh))) |
+               (uint16_t)(sample >> (16U - sh));
+    }
+}
+
+//
+// sample_store_get - Read the sample at an absolute position.
+//
+#pragma FUNC_ALWAYS_INLINE(sample_store_get)
+static inline uint16_t sample_store_get(const SampleStore *store, uint16_t pos)
+{
+    uint16_t bit = (pos & 3U) * 12U;
+    const uint16_t *w = store->words + (pos >> 2) * 3U + (bit >> 4);
+    uint16_t sh = bit & 15U;
+    uint16_t sample = w[0] >> sh;
+
+    if(sh > 4U)
+    {
+        sample |= (uint16_t)(w[1] << (16U - sh));
+    }
+
+    return(sample & 0x0FFFU);
+}
+
+//
+// sample_store_append - Add a sample at the head. Returns 1 when the head
+// wraps back to position 0, i.e. the store has just been filled once more.
+//
+#pragma FUNC_ALWAYS_INLINE(sample_store_append)
+static inline uint16_t sample_store_append(SampleStore *store, uint16_t sample)
+{
+    sample_store_put(store, store->head, sample);
+
+    if(store->count < store->capacity)
+    {
+        store->count++;
+    }
+
+    if(store->capacity <= ++store->head)
+    {
+        store->head = 0;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
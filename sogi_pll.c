@@ -0,0 +1,193 @@
+//#############################################################################
+//
+// FILE: sogi_pll.c
+//
+// TITLE: Fixed-point SOGI-PLL on the 500 VAC samples
+//
+// DESCRIPTION:
+// Gains for the sample period, the sine table and the background
+// conversion of the PLL state to frequency, amplitude and phase error.
+// Integer arithmetic only.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "sogi_pll.h"
+#include "adc_cal.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define PLL_TBCLK_HZ            ((uint64_t)TBCLK_HZ)   // ePWM1 time base
+#define PLL_TBCLK_SQ_Q24        ((PLL_TBCLK_HZ * PLL_TBCLK_HZ) >> 24)
+#define PLL_LOCK_RATIO          8L          // |vq| < vd / 8, ~7 deg
+#define PLL_MDEG_PER_RAD        57296L
+
+//
+// Globals
+//
+PllState pll;
+uint16_t pll_freqCHz;
+uint16_t pll_ampDv;
+int16_t pll_phaseErrMdeg;
+uint16_t pll_locked;
+
+//
+// sin over one cycle, Q15, PLL_SIN_SIZE + 1 entries for the interpolation.
+// Not const: read by adcA1ISR, so it must not be in flash.
+//
+int16_t pll_sinTable[PLL_SIN_SIZE + 1U] =
+{
+         0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+      6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+     12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+     18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+     23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+     27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+     30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+     32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+     32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+     32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+     30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+     27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+     23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+     18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+     12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+      6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+         0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+     -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+    -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+    -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+    -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+    -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+     -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804,
+         0
+};
+
+static uint16_t pll_periodTicks;
+
+//
+// Function Prototypes
+//
+static int32_t pll_step_hz(uint16_t hz);
+
+//
+// sogi_pll_init - Reset the loop and compute the gains for the sample
+// period. Call after adc_cal_init(), with adcA1ISR stopped.
+// samplePeriodTicks is the ePWM1 period in TBCLK ticks.
+//
+void sogi_pll_init(uint16_t samplePeriodTicks)
+{
+    const AdcCal *cal = &adc_cal[CH_IN_ADC_500VAC];
+    uint64_t ticksSq = (uint64_t)samplePeriodTicks * samplePeriodTicks;
+    int32_t kiQ8, range;
+
+    pll_periodTicks = samplePeriodTicks;
+
+    //
+    // Proportional: a unit vq moves the frequency by PLL_KP_HZ.
+    // Integral: wn^2 * Ts per sample, as an angle step, Q8. Long sample
+    // periods give up fraction bits of the integrator so that its range
+    // plus one step stays within the int32.
+    //
+    pll.incNom = pll_step_hz(PLL_F_NOM_HZ);
+    pll.kp = pll_step_hz(PLL_KP_HZ);
+    kiQ8 = (int32_t)(((uint64_t)PLL_TWO_PI_Q16 * PLL_FN_HZ * PLL_FN_HZ *
+                      ticksSq) / PLL_TBCLK_SQ_Q24);
+    range = pll_step_hz(PLL_RANGE_HZ);
+
+    pll.integShift = PLL_INTEG_SHIFT;
+    while((pll.integShift > 0U) &&
+          (range > (0x3FFFFFFFL >> pll.integShift)))
+    {
+        pll.integShift--;
+    }
+    pll.integMax = range << pll.integShift;
+    pll.ki = kiQ8 >> (PLL_INTEG_SHIFT - pll.integShift);
+
+    pll.va = 0;
+    pll.vb = 0;
+    pll.vd = 0;
+    pll.vq = 0;
+    pll.theta = 0;
+    pll.integ = 0;
+    pll.inc = pll.incNom;
+    pll.mid = (uint16_t)((cal->offset + 8) >> 4);
+
+    pll_freqCHz = 0;
+    pll_ampDv = 0;
+    pll_phaseErrMdeg = 0;
+    pll_locked = 0;
+}
+
+//
+// sogi_pll_poll - Background task: frequency, amplitude and lock state
+// from a snapshot of the loop
+//
+void sogi_pll_poll(void)
+{
+    const AdcCal *cal = &adc_cal[CH_IN_ADC_500VAC];
+    int32_t inc, vd, vq;
+    uint16_t intState;
+    int64_t mv, err;
+
+    intState = __disable_interrupts();
+    inc = pll.inc;
+    vd = pll.vd;
+    vq = pll.vq;
+    __restore_interrupts(intState);
+
+    if(inc < 0)
+    {
+        inc = 0;
+    }
+    pll_freqCHz = (uint16_t)((((uint64_t)inc * PLL_TBCLK_HZ * 100ULL) >> 32) /
+                             pll_periodTicks);
+
+    //
+    // vd >> 9 is the peak in counts, Q4, as adc_cal_to_mv() scales it
+    //
+    mv = ((int64_t)(vd >> 9) * cal->gain) >> (cal->shift + 4);
+    pll_ampDv = (mv > 0) ? (uint16_t)(mv / 100) : 0U;
+
+    if(vd > 0)
+    {
+        err = ((int64_t)vq * PLL_MDEG_PER_RAD) / vd;
+        if(err > 32767)
+        {
+            err = 32767;
+        }
+        else if(err < -32767)
+        {
+            err = -32767;
+        }
+        pll_phaseErrMdeg = (int16_t)err;
+    }
+    pll_locked = (vd > PLL_MIN_AMP_Q24) &&
+                 (vq < vd / PLL_LOCK_RATIO) && (vq > -vd / PLL_LOCK_RATIO);
+}
+
+//
+// pll_step_hz - Angle step per sample of a frequency
+//
+static int32_t pll_step_hz(uint16_t hz)
+{
+    return (int32_t)((((uint64_t)hz * pll_periodTicks) << 32) / PLL_TBCLK_HZ);
+}
+
+//
+// End of File
+//
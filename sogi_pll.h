@@ -0,0 +1,164 @@
+//#############################################################################
+//
+// FILE: sogi_pll.h
+//
+// TITLE: Fixed-point SOGI-PLL on the 500 VAC samples
+//
+// DESCRIPTION:
+// sogi_pll_push() runs in adcA1ISR for every mains sample. A second-order
+// generalised integrator (SOGI) turns the sample into an in-phase and a
+// quadrature component; their Park transform on the PLL angle gives
+//
+//     vd  amplitude of the fundamental
+//     vq  amplitude * sin(phase error), driven to 0 by a PI on the
+//         phase step
+//
+// so angle, frequency and amplitude are updated every sample. The SOGI
+// band-pass (gain PLL_K) rejects harmonics and noise before the phase
+// detector; the SOGI uses the PLL frequency, so it stays centred on the
+// mains.
+//
+// All arithmetic is Q24 (1.0 = 2048 counts from the mid-scale) on int32;
+// a product keeps the upper bits of the 32x32 multiply (__IQmpy on the
+// C28x, as in IQmath), so the ISR needs no 64-bit run-time support
+// routine from flash. The PI integrator is an int32 with integShift
+// fraction bits, as many as the frequency range leaves room for. The
+// angle is a uint32 where 2^32 is one cycle and wraps by itself.
+// sin/cos come from a 256 entry table with linear interpolation, kept in
+// RAM (.data) so the ISR reads no flash. The gains depend on the sample
+// period and are computed in sogi_pll_init() in the background.
+//
+// After lost conversions (acq_gap.h) sogi_pll_gap() advances the angle
+// over the missing samples, so the phase stays continuous.
+//
+// pll.theta is the mains phase at the last sample; it can time the
+// sampling of the other channels to the mains. The cycles spent per
+// sample are in bench_isr[BENCH_PLL].
+//
+//#############################################################################
+
+#ifndef _sogi_pll_h
+#define _sogi_pll_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define PLL_F_NOM_HZ            50U         // Nominal mains
+#define PLL_RANGE_HZ            5U          // Integrator limit around nominal
+#define PLL_FN_HZ               15U         // Loop natural frequency
+#define PLL_KP_HZ               21U         // 2 * zeta * fn, zeta = 0.7
+#define PLL_K_Q24               23726566L   // SOGI gain sqrt(2)
+#define PLL_TWO_PI_Q16          411775L
+#define PLL_IN_SHIFT            13U         // Counts to Q24 of 2048
+#define PLL_SIN_BITS            8U
+#define PLL_SIN_SIZE            (1U << PLL_SIN_BITS)
+#define PLL_MIN_AMP_Q24         (16777216L / 8L)    // Lock needs 1/8 scale
+
+#define PLL_INTEG_SHIFT         8U          // Integrator fraction bits, most
+
+#if defined(__TMS320C28XX__)
+#define PLL_QMPY(a, b)          __IQmpy((a), (b), 24)
+#else
+#define PLL_QMPY(a, b)          ((int32_t)(((int64_t)(a) * (b)) >> 24))
+#endif
+
+typedef struct
+{
+    int32_t va;             // SOGI in-phase output, Q24
+    int32_t vb;             // SOGI quadrature output (lags 90 deg), Q24
+    int32_t vd;             // Amplitude, Q24
+    int32_t vq;             // Phase error * amplitude, Q24
+    uint32_t theta;         // Angle, 2^32 per cycle
+    int32_t inc;            // Angle step per sample
+    int32_t integ;          // PI integrator, angle step << integShift
+    int32_t integMax;
+    int32_t incNom;         // Step at PLL_F_NOM_HZ
+    int32_t kp;             // Step per unit of vq
+    int32_t ki;             // Integrator step per unit of vq, << integShift
+    uint16_t integShift;
+    uint16_t mid;           // 0 V in counts
+} PllState;
+
+//
+// Globals
+//
+extern PllState pll;
+extern int16_t pll_sinTable[PLL_SIN_SIZE + 1U];
+extern uint16_t pll_freqCHz;                // Frequency, 0.01 Hz
+extern uint16_t pll_ampDv;                  // Peak of the fundamental, 0.1 V
+extern int16_t pll_phaseErrMdeg;            // Phase error, millidegrees
+extern uint16_t pll_locked;
+
+//
+// Function Prototypes
+//
+void sogi_pll_init(uint16_t samplePeriodTicks);
+void sogi_pll_poll(void);
+
+//
+// pll_sin - sin(theta), Q24
+//
+#pragma FUNC_ALWAYS_INLINE(pll_sin)
+static inline int32_t pll_sin(uint32_t theta)
+{
+    uint16_t i = (uint16_t)(theta >> (32U - PLL_SIN_BITS));
+    int32_t frac = (int32_t)((theta >> (16U - PLL_SIN_BITS)) & 0xFFFFUL);
+    int32_t s0 = pll_sinTable[i];
+
+    return (s0 << 9) + (((pll_sinTable[i + 1U] - s0) * frac) >> 7);
+}
+
+//
+// sogi_pll_push - Advance the SOGI and the PLL by one 500 VAC sample
+//
+#pragma FUNC_ALWAYS_INLINE(sogi_pll_push)
+static inline void sogi_pll_push(uint16_t sample)
+{
+    PllState *p = &pll;
+    int32_t v = ((int32_t)sample - (int32_t)p->mid) << PLL_IN_SHIFT;
+    int32_t w = PLL_QMPY(p->inc, PLL_TWO_PI_Q16);
+    int32_t s = pll_sin(p->theta);
+    int32_t c = pll_sin(p->theta + 0x40000000UL);
+
+    //
+    // SOGI, w = omega * Ts
+    //
+    p->va += PLL_QMPY(w, PLL_QMPY(PLL_K_Q24, v - p->va) - p->vb);
+    p->vb += PLL_QMPY(w, p->va);
+
+    //
+    // Park transform: va = A sin(phi), vb = -A cos(phi)
+    //
+    p->vd = PLL_QMPY(p->va, s) - PLL_QMPY(p->vb, c);
+    p->vq = PLL_QMPY(p->va, c) + PLL_QMPY(p->vb, s);
+
+    //
+    // PI on the angle step
+    //
+    p->integ += PLL_QMPY(p->vq, p->ki);
+    if(p->integ > p->integMax)
+    {
+        p->integ = p->integMax;
+    }
+    else if(p->integ < -p->integMax)
+    {
+        p->integ = -p->integMax;
+    }
+
+    p->inc = p->incNom + PLL_QMPY(p->vq, p->kp) +
+             (p->integ >> p->integShift);
+    p->theta += (uint32_t)p->inc;
+}
+
+//
+// sogi_pll_gap - Conversions were lost: advance the angle over them
+//
+#pragma FUNC_ALWAYS_INLINE(sogi_pll_gap)
+static inline void sogi_pll_gap(uint16_t missed)
+{
+    pll.theta += (uint32_t)pll.inc * missed;
+}
+
+#endif
@@ -0,0 +1,204 @@
+//#############################################################################
+//
+// FILE: stats.c
+//
+// TITLE: Running statistics of the ADC channels
+//
+// DESCRIPTION:
+// Block set-up, the atomic snapshot and its conversion to mean, variance
+// and noise, and the background task of the channel blocks.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "stats.h"
+#include "flash_log.h"
+
+//
+// Globals
+//
+StatsBlock stats[NUM_CHANNELS];
+StatsSnap stats_snap[NUM_CHANNELS];
+
+static uint32_t stats_ewmaMs;               // Last EWMA snapshots
+
+//
+// Function Prototypes
+//
+static uint32_t stats_isqrt(uint32_t x);
+
+//
+// stats_init - Clear a block and set its window: a length of 2..
+// STATS_MAX_WINDOW samples (STATS_TUMBLING) or a shift of 1..
+// STATS_MAX_SHIFT (STATS_EWMA). Call with the ISR that pushes to it
+// stopped or masked.
+//
+void stats_init(StatsBlock *b, uint16_t mode, uint16_t length)
+{
+    uint16_t lo = 2U, hi = STATS_MAX_WINDOW;
+
+    if(STATS_EWMA == mode)
+    {
+        lo = 1U;
+        hi = STATS_MAX_SHIFT;
+    }
+    if(length < lo)
+    {
+        length = lo;
+    }
+    if(length > hi)
+    {
+        length = hi;
+    }
+
+    b->mode = mode;
+    b->length = length;
+    b->cur.sumSq = 0;
+    b->cur.sumSqHi = 0;
+    b->cur.sum = 0;
+    b->cur.ref = 0;
+    b->cur.n = 0;
+    b->cur.min = 0;
+    b->cur.max = 0;
+    b->done = b->cur;
+    b->windows = 0;
+    b->taken = 0;
+    b->primed = 0;
+    b->ewmaMean = 0;
+    b->ewmaVar = 0;
+    b->ewmaVarHi = 0;
+    b->total = 0;
+}
+
+//
+// stats_snapshot - Copy a block consistently and convert it. Returns 0 and
+// leaves snap unchanged when there is nothing new: no complete window
+// since the last snapshot (STATS_TUMBLING), or no sample yet (STATS_EWMA).
+// An EWMA snapshot restarts the min/max.
+//
+uint16_t stats_snapshot(StatsBlock *b, StatsSnap *snap)
+{
+    StatsWindow w;
+    uint32_t mean = 0, total, varLo = 0, varHi = 0;
+    uint64_t var, num;
+    uint16_t intState, windows, primed;
+    int32_t round;
+
+    intState = __disable_interrupts();
+    windows = b->windows;
+    total = b->total;
+    primed = b->primed;
+    if(STATS_TUMBLING == b->mode)
+    {
+        w = b->done;
+    }
+    else
+    {
+        w = b->cur;
+        mean = b->ewmaMean;
+        varLo = b->ewmaVar;
+        varHi = b->ewmaVarHi;
+        b->cur.n = 0;
+    }
+    __restore_interrupts(intState);
+
+    if(STATS_EWMA == b->mode)
+    {
+        if(!primed)
+        {
+            return 0;
+        }
+        snap->meanQ4 = (int32_t)(mean >> b->length);
+        var = ((uint64_t)varHi << 32) | varLo;
+        snap->varQ8 = (uint32_t)(var >> b->length);
+        snap->windows = 0;
+        snap->samples = total;
+    }
+    else
+    {
+        if((windows == b->taken) || (w.n < 2U))
+        {
+            return 0;
+        }
+        b->taken = windows;
+
+        //
+        // mean = ref + S1 / n, var = (n S2 - S1^2) / (n (n - 1))
+        //
+        round = (w.sum < 0) ? -(int32_t)(w.n / 2U) : (int32_t)(w.n / 2U);
+        snap->meanQ4 = ((int32_t)w.ref << 4) + (w.sum * 16L + round) / w.n;
+        num = (uint64_t)w.n * (((uint64_t)w.sumSqHi << 32) | w.sumSq) -
+              (uint64_t)((int64_t)w.sum * w.sum);
+        snap->varQ8 = (uint32_t)((num << 8) /
+                                 ((uint64_t)w.n * (w.n - 1U)));
+        snap->windows = windows;
+        snap->samples = w.n;
+    }
+
+    snap->stdQ4 = (uint16_t)stats_isqrt(snap->varQ8);
+    snap->min = w.min;
+    snap->max = w.max;
+
+    return 1;
+}
+
+//
+// stats_poll - Background task: snapshot the channel blocks into
+// stats_snap[]
+//
+void stats_poll(void)
+{
+    uint32_t now = flog_time_ms();
+    uint16_t ewmaDue = (now - stats_ewmaMs) >= STATS_EWMA_SNAP_MS;
+    uint16_t ch;
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        if((STATS_TUMBLING == stats[ch].mode) || ewmaDue)
+        {
+            stats_snapshot(&stats[ch], &stats_snap[ch]);
+        }
+    }
+
+    if(ewmaDue)
+    {
+        stats_ewmaMs = now;
+    }
+}
+
+//
+// stats_isqrt - Integer square root, bit by bit
+//
+static uint32_t stats_isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+
+    while(0 != bit)
+    {
+        if(x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,205 @@
+//#############################################################################
+//
+// FILE: stats.h
+//
+// TITLE: Running statistics of the ADC channels
+//
+// DESCRIPTION:
+// A StatsBlock keeps the mean, variance, min, max and sample count of one
+// sample stream, updated per sample by stats_push() from the ISR with
+// 32-bit integer adds, multiplies and shifts only: the sums that need more
+// than 32 bits are kept as two words with the carries propagated by hand,
+// so the ISR calls no 64-bit run-time support routine from flash. Each
+// block has its own window:
+//
+//     STATS_TUMBLING  consecutive windows of length samples (2..
+//                     STATS_MAX_WINDOW). The ISR keeps the sums of
+//                     d = x - ref and d^2, ref being the first sample of
+//                     the window; at the end of the window it publishes
+//                     them and starts over. Mean and variance follow
+//                     exactly in the background,
+//
+//                         mean = ref + S1 / n
+//                         var  = (n S2 - S1^2) / (n (n - 1))
+//
+//                     the integer form of Welford's update: the shifted
+//                     sums cannot cancel in exact arithmetic, and the
+//                     per-sample division of the textbook recurrence is
+//                     left out of the ISR
+//     STATS_EWMA      exponentially weighted, alpha = 2^-length (length =
+//                     shift 1..STATS_MAX_SHIFT). Welford's incremental
+//                     form for weights (d = x - mean):
+//
+//                         mean += alpha d
+//                         var   = (1 - alpha) (var + alpha d^2)
+//
+//                     kept scaled by 2^length (the mean in Q4 counts, the
+//                     variance in Q8 counts^2, two words) so no fraction is
+//                     lost in the shifts. Min and max run since the last
+//                     snapshot
+//
+// stats_snapshot() copies a block with the interrupts disabled (a few
+// tens of cycles), so the mean, variance, min and max of a snapshot always
+// belong to the same samples, and converts it to StatsSnap in the
+// background: mean in Q4 counts, variance in Q8 counts^2 and the standard
+// deviation (noise) in Q4 counts. stats_poll() keeps stats_snap[] of the
+// channel blocks stats[] current: a tumbling block at the end of each
+// window, an EWMA block every STATS_EWMA_SNAP_MS.
+//
+//#############################################################################
+
+#ifndef _stats_h
+#define _stats_h
+
+#include <stdint.h>
+#include "channels.h"
+
+//
+// Defines
+//
+#define STATS_TUMBLING          0U
+#define STATS_EWMA              1U
+
+#define STATS_MAX_WINDOW        16384U      // Keeps n * S2 << 8 in 64 bits
+#define STATS_MAX_SHIFT         15U         // Keeps the Q4 mean in 32 bits
+#define STATS_EWMA_SNAP_MS      100U        // stats_poll() EWMA snapshots
+
+typedef struct
+{
+    uint32_t sumSq;                         // S2, low word
+    uint32_t sumSqHi;                       // S2, high word
+    int32_t sum;                            // S1
+    uint16_t ref;
+    uint16_t n;
+    uint16_t min;
+    uint16_t max;
+} StatsWindow;
+
+typedef struct
+{
+    uint16_t mode;                          // STATS_TUMBLING or STATS_EWMA
+    uint16_t length;                        // Window samples or EWMA shift
+    StatsWindow cur;                        // Tumbling: window in progress
+    StatsWindow done;                       // Tumbling: last complete one
+    uint16_t windows;                       // Complete windows
+    uint16_t taken;                         // windows at the last snapshot
+    uint16_t primed;                        // EWMA: first sample seen
+    uint32_t ewmaMean;                      // Q4 << length
+    uint32_t ewmaVar;                       // Q8 << length, low word
+    uint32_t ewmaVarHi;                     // High word
+    uint32_t total;                         // Samples since stats_init()
+} StatsBlock;
+
+typedef struct
+{
+    int32_t meanQ4;                         // Counts, Q4
+    uint32_t varQ8;                         // Counts^2, Q8
+    uint16_t stdQ4;                         // Counts, Q4
+    uint16_t min;
+    uint16_t max;
+    uint16_t windows;                       // Tumbling: window number
+    uint32_t samples;                       // In the window, or in total
+} StatsSnap;
+
+//
+// Globals
+//
+extern StatsBlock stats[NUM_CHANNELS];      // Pushed by the ADC ISRs
+extern StatsSnap stats_snap[NUM_CHANNELS];  // Taken by stats_poll()
+
+//
+// Function Prototypes
+//
+void stats_init(StatsBlock *b, uint16_t mode, uint16_t length);
+uint16_t stats_snapshot(StatsBlock *b, StatsSnap *snap);
+void stats_poll(void);
+
+//
+// stats_push - Account one sample
+//
+#pragma FUNC_ALWAYS_INLINE(stats_push)
+static inline void stats_push(StatsBlock *b, uint16_t sample)
+{
+    StatsWindow *w = &b->cur;
+    uint32_t q4, ad2, lo, hi, t;
+    int32_t d;
+
+    b->total++;
+
+    if(0U == w->n)
+    {
+        w->ref = sample;
+        w->min = sample;
+        w->max = sample;
+    }
+    if(sample < w->min)
+    {
+        w->min = sample;
+    }
+    if(sample > w->max)
+    {
+        w->max = sample;
+    }
+
+    if(STATS_TUMBLING == b->mode)
+    {
+        d = (int32_t)sample - (int32_t)w->ref;
+        ad2 = (uint32_t)(d * d);
+        w->sum += d;
+        w->sumSq += ad2;
+        if(w->sumSq < ad2)
+        {
+            w->sumSqHi++;                   // Carry
+        }
+        if(++w->n >= b->length)
+        {
+            b->done = *w;
+            b->windows++;
+            w->n = 0;
+            w->sum = 0;
+            w->sumSq = 0;
+            w->sumSqHi = 0;
+        }
+        return;
+    }
+
+    //
+    // EWMA
+    //
+    if(w->n < 0xFFFFU)
+    {
+        w->n++;
+    }
+    q4 = (uint32_t)sample << 4;
+    if(!b->primed)
+    {
+        b->ewmaMean = q4 << b->length;
+        b->ewmaVar = 0;
+        b->ewmaVarHi = 0;
+        b->primed = 1;
+        return;
+    }
+    d = (int32_t)q4 - (int32_t)(b->ewmaMean >> b->length);
+    ad2 = (uint32_t)((d < 0) ? -d : d);
+    ad2 = ad2 * ad2;                        // Q8, < 2^32 for |d| < 2^16
+    b->ewmaMean += (uint32_t)d;
+
+    //
+    // var - (var >> length) + ad2 - (ad2 >> length) on the two words,
+    // length 1..15
+    //
+    lo = b->ewmaVar;
+    hi = b->ewmaVarHi;
+    t = lo - ((lo >> b->length) | (hi << (32U - b->length)));
+    hi -= (hi >> b->length) + ((t > lo) ? 1UL : 0UL);
+    ad2 -= ad2 >> b->length;
+    lo = t + ad2;
+    if(lo < ad2)
+    {
+        hi++;
+    }
+    b->ewmaVar = lo;
+    b->ewmaVarHi = hi;
+}
+
+#endif
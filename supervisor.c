@@ -0,0 +1,307 @@
+//#############################################################################
+//
+// FILE: supervisor.c
+//
+// TITLE: Watchdog supervision with per-task heartbeats
+//
+// DESCRIPTION:
+// Reset cause bookkeeping, task ageing and watchdog servicing. Time is
+// taken from the CPU Timer 2 cycle counter (bench.h), so the supervisor
+// needs no timer of its own.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "supervisor.h"
+#include "bench.h"
+#include "memory_plan.h"
+#include "Test_GPIO.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define SUP_CYCLES_PER_MS       SYSCLK_CYCLES_PER_MS
+
+#define SUP_RESC_POR            0x0001U
+#define SUP_RESC_WDRS           0x0004U
+
+//
+// Globals
+//
+#pragma DATA_SECTION(sup_persist, "NoInit");
+SupPersist sup_persist;
+
+SupTask sup_tasks[SUP_NUM_TASKS];
+volatile uint16_t sup_beat[SUP_NUM_TASKS];
+uint16_t sup_resetCause;
+uint16_t sup_lockupReset;
+uint16_t sup_tripReset;
+uint16_t sup_tripped;
+
+static uint32_t sup_lastNow;
+static uint32_t sup_cycles;
+static uint32_t sup_waitStart;
+static uint32_t sup_waitAcq;                // Last ACQ heartbeat in the wait
+
+PLAN_CHECK(supervisor, sizeof(sup_persist) <= PLAN_NOINIT_WORDS);
+
+//
+// Function Prototypes
+//
+static uint16_t sup_checksum(const SupPersist *p);
+static void sup_trip(uint16_t failed, uint16_t hangMs);
+static uint16_t sup_wait_ok(uint32_t now);
+
+//
+// The flash waits call these while the bank is busy
+//
+#pragma CODE_SECTION(sup_wait_begin, ".TI.ramfunc");
+#pragma CODE_SECTION(sup_wait_poll, ".TI.ramfunc");
+#pragma CODE_SECTION(sup_wait_end, ".TI.ramfunc");
+#pragma CODE_SECTION(sup_wait_ok, ".TI.ramfunc");
+
+//
+// sup_init - Read and clear the reset cause and update the persistent
+// record. Call early, after InitSysCtrl().
+//
+void sup_init(void)
+{
+    uint16_t i;
+
+    sup_resetCause = CpuSysRegs.RESC.all & 0xFFFFU;
+    EALLOW;
+    CpuSysRegs.RESCCLR.all = sup_resetCause;
+    EDIS;
+
+    if((sup_resetCause & SUP_RESC_POR) ||
+       (SUP_PERSIST_MAGIC != sup_persist.magic) ||
+       (sup_checksum(&sup_persist) != sup_persist.check))
+    {
+        sup_persist.magic = SUP_PERSIST_MAGIC;
+        sup_persist.bootCount = 0;
+        sup_persist.wdResets = 0;
+        sup_persist.trips = 0;
+        sup_persist.lastFailedTasks = 0;
+        sup_persist.lastHangToSafeMs = 0;
+        sup_persist.tripPending = 0;
+    }
+
+    sup_lockupReset = 0;
+    sup_tripReset = 0;
+    if(sup_resetCause & SUP_RESC_WDRS)
+    {
+        sup_persist.wdResets++;
+        sup_lockupReset = !sup_persist.tripPending;
+        sup_tripReset = sup_persist.tripPending;
+    }
+
+    sup_persist.bootCount++;
+    sup_persist.lastResetCause = sup_resetCause;
+    sup_persist.tripPending = 0;
+    sup_persist.check = sup_checksum(&sup_persist);
+
+    for(i = 0; i < SUP_NUM_TASKS; i++)
+    {
+        sup_tasks[i].deadlineMs = 0;
+        sup_tasks[i].ageMs = 0;
+        sup_tasks[i].maxAgeMs = 0;
+        sup_beat[i] = 0;
+    }
+    sup_tripped = 0;
+}
+
+//
+// sup_register - Supervise a task with the given deadline
+//
+void sup_register(uint16_t task, uint16_t deadlineMs)
+{
+    sup_tasks[task].deadlineMs = deadlineMs;
+    sup_tasks[task].ageMs = 0;
+    sup_beat[task] = 0;
+}
+
+//
+// sup_start - Enable the watchdog in reset mode. Call once the supervised
+// tasks are running.
+//
+void sup_start(void)
+{
+    volatile uint16_t temp;
+
+    sup_lastNow = BENCH_NOW();
+    sup_cycles = 0;
+
+    EALLOW;
+    //
+    // Watchdog resets the device (WDENINT = 0). Written as a whole word:
+    // WDOVERRIDE is write-1-to-clear, and a bit-field write would read it
+    // back as 1 and clear it.
+    //
+    WdRegs.SCSR.all = 0x0000U;
+    temp = WdRegs.WDCR.all & 0xFF00U;       // Keep the pre-divider
+    WdRegs.WDCR.all = temp | 0x0028U | SUP_WD_PRESCALE;
+    EDIS;
+
+    ServiceDog();
+}
+
+//
+// sup_poll - Background task: age the tasks, service the watchdog while
+// all deadlines are met.
+//
+void sup_poll(void)
+{
+    uint32_t now = BENCH_NOW();
+    uint16_t elapsedMs;
+    uint16_t failed = 0;
+    uint16_t hangMs = 0;
+    uint16_t i;
+
+    sup_cycles += sup_lastNow - now;
+    sup_lastNow = now;
+
+    elapsedMs = 0;
+    while(sup_cycles >= SUP_CYCLES_PER_MS)
+    {
+        sup_cycles -= SUP_CYCLES_PER_MS;
+        elapsedMs++;
+    }
+
+    for(i = 0; i < SUP_NUM_TASKS; i++)
+    {
+        SupTask *task = &sup_tasks[i];
+
+        if(0 == task->deadlineMs)
+        {
+            continue;
+        }
+
+        if(sup_beat[i])
+        {
+            sup_beat[i] = 0;
+            task->ageMs = 0;
+        }
+        else if(task->ageMs < 0xFFFFU - elapsedMs)
+        {
+            task->ageMs += elapsedMs;
+        }
+
+        if(task->ageMs > task->maxAgeMs)
+        {
+            task->maxAgeMs = task->ageMs;
+        }
+        if(task->ageMs > task->deadlineMs)
+        {
+            failed |= (uint16_t)1U << i;
+            if(task->ageMs > hangMs)
+            {
+                hangMs = task->ageMs;
+            }
+        }
+    }
+
+    if(0 == failed)
+    {
+        if(!sup_tripped)
+        {
+            ServiceDog();
+        }
+    }
+    else if(!sup_tripped)
+    {
+        sup_trip(failed, hangMs);
+    }
+}
+
+//
+// sup_wait_begin - A flash wait starts
+//
+void sup_wait_begin(void)
+{
+    sup_waitStart = BENCH_NOW();
+    sup_waitAcq = sup_waitStart;
+}
+
+//
+// sup_wait_poll - Call in the flash wait loop. The wait runs under EALLOW,
+// so WDKEY is written directly (ServiceDog() is in flash).
+//
+void sup_wait_poll(void)
+{
+    uint32_t now = BENCH_NOW();
+
+    if(sup_beat[SUP_TASK_ACQ])
+    {
+        sup_beat[SUP_TASK_ACQ] = 0;
+        sup_waitAcq = now;
+    }
+
+    if(sup_wait_ok(now))
+    {
+        WdRegs.WDKEY.bit.WDKEY = 0x0055;
+        WdRegs.WDKEY.bit.WDKEY = 0x00AA;
+    }
+}
+
+//
+// sup_wait_end - The flash wait is over: hand the ACQ heartbeat back and
+// credit the background tasks, which could not run during the wait
+//
+void sup_wait_end(void)
+{
+    uint16_t i;
+
+    if(sup_wait_ok(BENCH_NOW()))
+    {
+        for(i = 0; i < SUP_NUM_TASKS; i++)
+        {
+            sup_beat[i] = 1;
+        }
+    }
+}
+
+//
+// sup_wait_ok - The acquisition ISR beats and the wait is within its
+// deadline
+//
+static uint16_t sup_wait_ok(uint32_t now)
+{
+    return((!sup_tripped) &&
+           ((sup_waitStart - now) <=
+            ((uint32_t)SUP_DEADLINE_FLASH_MS * SUP_CYCLES_PER_MS)) &&
+           ((sup_waitAcq - now) <=
+            ((uint32_t)SUP_DEADLINE_ACQ_MS * SUP_CYCLES_PER_MS)));
+}
+
+//
+// sup_trip - Safe CP state now, record, and let the watchdog reset
+//
+static void sup_trip(uint16_t failed, uint16_t hangMs)
+{
+    select_CP_safe();
+
+    sup_tripped = 1;
+    sup_persist.trips++;
+    sup_persist.lastFailedTasks = failed;
+    sup_persist.lastHangToSafeMs = hangMs;
+    sup_persist.tripPending = 1;
+    sup_persist.check = sup_checksum(&sup_persist);
+}
+
+//
+// sup_checksum - XOR of the record without the check word
+//
+static uint16_t sup_checksum(const SupPersist *p)
+{
+    return(p->magic ^ p->bootCount ^ p->wdResets ^ p->trips ^
+           p->lastResetCause ^ p->lastFailedTasks ^ p->lastHangToSafeMs ^
+           p->tripPending ^ 0xFFFFU);
+}
+
+//
+// End of File
+//
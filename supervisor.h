@@ -0,0 +1,128 @@
+//#############################################################################
+//
+// FILE: supervisor.h
+//
+// TITLE: Watchdog supervision with per-task heartbeats
+//
+// DESCRIPTION:
+// Each supervised task calls sup_checkin() at least once per deadline.
+// sup_poll(), run from the background loop, ages every registered task and
+// services the watchdog only while all of them are within their deadline.
+//
+// A task that misses its deadline trips the supervisor: the CP outputs
+// are driven to the safe state at once, the trip is recorded in the NoInit
+// section and the watchdog is left to reset the device. A hang that stops
+// sup_poll() itself (stuck ISR, stuck loop) is caught by the watchdog alone;
+// the reset returns every GPIO to an input, which is also the safe state.
+// The time from hang to safe CP state is therefore bounded by
+//
+//     SUP_HANG_TO_SAFE_MAX_MS = longest deadline + SUP_WD_TIMEOUT_MS
+//
+// which the build checks against SUP_SAFE_BOUND_MS.
+//
+// A flash erase or program (flash_log.h) holds the background loop in a
+// RAM-resident wait: the bank cannot be read, so neither sup_poll() nor
+// the other tasks run. The wait calls sup_wait_begin(), sup_wait_poll()
+// in its loop and sup_wait_end(); these service the watchdog while the
+// acquisition ISR keeps beating and the wait stays within
+// SUP_DEADLINE_FLASH_MS, and credit the background tasks for the wait
+// afterwards. A wait that hangs stops the servicing and the watchdog
+// resets the device within the same bound.
+//
+// The record in sup_persist survives warm resets (watchdog, XRSn) and
+// holds the boot and reset counters, the last reset cause (RESC), the
+// tasks that caused the last trip and the measured hang-to-safe time.
+//
+//#############################################################################
+
+#ifndef _supervisor_h
+#define _supervisor_h
+
+#include <stdint.h>
+
+//
+// Defines
+//
+#define SUP_TASK_ACQ            0       // ADC acquisition (adcA2ISR)
+#define SUP_TASK_CP             1       // CP processing in the main loop
+#define SUP_TASK_TELEMETRY      2       // Telemetry interface
+#define SUP_NUM_TASKS           3
+
+#define SUP_DEADLINE_ACQ_MS     5U      // CP samples every 10 us
+#define SUP_DEADLINE_CP_MS      40U     // One buffer set every 12.2 ms
+#define SUP_DEADLINE_TELEMETRY_MS 40U   // tlm_poll() in the wait loop
+#define SUP_DEADLINE_FLASH_MS   40U     // One flash erase or program
+
+//
+// Watchdog: INTOSC1 10 MHz / 512 / 4 -> 256 counts in 52.4 ms
+//
+#define SUP_WD_PRESCALE         3U      // WDPS: /4
+#define SUP_WD_TIMEOUT_MS       53U
+
+#define SUP_SAFE_BOUND_MS       100U
+#define SUP_HANG_TO_SAFE_MAX_MS (SUP_DEADLINE_CP_MS + SUP_WD_TIMEOUT_MS)
+
+#if (SUP_DEADLINE_ACQ_MS > SUP_DEADLINE_CP_MS) || \
+    (SUP_DEADLINE_TELEMETRY_MS > SUP_DEADLINE_CP_MS) || \
+    (SUP_DEADLINE_FLASH_MS > SUP_DEADLINE_CP_MS)
+#error "supervisor.h: SUP_HANG_TO_SAFE_MAX_MS assumes the CP deadline is the longest"
+#endif
+
+#if (SUP_HANG_TO_SAFE_MAX_MS > SUP_SAFE_BOUND_MS)
+#error "supervisor.h: hang to safe CP state exceeds SUP_SAFE_BOUND_MS"
+#endif
+
+#define SUP_PERSIST_MAGIC       0x5A3CU
+
+typedef struct
+{
+    uint16_t magic;
+    uint16_t bootCount;
+    uint16_t wdResets;          // Watchdog resets since power-on
+    uint16_t trips;             // Deadline misses since power-on
+    uint16_t lastResetCause;    // RESC of the last reset
+    uint16_t lastFailedTasks;   // Task mask of the last trip
+    uint16_t lastHangToSafeMs;  // Last heartbeat to safe state, last trip
+    uint16_t tripPending;       // Trip recorded, reset not yet seen
+    uint16_t check;             // XOR of the fields above
+} SupPersist;
+
+typedef struct
+{
+    uint16_t deadlineMs;        // 0: not registered
+    uint16_t ageMs;             // Since the last heartbeat
+    uint16_t maxAgeMs;
+} SupTask;
+
+//
+// Globals
+//
+extern SupPersist sup_persist;
+extern SupTask sup_tasks[SUP_NUM_TASKS];
+extern volatile uint16_t sup_beat[SUP_NUM_TASKS];
+extern uint16_t sup_resetCause;             // RESC read at this boot
+extern uint16_t sup_lockupReset;            // Watchdog reset without a trip
+extern uint16_t sup_tripReset;              // Watchdog reset after a trip
+extern uint16_t sup_tripped;
+
+//
+// Function Prototypes
+//
+void sup_init(void);
+void sup_register(uint16_t task, uint16_t deadlineMs);
+void sup_start(void);
+void sup_poll(void);
+void sup_wait_begin(void);
+void sup_wait_poll(void);
+void sup_wait_end(void);
+
+//
+// sup_checkin - Heartbeat of a task. A single store, safe from any ISR.
+//
+#pragma FUNC_ALWAYS_INLINE(sup_checkin)
+static inline void sup_checkin(uint16_t task)
+{
+    sup_beat[task] = 1;
+}
+
+#endif
@@ -0,0 +1,31 @@
+//#############################################################################
+//
+// FILE: sysclk.h
+//
+// TITLE: System and ePWM time-base clock rates
+//
+// DESCRIPTION:
+// InitSysCtrl() runs SYSCLK at SYSCLK_HZ; CPU Timer 0..2, the eCAP and
+// the Flash API count or are configured in SYSCLK cycles. The ePWM time
+// base runs at SYSCLK / SYSCLK_PER_TBCLK (EPWMCLKDIV /2, TBCTL dividers
+// /1). Every cycle, tick, microsecond and nanosecond conversion of the
+// application derives from these two, so a different PLL setting only
+// changes this file.
+//
+//#############################################################################
+
+#ifndef _sysclk_h
+#define _sysclk_h
+
+//
+// Defines
+//
+#define SYSCLK_HZ               120000000UL
+#define SYSCLK_MHZ              (SYSCLK_HZ / 1000000UL)
+#define SYSCLK_CYCLES_PER_MS    (SYSCLK_HZ / 1000UL)
+
+#define SYSCLK_PER_TBCLK        2UL
+#define TBCLK_HZ                (SYSCLK_HZ / SYSCLK_PER_TBCLK)
+#define TBCLK_MHZ               (TBCLK_HZ / 1000000UL)
+
+#endif
@@ -0,0 +1,806 @@
+//#############################################################################
+//
+// FILE: telemetry.c
+//
+// TITLE: CAN telemetry and configuration interface on DCAN-A
+//
+// DESCRIPTION:
+// DCAN set-up, loopback self-test, the transmit queue with its
+// interrupt-driven refill, and the background scheduler and parameter
+// access.
+//
+// The message objects are accessed through the IF register sets: IF1
+// from the background (always with interrupts disabled once running),
+// IF2 from tlm_isr(). The ISR and everything it calls are in HotIsr.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "telemetry.h"
+#include "irq_nest.h"
+#include "supervisor.h"
+#include "bench.h"
+#include "memory_plan.h"
+#include "flash_log.h"
+#include "flight_recorder.h"
+#include "params.h"
+#include "temp_monitor.h"
+#include "mains_meas.h"
+#include "decim.h"
+#include "adc_cal.h"
+#include "stats.h"
+#include "Test_GPIO.h"
+
+//
+// Defines
+//
+#define TLM_BTR                 ((uint32_t)((TLM_BRP - 1U) & 0x3FU) |          \
+                                 ((uint32_t)(TLM_SJW - 1U) << 6) |              \
+                                 ((uint32_t)(TLM_TSEG1 - 1U) << 8) |            \
+                                 ((uint32_t)(TLM_TSEG2 - 1U) << 12) |           \
+                                 ((uint32_t)((TLM_BRP - 1U) >> 6) << 16))
+
+#define TLM_RAM_INIT_START      0x1AUL      // KEY 0xA | CAN_RAM_INIT
+#define TLM_RAM_INIT_MASK       0x3FUL
+#define TLM_RAM_INIT_DONE       0x2AUL      // KEY 0xA | RAM_INIT_DONE
+
+//
+// IFxCMD
+//
+#define TLM_IFCMD_DIR           0x00800000UL    // Write to the object
+#define TLM_IFCMD_MASK          0x00400000UL
+#define TLM_IFCMD_ARB           0x00200000UL
+#define TLM_IFCMD_CONTROL       0x00100000UL
+#define TLM_IFCMD_CLRINTPND     0x00080000UL
+#define TLM_IFCMD_TXRQST        0x00040000UL    // Read: clear NewDat
+#define TLM_IFCMD_DATA_A        0x00020000UL
+#define TLM_IFCMD_DATA_B        0x00010000UL
+#define TLM_IFCMD_BUSY          0x00008000UL
+
+//
+// IFxARB, IFxMSK, IFxMCTL
+//
+#define TLM_ARB_MSGVAL          0x80000000UL
+#define TLM_ARB_DIR             0x20000000UL    // Transmit
+#define TLM_ARB_STD_SHIFT       18U
+#define TLM_MSK_MDIR            0x40000000UL
+#define TLM_MSK_STD             (0x7FFUL << TLM_ARB_STD_SHIFT)
+#define TLM_MCTL_UMASK          0x1000UL
+#define TLM_MCTL_TXIE           0x0800UL
+#define TLM_MCTL_RXIE           0x0400UL
+#define TLM_MCTL_TXRQST         0x0100UL
+#define TLM_MCTL_EOB            0x0080UL
+#define TLM_MCTL_DLC            0x000FUL
+
+#define TLM_ES_BOFF             0x0080UL
+#define TLM_INT_STATUS          0x8000U
+
+#define TLM_SELFTEST_CYCLES     120000UL    // 1 ms
+
+//
+// One IF register set, as laid out from CAN_IFxCMD
+//
+typedef struct
+{
+    uint32_t cmd;
+    uint32_t msk;
+    uint32_t arb;
+    uint32_t mctl;
+    uint32_t data;
+    uint32_t datb;
+} TlmIfRegs;
+
+#define TLM_IF1                 ((volatile TlmIfRegs *)&CanaRegs.CAN_IF1CMD)
+#define TLM_IF2                 ((volatile TlmIfRegs *)&CanaRegs.CAN_IF2CMD)
+
+//
+// Globals
+//
+uint16_t tlm_selfTest;
+uint32_t tlm_txFrames;
+uint16_t tlm_txDropped;
+uint32_t tlm_rxFrames;
+uint16_t tlm_rxDropped;
+uint16_t tlm_busOff;
+
+#pragma DATA_SECTION(tlm_txQueue, "TelemetryRing");
+#pragma DATA_SECTION(tlm_rxQueue, "TelemetryRing");
+static TlmFrame tlm_txQueue[TLM_TX_QUEUE];
+static TlmFrame tlm_rxQueue[TLM_RX_QUEUE];
+static volatile uint16_t tlm_txHead;
+static volatile uint16_t tlm_txTail;
+static volatile uint16_t tlm_txIdle;        // Mailbox empty, refill from poll
+static volatile uint16_t tlm_rxHead;
+static volatile uint16_t tlm_rxTail;
+static uint16_t tlm_wasBusOff;
+static uint32_t tlm_statusAtMs;
+static uint32_t tlm_mainsAtMs;
+static DecReader tlm_decReader[NUM_CHANNELS];
+static int32_t tlm_decSum[NUM_CHANNELS];
+static uint16_t tlm_decCount[NUM_CHANNELS];
+static int16_t tlm_frSlot = -1;             // Capture being sent
+static uint16_t tlm_frFrame;                // Next TLM_ID_CAPTURE frame
+static int32_t tlm_calLowMv[NUM_CHANNELS];  // TLM_OP_CAL_LOW point
+static uint32_t tlm_calLowQ4[NUM_CHANNELS];
+static uint16_t tlm_calLow;                 // Channels with a low point
+
+PLAN_CHECK(telemetry_queues,
+           (sizeof(tlm_txQueue) + sizeof(tlm_rxQueue)) <= PLAN_TELEMETRY_WORDS);
+
+static const uint16_t tlm_ratingAmps[] = {32U, 20U, 13U};
+
+//
+// Function Prototypes
+//
+static void tlm_self_test(void);
+static void tlm_dec_read(void);
+static void tlm_levels(TlmFrame *frame);
+static void tlm_fr_send(void);
+static uint16_t tlm_tx_free(void);
+static uint16_t tlm_cal(uint16_t ch, uint16_t op, int32_t *value);
+static void tlm_enqueue(const TlmFrame *frame);
+static void tlm_apply(const TlmFrame *frame);
+static void tlm_put16(uint16_t *data, uint16_t value);
+static void tlm_put32(uint16_t *data, uint32_t value);
+static void tlm_tx_next(volatile TlmIfRegs *ifr);
+static void tlm_if_send(volatile TlmIfRegs *ifr, const TlmFrame *frame);
+static void tlm_if_set_rx(volatile TlmIfRegs *ifr, uint16_t obj, uint16_t id,
+                          uint32_t ie);
+static void tlm_if_read(volatile TlmIfRegs *ifr, uint16_t obj,
+                        TlmFrame *frame);
+static void tlm_if_command(volatile TlmIfRegs *ifr, uint32_t cmd);
+
+//
+// The ISR and its helpers must not run from flash (see flash_log.h)
+//
+#pragma CODE_SECTION(tlm_isr, "HotIsr");
+#pragma CODE_SECTION(tlm_tx_next, "HotIsr");
+#pragma CODE_SECTION(tlm_if_send, "HotIsr");
+#pragma CODE_SECTION(tlm_if_read, "HotIsr");
+#pragma CODE_SECTION(tlm_if_command, "HotIsr");
+
+//
+// tlm_init - Set up DCAN-A, run the loopback self-test and map the ISR.
+// Call after InitPieVectTable(), with interrupts still disabled.
+//
+void tlm_init(void)
+{
+    EALLOW;
+    CpuSysRegs.PCLKCR10.bit.CAN_A = 1;
+    EDIS;
+
+    GPIO_SetupPinMux(TLM_GPIO_RX, GPIO_MUX_CPU1, TLM_GPIO_MUX);
+    GPIO_SetupPinOptions(TLM_GPIO_RX, GPIO_INPUT, GPIO_ASYNC);
+    GPIO_SetupPinMux(TLM_GPIO_TX, GPIO_MUX_CPU1, TLM_GPIO_MUX);
+    GPIO_SetupPinOptions(TLM_GPIO_TX, GPIO_OUTPUT, GPIO_PUSHPULL);
+
+    //
+    // Clear the message RAM (all objects invalid), then the bit timing
+    //
+    CanaRegs.CAN_CTL.bit.Init = 1;
+    CanaRegs.CAN_RAM_INIT.all = TLM_RAM_INIT_START;
+    while(TLM_RAM_INIT_DONE != (CanaRegs.CAN_RAM_INIT.all & TLM_RAM_INIT_MASK))
+    {
+    }
+
+    CanaRegs.CAN_CTL.bit.CCE = 1;
+    CanaRegs.CAN_BTR.all = TLM_BTR;
+    CanaRegs.CAN_CTL.bit.CCE = 0;
+    CanaRegs.CAN_CTL.bit.ABO = 1;           // Automatic recovery from bus-off
+
+    tlm_if_set_rx(TLM_IF1, TLM_OBJ_CONFIG, TLM_ID_CONFIG, TLM_MCTL_RXIE);
+
+    tlm_txHead = 0;
+    tlm_txTail = 0;
+    tlm_txIdle = 1;
+    tlm_rxHead = 0;
+    tlm_rxTail = 0;
+    tlm_txFrames = 0;
+    tlm_txDropped = 0;
+    tlm_rxFrames = 0;
+    tlm_rxDropped = 0;
+    tlm_busOff = 0;
+    tlm_wasBusOff = 0;
+    tlm_statusAtMs = 0;
+    tlm_mainsAtMs = 0;
+    tlm_frSlot = -1;
+    tlm_calLow = 0;
+
+    tlm_self_test();
+
+    CanaRegs.CAN_CTL.bit.Init = 0;
+
+    EALLOW;
+    PieVectTable.CANA0_INT = &tlm_isr;
+    EDIS;
+}
+
+//
+// tlm_start - Enable the CAN interrupt
+//
+void tlm_start(void)
+{
+    CanaRegs.CAN_CTL.bit.IE0 = 1;
+    CanaRegs.CAN_GLB_INT_EN.bit.GLBINT0_EN = 1;
+
+    PieCtrlRegs.PIEIER9.bit.INTx5 = 1;
+    IER |= M_INT9;
+}
+
+//
+// tlm_dec_init - Start reading the decimated streams. Call after
+// dec_init().
+//
+void tlm_dec_init(void)
+{
+    uint16_t ch;
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        dec_reader_init(&dec[ch].out[DEC_STAGE_TLM], &tlm_decReader[ch]);
+        tlm_decSum[ch] = 0;
+        tlm_decCount[ch] = 0;
+    }
+}
+
+//
+// tlm_poll - Background task: apply configuration writes, queue the
+// periodic frames that are due and restart transmission if it is idle.
+//
+void tlm_poll(void)
+{
+    TlmFrame frame;
+    uint32_t now = flog_time_ms();
+    uint16_t intState, busOff, flags;
+
+    sup_checkin(SUP_TASK_TELEMETRY);
+
+    busOff = (0UL != (CanaRegs.CAN_ES.all & TLM_ES_BOFF));
+    if(busOff && !tlm_wasBusOff)
+    {
+        tlm_busOff++;
+    }
+    tlm_wasBusOff = busOff;
+
+    while(tlm_rxTail != tlm_rxHead)
+    {
+        tlm_apply(&tlm_rxQueue[tlm_rxTail]);
+        tlm_rxTail = (tlm_rxTail + 1U) % TLM_RX_QUEUE;
+    }
+
+    tlm_dec_read();
+
+    if((now - tlm_statusAtMs) >= (uint32_t)param_value[PARAM_TLM_STATUS_MS])
+    {
+        tlm_statusAtMs = now;
+
+        flags = 0;
+        if(sup_tripped)
+        {
+            flags |= TLM_FLAG_TRIPPED;
+        }
+        if(sup_tripReset)
+        {
+            flags |= TLM_FLAG_TRIP_RESET;
+        }
+        if(TEMP_RATING_32A != temp_rating)
+        {
+            flags |= TLM_FLAG_DERATED;
+        }
+        if(0 == mains_freqCHz)
+        {
+            flags |= TLM_FLAG_NO_MAINS;
+        }
+        if(0 != flog_errors)
+        {
+            flags |= TLM_FLAG_LOG_ERROR;
+        }
+
+        frame.id = TLM_ID_STATUS;
+        frame.dlc = 8;
+        frame.data[0] = cp_level;
+        frame.data[1] = temp_rating;
+        frame.data[2] = tlm_ratingAmps[temp_rating];
+        frame.data[3] = flags;
+        tlm_put16(&frame.data[4], (uint16_t)temp_cableQ4);
+        tlm_put16(&frame.data[6], (uint16_t)temp_maxQ4);
+        tlm_enqueue(&frame);
+
+        tlm_levels(&frame);
+        tlm_enqueue(&frame);
+    }
+
+    if((now - tlm_mainsAtMs) >= (uint32_t)param_value[PARAM_TLM_MAINS_MS])
+    {
+        tlm_mainsAtMs = now;
+
+        frame.id = TLM_ID_MAINS;
+        frame.dlc = 8;
+        tlm_put16(&frame.data[0], mains_rmsDv);
+        tlm_put16(&frame.data[2], mains_freqCHz);
+        tlm_put16(&frame.data[4], (uint16_t)fr_triggerCount);
+        tlm_put16(&frame.data[6], tlm_txDropped);
+        tlm_enqueue(&frame);
+    }
+
+    tlm_fr_send();
+
+    intState = __disable_interrupts();
+    if(tlm_txIdle)
+    {
+        tlm_tx_next(TLM_IF1);
+    }
+    __restore_interrupts(intState);
+}
+
+//
+// tlm_dec_read - Add the new samples of the 1 kS/s streams to the sums of
+// the next TLM_ID_LEVELS frame
+//
+static void tlm_dec_read(void)
+{
+    uint16_t ch;
+    int16_t v;
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        while(dec_read(&dec[ch].out[DEC_STAGE_TLM], &tlm_decReader[ch], &v))
+        {
+            if(tlm_decCount[ch] < 0xFFFFU)
+            {
+                tlm_decSum[ch] += v;
+                tlm_decCount[ch]++;
+            }
+        }
+    }
+}
+
+//
+// tlm_levels - TLM_ID_LEVELS frame from the sums, which restart. A channel
+// without samples reports the last stream sample.
+//
+static void tlm_levels(TlmFrame *frame)
+{
+    const DecStream *s;
+    uint16_t ch, lost = 0;
+    int16_t mean;
+
+    frame->id = TLM_ID_LEVELS;
+    frame->dlc = 8;
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        s = &dec[ch].out[DEC_STAGE_TLM];
+        if(0U != tlm_decCount[ch])
+        {
+            mean = (int16_t)(tlm_decSum[ch] / (int32_t)tlm_decCount[ch]);
+        }
+        else
+        {
+            mean = s->buf[(s->head - 1U) & s->mask];
+        }
+        tlm_put16(&frame->data[2U * ch], (uint16_t)mean);
+        lost += tlm_decReader[ch].lost;
+
+        tlm_decSum[ch] = 0;
+        tlm_decCount[ch] = 0;
+    }
+    tlm_put16(&frame->data[6], lost);
+}
+
+//
+// tlm_fr_send - Queue the next frames of the capture being read out while
+// more than TLM_TX_RESERVE places are free; release the slot after the
+// last one
+//
+static void tlm_fr_send(void)
+{
+    const FR_Slot *slot;
+    TlmFrame frame;
+    uint16_t i, n;
+
+    if(tlm_frSlot < 0)
+    {
+        return;
+    }
+
+    slot = &fr_slots[tlm_frSlot];
+    while((tlm_frFrame <= TLM_FR_FRAMES) && (tlm_tx_free() > TLM_TX_RESERVE))
+    {
+        frame.id = TLM_ID_CAPTURE;
+        frame.dlc = 8;
+        frame.data[0] = (uint16_t)tlm_frSlot;
+        frame.data[1] = tlm_frFrame;
+        if(0U == tlm_frFrame)
+        {
+            frame.data[2] = slot->channel;
+            frame.data[3] = slot->cause;
+            tlm_put32(&frame.data[4], slot->sequence);
+        }
+        else
+        {
+            n = (tlm_frFrame - 1U) * 3U;
+            for(i = 0; i < 3U; i++)
+            {
+                tlm_put16(&frame.data[2U + 2U * i],
+                          ((n + i) < FR_SLOT_SAMPLES) ? slot->samples[n + i] :
+                                                        0U);
+            }
+        }
+        tlm_enqueue(&frame);
+        tlm_frFrame++;
+    }
+
+    if(tlm_frFrame > TLM_FR_FRAMES)
+    {
+        fr_release_capture((uint16_t)tlm_frSlot);
+        tlm_frSlot = -1;
+    }
+}
+
+//
+// tlm_tx_free - Places left in the transmit queue
+//
+static uint16_t tlm_tx_free(void)
+{
+    return (uint16_t)((tlm_txTail + TLM_TX_QUEUE - 1U - tlm_txHead) %
+                      TLM_TX_QUEUE);
+}
+
+//
+// tlm_isr - Transmit complete: load the next frame. Receive: queue the
+// configuration frame for tlm_poll().
+//
+__interrupt void tlm_isr(void)
+{
+    IrqNestFrame frame;
+    uint16_t obj;
+
+    irq_nest_enter(&frame, IRQ_ID_CAN, IRQ_IER_COMM,
+                   &PieCtrlRegs.PIEIER9.all, IRQ_PIE_KEEP, PIEACK_GROUP9);
+
+    while(0U != (obj = CanaRegs.CAN_INT.bit.INT0ID))
+    {
+        if(TLM_OBJ_TX == obj)
+        {
+            tlm_if_command(TLM_IF2, TLM_IFCMD_CLRINTPND | obj);
+            tlm_txFrames++;
+            tlm_tx_next(TLM_IF2);
+        }
+        else if(TLM_OBJ_CONFIG == obj)
+        {
+            uint16_t next = (tlm_rxHead + 1U) % TLM_RX_QUEUE;
+
+            if(next == tlm_rxTail)
+            {
+                TlmFrame discard;
+
+                tlm_if_read(TLM_IF2, obj, &discard);
+                tlm_rxDropped++;
+            }
+            else
+            {
+                tlm_if_read(TLM_IF2, obj, &tlm_rxQueue[tlm_rxHead]);
+                tlm_rxHead = next;
+                tlm_rxFrames++;
+            }
+        }
+        else if(TLM_INT_STATUS == obj)
+        {
+            (void)CanaRegs.CAN_ES.all;      // Read clears the status interrupt
+        }
+        else
+        {
+            tlm_if_command(TLM_IF2, TLM_IFCMD_CLRINTPND | obj);
+        }
+    }
+
+    CanaRegs.CAN_GLB_INT_CLR.bit.INT0_FLG_CLR = 1;
+
+    irq_nest_exit(&frame, &PieCtrlRegs.PIEIER9.all);
+}
+
+//
+// tlm_self_test - Internal loopback: the transmit mailbox sends a pattern
+// that a receive mailbox must return unchanged within 1 ms.
+//
+static void tlm_self_test(void)
+{
+    TlmFrame tx, rx;
+    uint32_t t0;
+    uint16_t i, ok;
+
+    CanaRegs.CAN_CTL.bit.Test = 1;
+    CanaRegs.CAN_TEST.bit.LBACK = 1;
+    CanaRegs.CAN_CTL.bit.Init = 0;
+
+    tlm_if_set_rx(TLM_IF1, TLM_OBJ_SELFTEST, TLM_ID_SELFTEST, 0);
+
+    tx.id = TLM_ID_SELFTEST;
+    tx.dlc = 8;
+    for(i = 0; i < 8U; i++)
+    {
+        tx.data[i] = (0x11U * i) ^ 0xA5U;
+    }
+    tlm_if_send(TLM_IF1, &tx);
+
+    ok = 0;
+    t0 = BENCH_NOW();
+    while((t0 - BENCH_NOW()) < TLM_SELFTEST_CYCLES)
+    {
+        if(CanaRegs.CAN_NDAT_21.all & (1UL << (TLM_OBJ_SELFTEST - 1U)))
+        {
+            ok = 1;
+            break;
+        }
+    }
+
+    if(ok)
+    {
+        tlm_if_read(TLM_IF1, TLM_OBJ_SELFTEST, &rx);
+        ok = (rx.id == tx.id) && (rx.dlc == tx.dlc);
+        for(i = 0; i < 8U; i++)
+        {
+            if(rx.data[i] != tx.data[i])
+            {
+                ok = 0;
+            }
+        }
+    }
+    tlm_selfTest = ok ? TLM_SELFTEST_PASS : TLM_SELFTEST_FAIL;
+
+    //
+    // Invalidate the test object, clear the transmit interrupt it left
+    // pending and go back to normal mode
+    //
+    TLM_IF1->arb = 0;
+    tlm_if_command(TLM_IF1, TLM_IFCMD_DIR | TLM_IFCMD_ARB | TLM_OBJ_SELFTEST);
+    tlm_if_command(TLM_IF1, TLM_IFCMD_CLRINTPND | TLM_OBJ_TX);
+
+    CanaRegs.CAN_CTL.bit.Init = 1;
+    CanaRegs.CAN_TEST.bit.LBACK = 0;
+    CanaRegs.CAN_CTL.bit.Test = 0;
+}
+
+//
+// tlm_enqueue - Queue a frame for transmission, drop it when full
+//
+static void tlm_enqueue(const TlmFrame *frame)
+{
+    uint16_t intState, next;
+
+    intState = __disable_interrupts();
+
+    next = (tlm_txHead + 1U) % TLM_TX_QUEUE;
+    if(next == tlm_txTail)
+    {
+        tlm_txDropped++;
+    }
+    else
+    {
+        tlm_txQueue[tlm_txHead] = *frame;
+        tlm_txHead = next;
+    }
+
+    __restore_interrupts(intState);
+}
+
+//
+// tlm_apply - Parameter access, answered with an ack frame
+//
+static void tlm_apply(const TlmFrame *frame)
+{
+    TlmFrame ack;
+    int32_t value;
+    uint16_t id, op, status;
+
+    id = frame->data[0];
+    op = frame->data[1];
+    value = (int32_t)((uint32_t)frame->data[2] |
+                      ((uint32_t)frame->data[3] << 8) |
+                      ((uint32_t)frame->data[4] << 16) |
+                      ((uint32_t)frame->data[5] << 24));
+
+    switch(op)
+    {
+        case TLM_OP_WRITE:
+            status = (frame->dlc < 6U) ? PARAM_ERR_RANGE :
+                                         params_write(id, value);
+            break;
+
+        case TLM_OP_READ:
+            value = 0;
+            status = params_read(id, &value);
+            break;
+
+        case TLM_OP_SAVE:
+            value = 0;
+            status = params_save();
+            break;
+
+        case TLM_OP_DEFAULTS:
+            value = 0;
+            status = params_defaults();
+            break;
+
+        case TLM_OP_CAL_LOW:
+        case TLM_OP_CAL_HIGH:
+            status = tlm_cal(id, op, &value);
+            break;
+
+        case TLM_OP_FR_READ:
+            value = 0;
+            status = TLM_ERR_NO_CAPTURE;
+            if(tlm_frSlot < 0)
+            {
+                tlm_frSlot = fr_find_ready();
+                if(tlm_frSlot >= 0)
+                {
+                    tlm_frFrame = 0;
+                    value = (int32_t)fr_slots[tlm_frSlot].sequence;
+                    status = PARAM_OK;
+                }
+            }
+            break;
+
+        default:
+            status = TLM_OP_ERR;
+            break;
+    }
+
+    ack.id = TLM_ID_CONFIG_ACK;
+    ack.dlc = 8;
+    ack.data[0] = id & 0xFFU;
+    ack.data[1] = status;
+    tlm_put32(&ack.data[2], (uint32_t)value);
+    ack.data[6] = op & 0xFFU;
+    ack.data[7] = (0UL != param_pendingMask);
+    tlm_enqueue(&ack);
+}
+
+//
+// tlm_cal - TLM_OP_CAL_LOW/HIGH on one channel; *value is the reference
+// in mV on entry and the reading in Q4 counts on return
+//
+static uint16_t tlm_cal(uint16_t ch, uint16_t op, int32_t *value)
+{
+    int32_t refMv = *value;
+    uint32_t readQ4;
+
+    if(NUM_CHANNELS <= ch)
+    {
+        return PARAM_ERR_ID;
+    }
+
+    readQ4 = (stats_snap[ch].meanQ4 > 0) ? (uint32_t)stats_snap[ch].meanQ4 :
+                                           0UL;
+    *value = (int32_t)readQ4;
+
+    if(TLM_OP_CAL_LOW == op)
+    {
+        tlm_calLowMv[ch] = refMv;
+        tlm_calLowQ4[ch] = readQ4;
+        tlm_calLow |= 1U << ch;
+        return PARAM_OK;
+    }
+
+    if((0U == (tlm_calLow & (1U << ch))) ||
+       !adc_cal_fit(ch, tlm_calLowMv[ch], tlm_calLowQ4[ch], refMv, readQ4))
+    {
+        return PARAM_ERR_RANGE;
+    }
+    tlm_calLow &= ~(1U << ch);
+
+    return PARAM_OK;
+}
+
+//
+// tlm_put16, tlm_put32 - Little-endian fields, one byte per word
+//
+static void tlm_put16(uint16_t *data, uint16_t value)
+{
+    data[0] = value & 0xFFU;
+    data[1] = value >> 8;
+}
+
+static void tlm_put32(uint16_t *data, uint32_t value)
+{
+    tlm_put16(&data[0], (uint16_t)value);
+    tlm_put16(&data[2], (uint16_t)(value >> 16));
+}
+
+//
+// tlm_tx_next - Load the next queued frame into the transmit mailbox, or
+// mark it idle. Called with the CAN interrupt masked.
+//
+static void tlm_tx_next(volatile TlmIfRegs *ifr)
+{
+    if(tlm_txTail == tlm_txHead)
+    {
+        tlm_txIdle = 1;
+        return;
+    }
+
+    tlm_txIdle = 0;
+    tlm_if_send(ifr, &tlm_txQueue[tlm_txTail]);
+    tlm_txTail = (tlm_txTail + 1U) % TLM_TX_QUEUE;
+}
+
+//
+// tlm_if_send - Write a frame to the transmit mailbox and request it
+//
+static void tlm_if_send(volatile TlmIfRegs *ifr, const TlmFrame *frame)
+{
+    const uint16_t *d = frame->data;
+
+    ifr->arb = TLM_ARB_MSGVAL | TLM_ARB_DIR |
+               ((uint32_t)frame->id << TLM_ARB_STD_SHIFT);
+    ifr->mctl = TLM_MCTL_TXIE | TLM_MCTL_EOB | TLM_MCTL_TXRQST |
+                ((uint32_t)frame->dlc & TLM_MCTL_DLC);
+    ifr->data = (uint32_t)d[0] | ((uint32_t)d[1] << 8) |
+                ((uint32_t)d[2] << 16) | ((uint32_t)d[3] << 24);
+    ifr->datb = (uint32_t)d[4] | ((uint32_t)d[5] << 8) |
+                ((uint32_t)d[6] << 16) | ((uint32_t)d[7] << 24);
+
+    tlm_if_command(ifr, TLM_IFCMD_DIR | TLM_IFCMD_ARB | TLM_IFCMD_CONTROL |
+                        TLM_IFCMD_DATA_A | TLM_IFCMD_DATA_B |
+                        TLM_IFCMD_CLRINTPND | TLM_IFCMD_TXRQST | TLM_OBJ_TX);
+}
+
+//
+// tlm_if_set_rx - Configure a receive mailbox for exactly one standard ID
+//
+static void tlm_if_set_rx(volatile TlmIfRegs *ifr, uint16_t obj, uint16_t id,
+                          uint32_t ie)
+{
+    ifr->msk = TLM_MSK_MDIR | TLM_MSK_STD;
+    ifr->arb = TLM_ARB_MSGVAL | ((uint32_t)id << TLM_ARB_STD_SHIFT);
+    ifr->mctl = TLM_MCTL_UMASK | TLM_MCTL_EOB | ie | 8UL;
+
+    tlm_if_command(ifr, TLM_IFCMD_DIR | TLM_IFCMD_MASK | TLM_IFCMD_ARB |
+                        TLM_IFCMD_CONTROL | TLM_IFCMD_CLRINTPND | obj);
+}
+
+//
+// tlm_if_read - Read a received frame, clearing NewDat and IntPnd
+//
+static void tlm_if_read(volatile TlmIfRegs *ifr, uint16_t obj,
+                        TlmFrame *frame)
+{
+    uint32_t a, b;
+
+    tlm_if_command(ifr, TLM_IFCMD_ARB | TLM_IFCMD_CONTROL | TLM_IFCMD_DATA_A |
+                        TLM_IFCMD_DATA_B | TLM_IFCMD_CLRINTPND |
+                        TLM_IFCMD_TXRQST | obj);
+
+    frame->id = (uint16_t)((ifr->arb >> TLM_ARB_STD_SHIFT) & 0x7FFUL);
+    frame->dlc = (uint16_t)(ifr->mctl & TLM_MCTL_DLC);
+
+    a = ifr->data;
+    b = ifr->datb;
+    frame->data[0] = (uint16_t)(a & 0xFFUL);
+    frame->data[1] = (uint16_t)((a >> 8) & 0xFFUL);
+    frame->data[2] = (uint16_t)((a >> 16) & 0xFFUL);
+    frame->data[3] = (uint16_t)(a >> 24);
+    frame->data[4] = (uint16_t)(b & 0xFFUL);
+    frame->data[5] = (uint16_t)((b >> 8) & 0xFFUL);
+    frame->data[6] = (uint16_t)((b >> 16) & 0xFFUL);
+    frame->data[7] = (uint16_t)(b >> 24);
+}
+
+//
+// tlm_if_command - Start an IF transfer and wait for it (a few cycles)
+//
+static void tlm_if_command(volatile TlmIfRegs *ifr, uint32_t cmd)
+{
+    ifr->cmd = cmd;
+    while(ifr->cmd & TLM_IFCMD_BUSY)
+    {
+    }
+}
+
+//
+// End of File
+//
@@ -0,0 +1,171 @@
+//#############################################################################
+//
+// FILE: telemetry.h
+//
+// TITLE: CAN telemetry and configuration interface on DCAN-A
+//
+// DESCRIPTION:
+// Publishes the cable status and the mains measurement as periodic
+// standard-ID frames at 500 kbit/s and gives access to the parameter
+// table (params.h):
+//
+//     ID                  dir  data
+//     TLM_ID_STATUS       tx   0: CP level (CP_LEVEL_*), 1: TempRating,
+//                              2: advertised current A, 3: TLM_FLAG_*,
+//                              4-5: cable temperature Q4, 6-7: max Q4
+//     TLM_ID_MAINS        tx   0-1: RMS 0.1 V, 2-3: frequency 0.01 Hz,
+//                              4-5: flight recorder captures,
+//                              6-7: dropped telemetry frames
+//     TLM_ID_LEVELS       tx   0-1: IN_ADC_500VAC, 2-3: IN_CP_ADC,
+//                              4-5: IN_CP_BORNE: mean of the 1 kS/s
+//                              decimated stream (decim.h) since the last
+//                              frame, Q3 counts, int16; 6-7: decimated
+//                              samples lost. Sent with TLM_ID_STATUS
+//     TLM_ID_CAPTURE      tx   0: slot, 1: frame number. Frame 0:
+//                              2: channel, 3: FR_CAUSE_*, 4-7: sequence;
+//                              frames 1..TLM_FR_FRAMES: 2-7: three samples,
+//                              oldest first (flight_recorder.h)
+//     TLM_ID_CONFIG       rx   0: register (PARAM_*), 1: TLM_OP_*,
+//                              2-5: value, int32
+//     TLM_ID_CONFIG_ACK   tx   0: register, 1: status (PARAM_OK,
+//                              PARAM_ERR_*), 2-5: value, 6: TLM_OP_*,
+//                              7: 1 while writes wait for the commit
+//
+// TLM_OP_FR_READ streams the oldest completed flight recorder capture as
+// TLM_ID_CAPTURE frames, a few per tlm_poll() so the periodic frames keep
+// TLM_TX_RESERVE places in the queue, and releases its slot after the last
+// frame. The ack carries the sequence number, or TLM_ERR_NO_CAPTURE when
+// no capture is ready or one is still being sent.
+//
+// TLM_OP_CAL_LOW and TLM_OP_CAL_HIGH calibrate the channel given as the
+// register: value is the reference in mV applied to its input, and the
+// reading is the mean of the last statistics window of the channel
+// (stats_snap[], stats.h), so wait one window after applying it. LOW keeps
+// the point, HIGH fits gain and offset through both (adc_cal_fit()); the
+// ack value is the reading in Q4 counts, the status PARAM_ERR_RANGE for
+// an implausible fit or a missing low point. TLM_OP_SAVE keeps the fit.
+//
+// Multi-byte fields are little endian. Written values take effect at the
+// next params_commit(); TLM_OP_SAVE stores the active values in flash and
+// holds the background loop for one sector erase, with the watchdog
+// serviced meanwhile (supervisor.h).
+//
+// Frames are queued by tlm_poll() in the background. One transmit
+// mailbox sends them; its transmit-complete interrupt (CANA0, PIE 9.5,
+// communication level in irq_nest.h) loads the next queued frame, so the
+// background never waits for the bus. When the bus is gone the queue
+// fills and further frames are counted in tlm_txDropped; acquisition is
+// not affected. Configuration frames are read into a small queue by the
+// same ISR and applied by tlm_poll().
+//
+// tlm_init() runs a self-test in internal loopback (no bus needed): a
+// frame sent on the transmit mailbox must arrive unchanged in a receive
+// mailbox. The result is in tlm_selfTest.
+//
+//#############################################################################
+
+#ifndef _telemetry_h
+#define _telemetry_h
+
+#include <stdint.h>
+#include "flight_recorder.h"
+
+//
+// Defines
+//
+
+//
+// Bit timing: CAN clock = SYSCLK 120 MHz, /12 -> 10 MHz quanta,
+// 1 + 15 + 4 = 20 quanta per bit -> 500 kbit/s, sample point 80 %
+//
+#define TLM_BRP                 12U
+#define TLM_TSEG1               15U
+#define TLM_TSEG2               4U
+#define TLM_SJW                 4U
+
+//
+// CANA pins (GPIO mux position 1)
+//
+#define TLM_GPIO_RX             30U
+#define TLM_GPIO_TX             31U
+#define TLM_GPIO_MUX            1U
+
+#define TLM_ID_BASE             0x300U
+#define TLM_ID_STATUS           (TLM_ID_BASE + 0x00U)
+#define TLM_ID_MAINS            (TLM_ID_BASE + 0x01U)
+#define TLM_ID_LEVELS           (TLM_ID_BASE + 0x02U)
+#define TLM_ID_CAPTURE          (TLM_ID_BASE + 0x03U)
+#define TLM_ID_CONFIG           (TLM_ID_BASE + 0x10U)
+#define TLM_ID_CONFIG_ACK       (TLM_ID_BASE + 0x11U)
+#define TLM_ID_SELFTEST         0x7F0U      // Loopback only
+
+//
+// Message objects
+//
+#define TLM_OBJ_TX              1U
+#define TLM_OBJ_CONFIG          2U
+#define TLM_OBJ_SELFTEST        3U
+
+#define TLM_TX_QUEUE            8U          // Frames
+#define TLM_RX_QUEUE            4U
+#define TLM_TX_RESERVE          4U          // Kept free by capture streaming
+#define TLM_FR_FRAMES           ((FR_SLOT_SAMPLES + 2U) / 3U)
+
+#define TLM_STATUS_MS_DEFAULT   100U
+#define TLM_MAINS_MS_DEFAULT    200U
+#define TLM_PERIOD_MIN_MS       10U
+#define TLM_PERIOD_MAX_MS       10000U
+
+//
+// Parameter access operations
+//
+#define TLM_OP_WRITE            0U
+#define TLM_OP_READ             1U
+#define TLM_OP_SAVE             2U          // Active values to flash
+#define TLM_OP_DEFAULTS         3U          // Queue the defaults
+#define TLM_OP_FR_READ          4U          // Send and release a capture
+#define TLM_OP_CAL_LOW          5U          // Low calibration point, mV
+#define TLM_OP_CAL_HIGH         6U          // High point, fit (adc_cal.h)
+#define TLM_OP_ERR              0xFFU       // Ack status: unknown operation
+#define TLM_ERR_NO_CAPTURE      0xFEU       // Ack status of TLM_OP_FR_READ
+
+//
+// Status flags
+//
+#define TLM_FLAG_TRIPPED        0x01U       // Supervisor trip this boot
+#define TLM_FLAG_TRIP_RESET     0x02U       // Reset by a supervisor trip
+#define TLM_FLAG_DERATED        0x04U       // Thermal derating active
+#define TLM_FLAG_NO_MAINS       0x08U
+#define TLM_FLAG_LOG_ERROR      0x10U       // Flash log write failures
+
+#define TLM_SELFTEST_NOT_RUN    0U
+#define TLM_SELFTEST_PASS       1U
+#define TLM_SELFTEST_FAIL       2U
+
+typedef struct
+{
+    uint16_t id;
+    uint16_t dlc;
+    uint16_t data[8];       // One byte per word
+} TlmFrame;
+
+//
+// Globals
+//
+extern uint16_t tlm_selfTest;
+extern uint32_t tlm_txFrames;
+extern uint16_t tlm_txDropped;              // Queue full
+extern uint32_t tlm_rxFrames;
+extern uint16_t tlm_rxDropped;
+extern uint16_t tlm_busOff;                 // Bus-off events
+
+//
+// Function Prototypes
+//
+void tlm_init(void);
+void tlm_start(void);
+void tlm_dec_init(void);
+void tlm_poll(void);
+__interrupt void tlm_isr(void);
+
+#endif
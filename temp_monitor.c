@@ -0,0 +1,293 @@
+//#############################################################################
+//
+// FILE: temp_monitor.c
+//
+// TITLE: Cable temperature monitoring and thermal current derating
+//
+// DESCRIPTION:
+// Low-rate temperature SOCs, fixed-point conversion and the PP resistor
+// derating policy. Only temp_monitor_init() touches OTP and does any
+// division; the per-sample path in temp_monitor_poll() is lookups, adds
+// and shifts.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "temp_monitor.h"
+#include "Test_GPIO.h"
+#include "flash_log.h"
+
+//
+// Defines
+//
+#define TEMP_OTP_TSSLOPE        (*(int16_t *)((uintptr_t)0x701C8))
+#define TEMP_OTP_TSOFFSET       (*(int16_t *)((uintptr_t)0x701C9))
+#define TEMP_VREFHI_MV          3300L       // SetVREF(ADC_INTERNAL, 3.3 V)
+#define TEMP_OTP_VREF_MV        2500L       // Reference of the OTP data
+
+//
+// Globals
+//
+int16_t temp_dieQ4;
+int16_t temp_ntcQ4;
+int16_t temp_cableQ4;
+int16_t temp_maxQ4;
+uint16_t temp_rating;
+uint16_t temp_derateCount;
+uint32_t temp_samples;
+
+static int16_t temp_dieLut[TEMP_LUT_SIZE];
+
+#if TEMP_NTC_ENABLE
+//
+// 10 k B3950 NTC to ground with a 10 k pull-up, Q4 degC for
+// raw = i * 64, clamped to -40 .. 150 degC
+//
+static const int16_t temp_ntcLut[TEMP_LUT_SIZE] =
+{
+    2400, 2400, 2069, 1804, 1626, 1492, 1386, 1297,
+    1221, 1155, 1096, 1042,  994,  949,  907,  868,
+     831,  797,  764,  732,  702,  673,  645,  618,
+     591,  566,  541,  516,  492,  469,  445,  423,
+     400,  378,  355,  333,  311,  289,  267,  245,
+     223,  201,  178,  155,  132,  109,   84,   60,
+      35,    9,  -18,  -46,  -75, -106, -139, -173,
+    -211, -252, -297, -349, -410, -484, -582, -640,
+    -640
+};
+#endif
+
+//
+// Function Prototypes
+//
+static void temp_build_die_lut(void);
+static void temp_init_soc(void);
+static void temp_apply_rating(uint16_t rating);
+
+//
+// temp_monitor_powerup - Power the sensor. It needs BOOT_ADC_POWERUP_US to
+// settle, the same as the ADC core, so both are started together and the
+// wait overlaps the rest of the boot sequence.
+//
+void temp_monitor_powerup(void)
+{
+    EALLOW;
+    AnalogSubsysRegs.TSNSCTL.bit.ENABLE = 1;
+    EDIS;
+}
+
+//
+// temp_monitor_init - Build the conversion table and set up the slow SOCs
+// and CPU Timer 0. Call after initADC_A().
+//
+void temp_monitor_init(void)
+{
+    temp_build_die_lut();
+    temp_init_soc();
+
+    EALLOW;
+    CpuTimer0Regs.TCR.bit.TSS = 1;          // Stop timer
+    CpuTimer0Regs.PRD.all = TEMP_TIMER_PERIOD;
+    CpuTimer0Regs.TPR.all = 0;
+    CpuTimer0Regs.TPRH.all = 0;
+    CpuTimer0Regs.TCR.bit.TIE = 1;          // Needed for the ADC trigger,
+                                            // INT1.7 stays disabled in PIE
+    CpuTimer0Regs.TCR.bit.FREE = 0;
+    CpuTimer0Regs.TCR.bit.SOFT = 0;
+    CpuTimer0Regs.TCR.bit.TRB = 1;          // Reload
+    EDIS;
+
+    temp_dieQ4 = TEMP_Q4(25);
+    temp_ntcQ4 = TEMP_Q4(25);
+    temp_cableQ4 = TEMP_Q4(25);
+    temp_maxQ4 = INT16_MIN;
+    temp_derateCount = 0;
+    temp_samples = 0;
+
+    temp_apply_rating(TEMP_RATING_32A);
+}
+
+//
+// temp_monitor_start - Start the periodic temperature conversions.
+//
+void temp_monitor_start(void)
+{
+    CpuTimer0Regs.TCR.bit.TSS = 0;
+}
+
+//
+// temp_monitor_poll - Background task. Converts a new reading when one is
+// available and re-evaluates the derating. Returns 1 if a reading was
+// processed.
+//
+uint16_t temp_monitor_poll(void)
+{
+    int16_t t;
+
+    if(0 == AdcaRegs.ADCINTFLG.bit.ADCINT4)
+    {
+        return 0;
+    }
+
+    t = temp_lut_lookup(temp_dieLut, AdcaResultRegs.ADCRESULT3);
+    temp_dieQ4 += (t - temp_dieQ4) >> TEMP_EWMA_SHIFT;
+    temp_cableQ4 = temp_dieQ4;
+
+#if TEMP_NTC_ENABLE
+    t = temp_lut_lookup(temp_ntcLut, AdcaResultRegs.ADCRESULT4);
+    temp_ntcQ4 += (t - temp_ntcQ4) >> TEMP_EWMA_SHIFT;
+    if(temp_ntcQ4 > temp_cableQ4)
+    {
+        temp_cableQ4 = temp_ntcQ4;
+    }
+#endif
+
+    AdcaRegs.ADCINTFLGCLR.bit.ADCINT4 = 1;
+    temp_samples++;
+
+    if(temp_cableQ4 > temp_maxQ4)
+    {
+        temp_maxQ4 = temp_cableQ4;
+    }
+
+    //
+    // Derating with hysteresis
+    //
+    switch(temp_rating)
+    {
+        case TEMP_RATING_32A:
+            if(temp_cableQ4 >= TEMP_Q4(TEMP_DERATE_13A_C))
+            {
+                temp_apply_rating(TEMP_RATING_13A);
+            }
+            else if(temp_cableQ4 >= TEMP_Q4(TEMP_DERATE_20A_C))
+            {
+                temp_apply_rating(TEMP_RATING_20A);
+            }
+            break;
+
+        case TEMP_RATING_20A:
+            if(temp_cableQ4 >= TEMP_Q4(TEMP_DERATE_13A_C))
+            {
+                temp_apply_rating(TEMP_RATING_13A);
+            }
+            else if(temp_cableQ4 <
+                    TEMP_Q4(TEMP_DERATE_20A_C - TEMP_HYSTERESIS_C))
+            {
+                temp_apply_rating(TEMP_RATING_32A);
+            }
+            break;
+
+        default:
+            if(temp_cableQ4 < TEMP_Q4(TEMP_DERATE_13A_C - TEMP_HYSTERESIS_C))
+            {
+                temp_apply_rating(TEMP_RATING_20A);
+            }
+            break;
+    }
+
+    return 1;
+}
+
+//
+// temp_build_die_lut - Tabulate the OTP calibration of the internal sensor:
+//
+//     degC = ((raw * VREFHI / 2.5 V) - offset) * 4096 / slope
+//
+static void temp_build_die_lut(void)
+{
+    int32_t slope = TEMP_OTP_TSSLOPE;
+    int32_t offset = TEMP_OTP_TSOFFSET;
+    int32_t raw, q4;
+    uint16_t i;
+
+    if(0 == slope)
+    {
+        slope = 1;                          // Blank OTP, avoid the divide trap
+    }
+
+    for(i = 0; i < TEMP_LUT_SIZE; i++)
+    {
+        raw = (int32_t)i << (12U - TEMP_LUT_BITS);
+        if(raw > 4095)
+        {
+            raw = 4095;
+        }
+
+        q4 = ((((raw * TEMP_VREFHI_MV) / TEMP_OTP_VREF_MV) - offset) * 65536L) /
+             slope;
+
+        if(q4 > INT16_MAX)
+        {
+            q4 = INT16_MAX;
+        }
+        else if(q4 < INT16_MIN)
+        {
+            q4 = INT16_MIN;
+        }
+        temp_dieLut[i] = (int16_t)q4;
+    }
+}
+
+//
+// temp_init_soc - Slow SOCs on CPU Timer 0, ADCINT4 at the end of the last
+//
+static void temp_init_soc(void)
+{
+    EALLOW;
+
+    AdcaRegs.ADCSOC3CTL.bit.CHSEL = TEMP_SENSOR_CHSEL;
+    AdcaRegs.ADCSOC3CTL.bit.ACQPS = TEMP_ACQPS;
+    AdcaRegs.ADCSOC3CTL.bit.TRIGSEL = 1;    // Trigger on CPU1 Timer 0
+
+#if TEMP_NTC_ENABLE
+    AdcaRegs.ADCSOC4CTL.bit.CHSEL = TEMP_NTC_CHSEL;
+    AdcaRegs.ADCSOC4CTL.bit.ACQPS = TEMP_ACQPS;
+    AdcaRegs.ADCSOC4CTL.bit.TRIGSEL = 1;
+    AdcaRegs.ADCINTSEL3N4.bit.INT4SEL = TEMP_NTC_SOC;
+#else
+    AdcaRegs.ADCINTSEL3N4.bit.INT4SEL = TEMP_SENSOR_SOC;
+#endif
+
+    AdcaRegs.ADCINTSEL3N4.bit.INT4CONT = 1; // Polled, no overflow state
+    AdcaRegs.ADCINTSEL3N4.bit.INT4E = 1;
+    AdcaRegs.ADCINTFLGCLR.bit.ADCINT4 = 1;
+
+    EDIS;
+}
+
+//
+// temp_apply_rating - Switch the PP resistor
+//
+static void temp_apply_rating(uint16_t rating)
+{
+    if(rating > temp_rating)
+    {
+        temp_derateCount++;
+    }
+    if(rating != temp_rating)
+    {
+        flog_append(FLOG_EV_DERATE, rating, (uint16_t)temp_cableQ4, 0, 0);
+    }
+    temp_rating = rating;
+
+    switch(rating)
+    {
+        case TEMP_RATING_32A:
+            select_PP_220R();
+            break;
+        case TEMP_RATING_20A:
+            select_PP_680R();
+            break;
+        default:
+            select_PP_1500R();
+            break;
+    }
+}
+
+//
+// End of File
+//
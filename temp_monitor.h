@@ -0,0 +1,109 @@
+//#############################################################################
+//
+// FILE: temp_monitor.h
+//
+// TITLE: Cable temperature monitoring and thermal current derating
+//
+// DESCRIPTION:
+// The internal temperature sensor (and optionally an external NTC on the
+// contacts) is converted by extra low-rate SOCs in the ADCA sequence,
+// triggered by CPU Timer 0 at TEMP_SAMPLE_RATE_HZ. The end of the last
+// slow SOC sets ADCINT4, which is polled from the background loop; no
+// interrupt is taken.
+//
+// Conversions use a 65-entry lookup table indexed by the top 6 bits of
+// the result and interpolated on the low 6 bits, so a reading costs a
+// table access and one 16x16 multiply. Temperatures are in Q4 degC.
+// The internal sensor table is built once at start-up from the OTP slope
+// and offset; the NTC table is a const table generated on the host.
+//
+// The derating policy picks the PP resistor, and with it the current
+// advertised by the cable, from the filtered temperature:
+//
+//     below TEMP_DERATE_20A_C          32 A (220 R)
+//     TEMP_DERATE_20A_C and above      20 A (680 R)
+//     TEMP_DERATE_13A_C and above      13 A (1500 R)
+//
+// A step back up needs the temperature to fall TEMP_HYSTERESIS_C below
+// the threshold that caused the step down.
+//
+//#############################################################################
+
+#ifndef _temp_monitor_h
+#define _temp_monitor_h
+
+#include <stdint.h>
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define TEMP_SAMPLE_RATE_HZ     100U
+#define TEMP_TIMER_PERIOD       ((SYSCLK_HZ / TEMP_SAMPLE_RATE_HZ) - 1UL)
+
+#define TEMP_SENSOR_SOC         3U          // Internal sensor, SOC3/ADCRESULT3
+#define TEMP_SENSOR_CHSEL       12U         // A12 - internal temperature sensor
+#define TEMP_ACQPS              63U         // 64 SYSCLK, high source impedance
+
+//
+// External NTC (10 k B3950, 10 k pull-up to VREFHI). Build with
+// TEMP_NTC_ENABLE=1 on boards that fit it.
+//
+#ifndef TEMP_NTC_ENABLE
+#define TEMP_NTC_ENABLE         0
+#endif
+#define TEMP_NTC_SOC            4U          // SOC4/ADCRESULT4
+#define TEMP_SOCS               (1U + TEMP_NTC_ENABLE)  // Per Timer 0 trigger
+#define TEMP_NTC_CHSEL          6U          // A6
+
+#define TEMP_LUT_BITS           6U
+#define TEMP_LUT_SIZE           ((1U << TEMP_LUT_BITS) + 1U)
+
+#define TEMP_Q4(degC)           ((int16_t)((degC) * 16))
+
+#define TEMP_DERATE_20A_C       70
+#define TEMP_DERATE_13A_C       85
+#define TEMP_HYSTERESIS_C       5
+
+#define TEMP_EWMA_SHIFT         3U          // ~8 samples, 80 ms
+
+typedef enum
+{
+    TEMP_RATING_32A = 0,                    // PP 220 R
+    TEMP_RATING_20A = 1,                    // PP 680 R
+    TEMP_RATING_13A = 2                     // PP 1500 R
+} TempRating;
+
+//
+// Globals
+//
+extern int16_t temp_dieQ4;                  // Internal sensor, filtered
+extern int16_t temp_ntcQ4;                  // NTC, filtered
+extern int16_t temp_cableQ4;                // Value the policy acts on
+extern int16_t temp_maxQ4;                  // Highest temp_cableQ4 since reset
+extern uint16_t temp_rating;                // TempRating currently advertised
+extern uint16_t temp_derateCount;           // Steps down since reset
+extern uint32_t temp_samples;
+
+//
+// Function Prototypes
+//
+void temp_monitor_powerup(void);
+void temp_monitor_init(void);
+void temp_monitor_start(void);
+uint16_t temp_monitor_poll(void);
+
+//
+// temp_lut_lookup - Convert a 12-bit result with a TEMP_LUT_SIZE table.
+//
+static inline int16_t temp_lut_lookup(const int16_t *lut, uint16_t raw)
+{
+    uint16_t index = raw >> (12U - TEMP_LUT_BITS);
+    int16_t frac = (int16_t)(raw & ((1U << (12U - TEMP_LUT_BITS)) - 1U));
+    int16_t lo = lut[index];
+
+    return(lo + (int16_t)(((int32_t)(lut[index + 1U] - lo) * frac) >>
+                          (12U - TEMP_LUT_BITS)));
+}
+
+#endif
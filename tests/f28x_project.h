@@ -0,0 +1,55 @@
+//#############################################################################
+//
+// FILE: f28x_project.h
+//
+// TITLE: Host stand-in for the device support header
+//
+// DESCRIPTION:
+// The host tests build the target sources with gcc. This header replaces
+// the C2000Ware one for them: the fixed-width types, the interrupt and
+// EALLOW intrinsics as no-ops, __interrupt, and CPU Timers 1 and 2 for
+// timebase.h and BENCH_NOW() (defined by the test that needs them, they
+// stand still). Sources that touch other peripheral registers are not
+// built on the host.
+//
+//#############################################################################
+
+#ifndef _f28x_project_h
+#define _f28x_project_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define EALLOW
+#define EDIS
+#define __interrupt
+
+typedef struct
+{
+    union
+    {
+        uint32_t all;
+    } TIM;
+    union
+    {
+        struct
+        {
+            uint16_t TIF;
+        } bit;
+    } TCR;
+} HostCpuTimerRegs;
+
+extern volatile HostCpuTimerRegs CpuTimer1Regs;
+extern volatile HostCpuTimerRegs CpuTimer2Regs;
+
+static inline uint16_t __disable_interrupts(void)
+{
+    return 0;
+}
+
+static inline void __restore_interrupts(uint16_t state)
+{
+    (void)state;
+}
+
+#endif
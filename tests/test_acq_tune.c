@@ -0,0 +1,352 @@
+//#############################################################################
+//
+// FILE: test_acq_tune.c
+//
+// TITLE: Host test of the ACQ_TUNE acquisition window sweep
+//
+// DESCRIPTION:
+// Builds acq_tune.c with ACQ_TUNE=1, with the adc_timing.c and stats.c it
+// uses, and runs acq_tune_poll() once per buffer set on the codes
+// tools/acq_model.py wrote to the file given as the argument: every set is
+// the model's set for the window PARAM_ACQPS holds at that moment.
+// params_write() is a stub whose value takes effect before the next set,
+// as params_commit() does in the main loop. The step curve is printed, and
+//
+//     - the sweep must end ACQ_TUNE_TUNED, starting at
+//       adc_max_acqps() and shortening by window / ACQ_TUNE_STEP_DIV
+//     - each channel must pass every step down to its minAcqps[] and fail
+//       the next one (or stop at the PARAM_ACQPS minimum)
+//     - the chosen window is the largest minimum, is written to
+//       PARAM_ACQPS and the sample period and rate follow from it
+//     - the mean code of each channel at the chosen window, taken from the
+//       model directly, is within ACQ_TUNE_ERR_Q4 of the reference window
+//
+// A second run adds one count to every code once the sweep reaches
+// ACQ_TUNE_CHECK; it must end ACQ_TUNE_UNSTABLE with PARAM_ACQPS back at
+// its value before the run.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include "f28x_project.h"
+#include "acq_tune.h"
+#include "adc_timing.h"
+#include "params.h"
+#include "flash_log.h"
+
+//
+// Defines
+//
+#define TEST_ACQPS_MIN          9U
+#define TEST_ACQPS_MAX          511U
+#define TEST_PRESCALE           6
+#define TEST_SAMPLES            1024U
+#define TEST_MAX_SETS           1000U
+
+#define CHECK(cond, ...)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if(!(cond))                                                         \
+        {                                                                   \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);                     \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+            test_failures++;                                                \
+        }                                                                   \
+    } while(0)
+
+//
+// Globals
+//
+const ParamDef param_defs[PARAM_COUNT] =
+{
+    [PARAM_SAMPLE_PERIOD] = { PARAM_T_U16, 0U, 300L, 65534L, 625L },
+    [PARAM_ACQPS] = { PARAM_T_U16, 0U, TEST_ACQPS_MIN, TEST_ACQPS_MAX, 9L },
+    [PARAM_ADC_PRESCALE] = { PARAM_T_U16, 0U, 2L, 15L, 6L },
+};
+int32_t param_value[PARAM_COUNT];
+
+static int32_t test_written = -1;           // params_write(), not committed
+static uint16_t test_failures;
+static uint16_t test_period;
+static uint16_t test_codes[TEST_ACQPS_MAX - TEST_ACQPS_MIN + 1U]
+                          [NUM_CHANNELS][TEST_SAMPLES];
+static uint16_t test_words[NUM_CHANNELS][SAMPLE_STORE_WORDS(TEST_SAMPLES)];
+static SampleStore test_store[NUM_CHANNELS];
+
+//
+// Function Prototypes
+//
+static void test_load(const char *path);
+static uint16_t test_run(uint16_t bumpAtCheck);
+static void test_curve(void);
+static int32_t test_mean_q4(uint16_t acqps, uint16_t ch);
+
+//
+// flog_time_ms - Stub for stats_poll(), which the test does not call
+//
+uint32_t flog_time_ms(void)
+{
+    return 0;
+}
+
+//
+// params_write - Stub: the value is applied between two buffer sets
+//
+uint16_t params_write(uint16_t id, int32_t value)
+{
+    if(PARAM_ACQPS == id)
+    {
+        test_written = value;
+    }
+
+    return 0;
+}
+
+//
+// main
+//
+int main(int argc, char **argv)
+{
+    uint16_t sets, ch, start;
+    int32_t err;
+
+    if(argc < 2)
+    {
+        printf("usage: test_acq_tune CODES (tools/acq_model.py)\n");
+        return 2;
+    }
+    test_load(argv[1]);
+
+    sets = test_run(0);
+    test_curve();
+    CHECK(ACQ_TUNE_TUNED == acq_tune.state, "state %u", acq_tune.state);
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        err = test_mean_q4(acq_tune.chosen, ch) -
+              test_mean_q4(acq_tune.refAcqps, ch);
+        printf("channel %u: min ACQPS %3u, model error at the chosen window "
+               "%ld/16 counts\n", ch, acq_tune.minAcqps[ch], (long)err);
+        CHECK(labs(err) <= ACQ_TUNE_ERR_Q4,
+              "channel %u: %ld/16 counts off at ACQPS %u", ch, (long)err,
+              acq_tune.chosen);
+    }
+    printf("period %u: chosen ACQPS %u, min sample period %u (%lu Hz), "
+           "%u buffer sets\n", test_period, acq_tune.chosen,
+           acq_tune.minPeriodTicks, (unsigned long)acq_tune.maxRateHz, sets);
+
+    //
+    // The input moves during the final check
+    //
+    start = (uint16_t)param_value[PARAM_ACQPS];
+    test_run(1U);
+    printf("input moved: state %u, PARAM_ACQPS %ld\n", acq_tune.state,
+           (long)param_value[PARAM_ACQPS]);
+    CHECK(ACQ_TUNE_UNSTABLE == acq_tune.state, "moved input: state %u",
+          acq_tune.state);
+    CHECK(param_value[PARAM_ACQPS] == start, "moved input: ACQPS %ld, not %u",
+          (long)param_value[PARAM_ACQPS], start);
+
+    printf("test_acq_tune: %s\n", test_failures ? "FAILED" : "passed");
+
+    return test_failures ? 1 : 0;
+}
+
+//
+// test_load - Read the acq_model.py output
+//
+static void test_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    unsigned period, samples, channels, lo, hi, acqps, code, ch, i;
+
+    if((NULL == f) ||
+       (5 != fscanf(f, "period %u samples %u channels %u acqps %u %u",
+                    &period, &samples, &channels, &lo, &hi)) ||
+       (TEST_SAMPLES != samples) || (NUM_CHANNELS != channels) ||
+       (TEST_ACQPS_MIN != lo) || (TEST_ACQPS_MAX != hi))
+    {
+        printf("%s: not an acq_model.py output for this test\n", path);
+        exit(2);
+    }
+    test_period = (uint16_t)period;
+
+    while(1 == fscanf(f, "%u", &acqps))
+    {
+        if((acqps < lo) || (acqps > hi))
+        {
+            printf("%s: ACQPS %u out of range\n", path, acqps);
+            exit(2);
+        }
+        for(ch = 0; ch < channels; ch++)
+        {
+            for(i = 0; i < samples; i++)
+            {
+                if(1 != fscanf(f, "%u", &code))
+                {
+                    printf("%s: short buffer set at ACQPS %u\n", path, acqps);
+                    exit(2);
+                }
+                test_codes[acqps - lo][ch][i] = (uint16_t)code;
+            }
+        }
+    }
+    fclose(f);
+}
+
+//
+// test_run - One sweep from ACQ_TUNE_IDLE; returns the buffer sets used
+//
+static uint16_t test_run(uint16_t bumpAtCheck)
+{
+    const SampleStore *const stores[NUM_CHANNELS] =
+        { &test_store[0], &test_store[1], &test_store[2] };
+    uint16_t sets, ch, i, acqps, bump;
+
+    memset(&acq_tune, 0, sizeof(acq_tune));
+    param_value[PARAM_SAMPLE_PERIOD] = test_period;
+    param_value[PARAM_ADC_PRESCALE] = TEST_PRESCALE;
+    if(!bumpAtCheck)
+    {
+        param_value[PARAM_ACQPS] = param_defs[PARAM_ACQPS].def;
+    }
+
+    for(sets = 0; (acq_tune.state < ACQ_TUNE_TUNED) && (sets < TEST_MAX_SETS);
+        sets++)
+    {
+        acqps = (uint16_t)param_value[PARAM_ACQPS];
+        bump = (bumpAtCheck && (ACQ_TUNE_CHECK == acq_tune.state)) ? 1U : 0U;
+        for(ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            sample_store_init(&test_store[ch], test_words[ch], TEST_SAMPLES);
+            for(i = 0; i < TEST_SAMPLES; i++)
+            {
+                sample_store_append(&test_store[ch],
+                    test_codes[acqps - TEST_ACQPS_MIN][ch][i] + bump);
+            }
+        }
+
+        acq_tune_poll(stores);
+
+        if(test_written >= 0)
+        {
+            param_value[PARAM_ACQPS] = test_written;
+            test_written = -1;
+        }
+    }
+
+    return sets;
+}
+
+//
+// test_curve - Print the step curve and check it step by step
+//
+static void test_curve(void)
+{
+    const AcqTuneStep *step;
+    uint16_t s, ch, expect, chosen = 0;
+    uint16_t prescale = TEST_PRESCALE;
+    uint16_t passed;
+
+    printf("ACQPS   error/16 and noise/16 counts per channel\n");
+    for(s = 0; s < acq_tune.steps; s++)
+    {
+        step = &acq_tune.curve[s];
+        printf("%5u ", step->acqps);
+        for(ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            printf("  %5d %4u", step->errQ4[ch], step->noiseQ4[ch]);
+        }
+        printf("\n");
+    }
+
+    CHECK(acq_tune.refAcqps == adc_max_acqps(test_period + 1U, prescale),
+          "reference ACQPS %u", acq_tune.refAcqps);
+    CHECK((acq_tune.steps >= 3U) &&
+          (acq_tune.curve[0].acqps == acq_tune.refAcqps) &&
+          (acq_tune.curve[acq_tune.steps - 1U].acqps == acq_tune.refAcqps),
+          "curve of %u steps does not start and end at the reference",
+          acq_tune.steps);
+
+    //
+    // Sweep steps: curve[1 .. steps - 2]
+    //
+    for(s = 1; (s + 1U) < acq_tune.steps; s++)
+    {
+        step = &acq_tune.curve[s];
+        expect = acq_tune.curve[s - 1U].acqps -
+                 ((acq_tune.curve[s - 1U].acqps / ACQ_TUNE_STEP_DIV) ?
+                  (acq_tune.curve[s - 1U].acqps / ACQ_TUNE_STEP_DIV) : 1U);
+        if(expect < TEST_ACQPS_MIN)
+        {
+            expect = TEST_ACQPS_MIN;
+        }
+        CHECK(step->acqps == expect, "step %u at ACQPS %u, expected %u", s,
+              step->acqps, expect);
+
+        for(ch = 0; ch < NUM_CHANNELS; ch++)
+        {
+            passed = (abs(step->errQ4[ch]) <= ACQ_TUNE_ERR_Q4) &&
+                     (step->noiseQ4[ch] <= acq_tune.refNoiseQ4[ch] +
+                                           ACQ_TUNE_NOISE_Q4);
+            if(step->acqps >= acq_tune.minAcqps[ch])
+            {
+                CHECK(passed, "channel %u fails at ACQPS %u, above its "
+                      "minimum %u", ch, step->acqps, acq_tune.minAcqps[ch]);
+            }
+            else if(acq_tune.curve[s - 1U].acqps == acq_tune.minAcqps[ch])
+            {
+                CHECK(!passed, "channel %u passes at ACQPS %u, below its "
+                      "minimum %u", ch, step->acqps, acq_tune.minAcqps[ch]);
+            }
+        }
+    }
+
+    for(ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+        if(acq_tune.minAcqps[ch] > chosen)
+        {
+            chosen = acq_tune.minAcqps[ch];
+        }
+        CHECK((acq_tune.minAcqps[ch] == TEST_ACQPS_MIN) ||
+              (acq_tune.curve[acq_tune.steps - 2U].acqps <
+               acq_tune.minAcqps[ch]),
+              "channel %u: sweep ended before its first failure", ch);
+    }
+    CHECK(acq_tune.chosen == chosen, "chosen %u, largest minimum %u",
+          acq_tune.chosen, chosen);
+    CHECK(param_value[PARAM_ACQPS] == acq_tune.chosen, "PARAM_ACQPS %ld",
+          (long)param_value[PARAM_ACQPS]);
+    CHECK(acq_tune.minPeriodTicks == adc_min_period(acq_tune.chosen, prescale),
+          "min period %u", acq_tune.minPeriodTicks);
+    CHECK(acq_tune.minPeriodTicks <= test_period, "min period %u above %u",
+          acq_tune.minPeriodTicks, test_period);
+    CHECK(acq_tune.maxRateHz ==
+          ACQ_TBCLK_HZ / ((uint32_t)acq_tune.minPeriodTicks + 1UL),
+          "rate %lu Hz", (unsigned long)acq_tune.maxRateHz);
+}
+
+//
+// test_mean_q4 - Mean code of one channel of the model at a window, Q4
+//
+static int32_t test_mean_q4(uint16_t acqps, uint16_t ch)
+{
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for(i = 0; i < TEST_SAMPLES; i++)
+    {
+        sum += test_codes[acqps - TEST_ACQPS_MIN][ch][i];
+    }
+
+    return (int32_t)((sum * 16UL + TEST_SAMPLES / 2U) / TEST_SAMPLES);
+}
+
+//
+// End of File
+//
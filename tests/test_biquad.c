@@ -0,0 +1,183 @@
+//#############################################################################
+//
+// FILE: test_biquad.c
+//
+// TITLE: Host test of the biquad banks against the bq_design.py model
+//
+// DESCRIPTION:
+// Builds biquad.c and bq_coefs.c on the portable (non-__TMS320C28XX__)
+// path and runs bq_bench(): the block and the per-sample path of every
+// table must reproduce the checksum bq_design.py computed with its model
+// (bq_benchMismatch == 0). Then every bank filters a longer stimulus
+// through bq_sample_*() and, in blocks of uneven length, through
+// bq_block_*(); the outputs must be identical, so the state carried
+// between blocks is right. That the committed bq_coefs.c/.h are what
+// bq_design.py writes today is checked by the check_bq_coefs target of
+// the Makefile.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include <stdio.h>
+#include "f28x_project.h"
+#include "biquad.h"
+#include "bq_coefs.h"
+#include "bench.h"
+
+//
+// Defines
+//
+#define BQ_TEST_SAMPLES         1000U
+
+#define CHECK(cond, ...)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if(!(cond))                                                         \
+        {                                                                   \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);                     \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+            test_failures++;                                                \
+        }                                                                   \
+    } while(0)
+
+//
+// Globals
+//
+volatile HostCpuTimerRegs CpuTimer2Regs;
+uint16_t bench_overhead;
+
+static uint16_t test_failures;
+static uint32_t test_seed = 7U;
+static int32_t test_in[BQ_TEST_SAMPLES];
+static int16_t test_q15[2][BQ_TEST_SAMPLES];
+static int32_t test_q31[2][BQ_TEST_SAMPLES];
+static BqQ15State test_state15[BQ_MAX_SECTIONS];
+static BqQ31State test_state31[BQ_MAX_SECTIONS];
+
+//
+// Function Prototypes
+//
+static int32_t test_adc(void);
+static void test_paths(uint16_t b);
+
+//
+// main
+//
+int main(void)
+{
+    uint16_t b, i;
+
+    bq_bench();
+
+    for(b = 0; b < BQ_NUM_BANKS; b++)
+    {
+        printf("bank %u: %s, %u section(s), checksum %08lx, host model "
+               "%08lx\n", b, bq_banks[b].q31 ? "q31" : "q15",
+               bq_banks[b].sections, (unsigned long)bq_benchStat[b].checksum,
+               (unsigned long)bq_banks[b].check);
+        CHECK(bq_benchStat[b].match, "bank %u differs from the host model",
+              b);
+    }
+    CHECK(0U == bq_benchMismatch, "bq_benchMismatch = %u", bq_benchMismatch);
+
+    //
+    // Full-scale noise with a few steps to the rails
+    //
+    for(i = 0; i < BQ_TEST_SAMPLES; i++)
+    {
+        test_in[i] = ((i % 200U) < 20U) ? ((i & 1U) ? 2047L : -2048L) :
+                                          test_adc();
+    }
+    for(b = 0; b < BQ_NUM_BANKS; b++)
+    {
+        test_paths(b);
+    }
+
+    printf("test_biquad: %s\n", test_failures ? "FAILED" : "passed");
+
+    return test_failures ? 1 : 0;
+}
+
+//
+// test_adc - ADC counts from mid-scale, -2048..2047
+//
+static int32_t test_adc(void)
+{
+    test_seed = test_seed * 1103515245UL + 12345UL;
+
+    return (int32_t)((test_seed >> 16) & 0x0FFFU) - 2048L;
+}
+
+//
+// test_paths - One bank through bq_sample_*() and through bq_block_*() in
+// blocks of 1, 2, .. samples
+//
+static void test_paths(uint16_t b)
+{
+    const BqBankDesc *desc = &bq_banks[b];
+    BqQ15Bank bank15;
+    BqQ31Bank bank31;
+    uint16_t i, n, differ = 0;
+
+    for(i = 0; i < BQ_TEST_SAMPLES; i++)
+    {
+        test_q15[1][i] = (int16_t)(test_in[i] * (1L << BQ_Q15_IN_SHIFT));
+        test_q31[1][i] = test_in[i] * (1L << BQ_Q31_IN_SHIFT);
+    }
+
+    if(desc->q31)
+    {
+        bq_init_q31(&bank31, (const BqQ31Coef *)desc->coef, test_state31,
+                    desc->sections);
+        for(i = 0; i < BQ_TEST_SAMPLES; i++)
+        {
+            test_q31[0][i] = bq_sample_q31(&bank31, test_q31[1][i]);
+        }
+        bq_reset_q31(&bank31);
+        for(i = 0, n = 1U; i < BQ_TEST_SAMPLES; i += n, n++)
+        {
+            if(n > BQ_TEST_SAMPLES - i)
+            {
+                n = BQ_TEST_SAMPLES - i;
+            }
+            bq_block_q31(&bank31, &test_q31[1][i], n);
+        }
+        for(i = 0; i < BQ_TEST_SAMPLES; i++)
+        {
+            differ += (test_q31[0][i] != test_q31[1][i]);
+        }
+    }
+    else
+    {
+        bq_init_q15(&bank15, (const BqQ15Coef *)desc->coef, test_state15,
+                    desc->sections);
+        for(i = 0; i < BQ_TEST_SAMPLES; i++)
+        {
+            test_q15[0][i] = bq_sample_q15(&bank15, test_q15[1][i]);
+        }
+        bq_reset_q15(&bank15);
+        for(i = 0, n = 1U; i < BQ_TEST_SAMPLES; i += n, n++)
+        {
+            if(n > BQ_TEST_SAMPLES - i)
+            {
+                n = BQ_TEST_SAMPLES - i;
+            }
+            bq_block_q15(&bank15, &test_q15[1][i], n);
+        }
+        for(i = 0; i < BQ_TEST_SAMPLES; i++)
+        {
+            differ += (test_q15[0][i] != test_q15[1][i]);
+        }
+    }
+
+    printf("bank %u: per-sample and block paths differ in %u of %u "
+           "samples\n", b, differ, BQ_TEST_SAMPLES);
+    CHECK(0U == differ, "bank %u: block path differs", b);
+}
+
+//
+// End of File
+//
@@ -0,0 +1,252 @@
+//#############################################################################
+//
+// FILE: test_cp_hist.c
+//
+// TITLE: Host test of the CP plateau histogram
+//
+// DESCRIPTION:
+// Feeds cp_hist_push()/cp_hist_period() with synthetic IN_CP_ADC traces
+// of the CP PWM: a 12, 9, 6 or 3 V plateau against -12 V, several duties
+// and uniform noise from none to +-3 bins, 96 samples per period (1 kHz
+// at 10.4 us). After every period cp_hist_poll() must find two plateaus,
+// report each level within half a bin of the mean of the samples
+// generated for it (and within CP_TEST_LEVEL_TOL_MV of the nominal
+// voltage), put the Otsu split between the highest low and the lowest
+// high sample and give the duty of the generated samples exactly. A DC
+// level must come out as one plateau.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include "f28x_project.h"
+#include "cp_hist.h"
+#include "adc_cal.h"
+
+//
+// Defines
+//
+#define CP_TEST_SAMPLES         96U         // Per CP period
+#define CP_TEST_PERIODS         4U
+#define CP_TEST_LOW_MV          (-12000L)
+#define CP_TEST_HALF_BIN        33L         // Bin centre, and rounding
+#define CP_TEST_LEVEL_TOL_MV    600L        // One bin, and the bias of a
+                                            // noisy plateau clipped at the
+                                            // rail
+
+#define CHECK(cond, ...)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if(!(cond))                                                         \
+        {                                                                   \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);                     \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+            test_failures++;                                                \
+        }                                                                   \
+    } while(0)
+
+//
+// Globals
+//
+AdcCal adc_cal[NUM_CHANNELS];
+
+static uint32_t test_seed = 1U;
+static uint16_t test_failures;
+
+//
+// Samples generated for each plateau in the current period
+//
+static uint32_t test_sum[2];
+static uint16_t test_n[2];
+static uint16_t test_min[2];
+static uint16_t test_max[2];
+
+//
+// Function Prototypes
+//
+static uint16_t test_counts(int32_t mv, int16_t noise);
+static void test_class(uint16_t x, uint16_t high);
+static void test_trace(int32_t highMv, uint16_t dutyPct, int16_t noise);
+static void test_dc(int32_t mv, int16_t noise);
+
+//
+// main
+//
+int main(void)
+{
+    static const int32_t highMv[] = { 12000L, 9000L, 6000L, 3000L };
+    static const uint16_t dutyPct[] = { 10U, 25U, 50U, 75U, 96U };
+    static const int16_t noise[] = { 0, 32, 96, 192 };   // 0 .. 3 bins
+    uint16_t h, d, n;
+
+    //
+    // Nominal CP front end, as adc_cal_init() seeds it
+    //
+    adc_cal[CH_IN_CP_ADC].gain = ADC_CAL_CP_SPAN_MV <<
+                                 (ADC_CAL_SHIFT_CP - ADC_CAL_RESOLUTION_BITS);
+    adc_cal[CH_IN_CP_ADC].offset = (int32_t)ADC_CAL_Q4(ADC_CAL_NOMINAL_OFFSET);
+    adc_cal[CH_IN_CP_ADC].shift = ADC_CAL_SHIFT_CP;
+
+    for(h = 0; h < sizeof(highMv) / sizeof(highMv[0]); h++)
+    {
+        for(d = 0; d < sizeof(dutyPct) / sizeof(dutyPct[0]); d++)
+        {
+            for(n = 0; n < sizeof(noise) / sizeof(noise[0]); n++)
+            {
+                test_trace(highMv[h], dutyPct[d], noise[n]);
+            }
+        }
+    }
+
+    test_dc(6000L, 96);
+    test_dc(CP_TEST_LOW_MV, 32);
+
+    printf("test_cp_hist: %s\n", test_failures ? "FAILED" : "passed");
+
+    return test_failures ? 1 : 0;
+}
+
+//
+// test_counts - ADC code of a CP voltage with uniform noise of +-noise
+// counts, clipped to the converter range
+//
+static uint16_t test_counts(int32_t mv, int16_t noise)
+{
+    int32_t c = ADC_CAL_NOMINAL_OFFSET +
+                (mv * (1L << ADC_CAL_RESOLUTION_BITS)) / ADC_CAL_CP_SPAN_MV;
+
+    if(noise > 0)
+    {
+        test_seed = test_seed * 1103515245UL + 12345UL;
+        c += (int32_t)((test_seed >> 16) % (2U * (uint32_t)noise + 1U)) -
+             noise;
+    }
+    if(c < 0)
+    {
+        c = 0;
+    }
+    if(c > 4095)
+    {
+        c = 4095;
+    }
+
+    return (uint16_t)c;
+}
+
+//
+// test_class - Account a generated sample to its plateau
+//
+static void test_class(uint16_t x, uint16_t high)
+{
+    test_sum[high] += x;
+    test_n[high]++;
+    if(x < test_min[high])
+    {
+        test_min[high] = x;
+    }
+    if(x > test_max[high])
+    {
+        test_max[high] = x;
+    }
+}
+
+//
+// test_trace - CP_TEST_PERIODS periods of the PWM, checked one by one
+//
+static void test_trace(int32_t highMv, uint16_t dutyPct, int16_t noise)
+{
+    uint16_t highSamples = (uint16_t)((CP_TEST_SAMPLES * dutyPct + 50U) / 100U);
+    int32_t meanLow, meanHigh;
+    uint16_t p, i, x, k;
+
+    cp_hist_init();
+
+    for(p = 0; p < CP_TEST_PERIODS; p++)
+    {
+        for(k = 0; k < 2U; k++)
+        {
+            test_sum[k] = 0;
+            test_n[k] = 0;
+            test_min[k] = 0xFFFFU;
+            test_max[k] = 0;
+        }
+        for(i = 0; i < CP_TEST_SAMPLES; i++)
+        {
+            x = test_counts((i < highSamples) ? highMv : CP_TEST_LOW_MV,
+                            noise);
+            test_class(x, i < highSamples);
+            cp_hist_push(x);
+        }
+        cp_hist_period();
+        meanLow = (int32_t)((test_sum[0] + test_n[0] / 2U) / test_n[0]);
+        meanHigh = (int32_t)((test_sum[1] + test_n[1] / 2U) / test_n[1]);
+
+        CHECK(1U == cp_hist_poll(), "%ld mV %u %% +-%d: no update",
+              (long)highMv, dutyPct, noise);
+        CHECK(cp_hist.bimodal, "%ld mV %u %% +-%d: one plateau",
+              (long)highMv, dutyPct, noise);
+        CHECK(labs((int32_t)cp_hist.highCounts - meanHigh) <= CP_TEST_HALF_BIN,
+              "%ld mV %u %% +-%d: high plateau %u counts, samples %ld",
+              (long)highMv, dutyPct, noise, cp_hist.highCounts,
+              (long)meanHigh);
+        CHECK(labs((int32_t)cp_hist.lowCounts - meanLow) <= CP_TEST_HALF_BIN,
+              "%ld mV %u %% +-%d: low plateau %u counts, samples %ld",
+              (long)highMv, dutyPct, noise, cp_hist.lowCounts,
+              (long)meanLow);
+        CHECK(labs(cp_hist.highMv - highMv) <= CP_TEST_LEVEL_TOL_MV,
+              "%ld mV %u %% +-%d: high plateau %ld mV",
+              (long)highMv, dutyPct, noise, (long)cp_hist.highMv);
+        CHECK(labs(cp_hist.lowMv - CP_TEST_LOW_MV) <= CP_TEST_LEVEL_TOL_MV,
+              "%ld mV %u %% +-%d: low plateau %ld mV",
+              (long)highMv, dutyPct, noise, (long)cp_hist.lowMv);
+        CHECK((cp_hist.splitCounts > test_max[0]) &&
+              (cp_hist.splitCounts <= test_min[1]),
+              "%ld mV %u %% +-%d: split %u outside %u..%u",
+              (long)highMv, dutyPct, noise, cp_hist.splitCounts,
+              test_max[0], test_min[1]);
+        CHECK(cp_hist.dutyPm == (highSamples * 1000U) / CP_TEST_SAMPLES,
+              "%ld mV %u %% +-%d: duty %u pm, expected %u",
+              (long)highMv, dutyPct, noise, cp_hist.dutyPm,
+              (highSamples * 1000U) / CP_TEST_SAMPLES);
+        CHECK(1U == cp_hist.periods, "%ld mV %u %% +-%d: %u periods",
+              (long)highMv, dutyPct, noise, cp_hist.periods);
+    }
+
+    printf("%6ld mV %3u %% +-%3d: high %6ld mV low %6ld mV split %4u "
+           "duty %4u pm\n", (long)highMv, dutyPct, noise,
+           (long)cp_hist.highMv, (long)cp_hist.lowMv, cp_hist.splitCounts,
+           cp_hist.dutyPm);
+}
+
+//
+// test_dc - A CP at a DC level is one plateau and keeps no split
+//
+static void test_dc(int32_t mv, int16_t noise)
+{
+    uint16_t i;
+
+    cp_hist_init();
+    for(i = 0; i < CP_TEST_SAMPLES * 10U; i++)
+    {
+        cp_hist_push(test_counts(mv, noise));
+    }
+    cp_hist_period();
+
+    CHECK(1U == cp_hist_poll(), "DC %ld mV: no update", (long)mv);
+    CHECK(!cp_hist.bimodal, "DC %ld mV: two plateaus", (long)mv);
+    CHECK(0U == cp_hist.dutyPm, "DC %ld mV: duty %u", (long)mv,
+          cp_hist.dutyPm);
+    CHECK(labs(cp_hist.lowMv - mv) <= CP_TEST_LEVEL_TOL_MV,
+          "DC %ld mV: level %ld mV", (long)mv, (long)cp_hist.lowMv);
+
+    printf("DC %6ld mV +-%3d: level %6ld mV\n", (long)mv, noise,
+           (long)cp_hist.lowMv);
+}
+
+//
+// End of File
+//
@@ -0,0 +1,92 @@
+//#############################################################################
+//
+// FILE: timebase.c
+//
+// TITLE: 64-bit monotonic time base on CPU Timer 1
+//
+// DESCRIPTION:
+// Timer set-up, the wrap interrupt and the conversions to microseconds and
+// milliseconds.
+//
+//#############################################################################
+
+//
+// Included Files
+//
+#include "f28x_project.h"
+#include "timebase.h"
+
+//
+// Defines
+//
+#define TB_CYCLES_PER_MS        SYSCLK_CYCLES_PER_MS
+
+//
+// Globals
+//
+volatile uint32_t tb_high;
+
+#pragma CODE_SECTION(tb_isr, "HotIsr");
+
+//
+// tb_init - Start CPU Timer 1 from 0. Call early in main(), before any
+// stamp is taken; the interrupt is enabled by tb_start() within 35 s.
+//
+void tb_init(void)
+{
+    tb_high = 0;
+
+    CpuTimer1Regs.TCR.bit.TSS = 1;          // Stop timer
+    CpuTimer1Regs.PRD.all = 0xFFFFFFFF;     // Full 32-bit range
+    CpuTimer1Regs.TPR.all = 0;              // Count SYSCLK
+    CpuTimer1Regs.TPRH.all = 0;
+    CpuTimer1Regs.TCR.bit.TIF = 1;          // Clear a stale wrap
+    CpuTimer1Regs.TCR.bit.TIE = 1;          // Wrap interrupt, INT13
+    CpuTimer1Regs.TCR.bit.FREE = 0;         // Stop on debugger halt
+    CpuTimer1Regs.TCR.bit.SOFT = 0;
+    CpuTimer1Regs.TCR.bit.TRB = 1;          // Reload
+    CpuTimer1Regs.TCR.bit.TSS = 0;          // Start
+}
+
+//
+// tb_start - Map and enable the wrap interrupt. Call after the PIE vector
+// table is initialized.
+//
+void tb_start(void)
+{
+    EALLOW;
+    PieVectTable.TIMER1_INT = &tb_isr;
+    EDIS;
+
+    IER |= M_INT13;
+}
+
+//
+// tb_to_us - Cycles to microseconds
+//
+uint64_t tb_to_us(uint64_t t)
+{
+    return t / TB_CYCLES_PER_US;
+}
+
+//
+// tb_to_ms - Cycles to milliseconds, wraps after 49 days
+//
+uint32_t tb_to_ms(uint64_t t)
+{
+    return (uint32_t)(t / TB_CYCLES_PER_MS);
+}
+
+//
+// tb_isr - CPU Timer 1 wrapped. Runs with interrupts masked: tb_high and
+// TIF change together for every reader.
+//
+__interrupt void tb_isr(void)
+{
+    tb_high++;
+    CpuTimer1Regs.TCR.bit.TIF = 1;
+}
+
+//
+// End of File
+//
@@ -0,0 +1,102 @@
+//#############################################################################
+//
+// FILE: timebase.h
+//
+// TITLE: 64-bit monotonic time base on CPU Timer 1
+//
+// DESCRIPTION:
+// CPU Timer 1 counts SYSCLK (8.3 ns) down from 0xFFFFFFFF; its wrap
+// interrupt (INT13, every 35.8 s) increments tb_high. tb_now() combines
+// the two into cycles since tb_init(), 64 bits, i.e. no wrap in the life
+// of the device. It is safe from the background and from any ISR:
+//
+//  - a wrap interrupt between the reads of tb_high and the counter is
+//    caught by reading tb_high again
+//  - with interrupts masked (inside an ISR) the wrap may be pending;
+//    TIF is then set and the counter has restarted, so the wrap is
+//    counted here
+//
+// tb_isr() updates tb_high and clears TIF with interrupts masked, so no
+// reader sees one without the other. tb_now32() is the low word alone,
+// for stamps compared within 35 s; tb_extend() turns such a stamp into
+// the full time. Like CPU Timer 2 (bench.h) the counter stops while the
+// debugger halts the CPU.
+//
+//#############################################################################
+
+#ifndef _timebase_h
+#define _timebase_h
+
+#include "f28x_project.h"
+#include "sysclk.h"
+
+//
+// Defines
+//
+#define TB_CYCLES_PER_US        SYSCLK_MHZ
+
+//
+// Globals
+//
+extern volatile uint32_t tb_high;           // Timer 1 wraps
+
+//
+// Function Prototypes
+//
+void tb_init(void);
+void tb_start(void);
+uint64_t tb_to_us(uint64_t t);
+uint32_t tb_to_ms(uint64_t t);
+__interrupt void tb_isr(void);
+
+//
+// tb_now32 - Low 32 bits of the time base, cycles
+//
+#pragma FUNC_ALWAYS_INLINE(tb_now32)
+static inline uint32_t tb_now32(void)
+{
+    return ~CpuTimer1Regs.TIM.all;
+}
+
+//
+// tb_now - Cycles since tb_init()
+//
+#pragma FUNC_ALWAYS_INLINE(tb_now)
+static inline uint64_t tb_now(void)
+{
+    uint32_t hi, lo;
+    uint16_t pending;
+
+    do
+    {
+        hi = tb_high;
+        lo = ~CpuTimer1Regs.TIM.all;
+        pending = CpuTimer1Regs.TCR.bit.TIF;
+    } while(hi != tb_high);
+
+    if(pending && (lo < 0x80000000UL))
+    {
+        hi++;                               // Wrap not serviced yet
+    }
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+//
+// tb_extend - Full time of a tb_now32() stamp taken less than 35 s ago
+//
+#pragma FUNC_ALWAYS_INLINE(tb_extend)
+static inline uint64_t tb_extend(uint32_t stamp)
+{
+    uint64_t now = tb_now();
+    uint32_t hi = (uint32_t)(now >> 32);
+
+    if(stamp > (uint32_t)now)
+    {
+        hi--;                               // Taken before the last wrap
+    }
+
+    return ((uint64_t)hi << 32) | stamp;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+#
+# acq_model.py - Host ADC model for the ACQ_TUNE acquisition window sweep
+#
+# Usage: acq_model.py OUT [sample period TBPRD] [seed]
+#
+# Models the sampling of SOC0..2 (channels.h) at a given ACQPS: each
+# channel is a DC source behind Rs with an external capacitor Cs at the
+# pin, sampled in turn onto the S/H capacitor Ch through the switch
+# resistance Ron. Ch starts every acquisition at the voltage of the
+# previous conversion, so a window that is too short leaves each channel
+# pulled towards the one before it, and Cs, recharging through Rs between
+# samples, carries part of that error into the next period. The settled
+# voltage is quantized to 12 bits with Gaussian noise of NOISE_LSB.
+#
+# OUT gets one buffer set of BUFFER_SAMPLES codes per channel for every
+# ACQPS from ACQPS_MIN to ACQPS_MAX, after a header line:
+#
+#     period P samples N channels C acqps MIN MAX
+#     MIN  N codes of channel 0 .. N codes of channel C-1
+#     ...
+#
+# The sweep itself is not modelled here: tests/test_acq_tune.c feeds these
+# sets to acq_tune.c, the window at a time it asks for. Edit CHANNELS to
+# the board's adapters.
+#
+
+import math
+import random
+import sys
+
+SYSCLK_HZ = 120.0e6
+TBCLK_HZ = 60000000
+VREF = 3.3
+
+RON = 860.0                     # S/H switch, ohm
+CH = 14.5e-12                   # S/H capacitor, F
+NOISE_LSB = 0.5                 # Converter noise, counts rms
+
+#
+# name, input V, Rs ohm, Cs F
+#
+CHANNELS = [
+    ("IN_ADC_500VAC", 1.20, 100.0, 2.2e-9),
+    ("IN_CP_ADC", 2.90, 1.0e3, 220.0e-12),
+    ("IN_CP_BORNE", 0.40, 1.0e3, 220.0e-12),
+]
+
+BUFFER_SAMPLES = 1024           # PARAM_BUFFER_SAMPLES
+SETTLE_PERIODS = 400            # Periods simulated before sampling
+
+#
+# params.c
+#
+ACQPS_MIN, ACQPS_MAX = 9, 511
+PERIOD_DEFAULT = 625
+
+
+class AdcModel:
+    def __init__(self, period, seed):
+        self.period_s = (period + 1) / float(TBCLK_HZ)
+        self.rng = random.Random(seed)
+
+    def _acquire(self, ch, vh, vc, t):
+        # Two-node RC network Vin -Rs- Cs -Ron- Ch for t seconds from
+        # (vc, vh); returns the new (vc, vh)
+        name, vin, rs, cs = CHANNELS[ch]
+        a11 = -(1.0 / (rs * cs) + 1.0 / (RON * cs))
+        a12 = 1.0 / (RON * cs)
+        a21 = 1.0 / (RON * CH)
+        a22 = -1.0 / (RON * CH)
+        ea, eh = vc - vin, vh - vin
+        tr, det = a11 + a22, a11 * a22 - a12 * a21
+        disc = math.sqrt(tr * tr / 4.0 - det)
+        l1, l2 = tr / 2.0 + disc, tr / 2.0 - disc
+        e1, e2 = math.exp(l1 * t), math.exp(l2 * t)
+        # expm(A t) = (e1 (A - l2 I) - e2 (A - l1 I)) / (l1 - l2)
+        k = 1.0 / (l1 - l2)
+        m11 = k * (e1 * (a11 - l2) - e2 * (a11 - l1))
+        m12 = k * (e1 - e2) * a12
+        m21 = k * (e1 - e2) * a21
+        m22 = k * (e1 * (a22 - l2) - e2 * (a22 - l1))
+        return (vin + m11 * ea + m12 * eh, vin + m21 * ea + m22 * eh)
+
+    def levels(self, acqps):
+        # Settled S/H voltage of each channel at a window, after
+        # SETTLE_PERIODS periods of the SOC0, SOC1, SOC2 sequence
+        t_acq = (acqps + 1) / SYSCLK_HZ
+        vc = [c[1] for c in CHANNELS]
+        vh = 0.0
+        held = [0.0] * len(CHANNELS)
+        for _ in range(SETTLE_PERIODS):
+            for ch, (name, vin, rs, cs) in enumerate(CHANNELS):
+                vc[ch], vh = self._acquire(ch, vh, vc[ch], t_acq)
+                held[ch] = vh
+                # Cs recharges through Rs until the next acquisition
+                gap = self.period_s - t_acq
+                vc[ch] = vin + (vc[ch] - vin) * math.exp(-gap / (rs * cs))
+        return held
+
+    def buffer_set(self, acqps):
+        out = []
+        for v in self.levels(acqps):
+            code = v / VREF * 4096.0
+            out.append([max(0, min(4095, int(round(code + self.rng.gauss(
+                0.0, NOISE_LSB))))) for _ in range(BUFFER_SAMPLES)])
+        return out
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write("usage: acq_model.py OUT [period] [seed]\n")
+        return 2
+    period = int(argv[2]) if len(argv) > 2 else PERIOD_DEFAULT
+    seed = int(argv[3]) if len(argv) > 3 else 1
+    adc = AdcModel(period, seed)
+
+    with open(argv[1], "w") as f:
+        f.write("period %d samples %d channels %d acqps %d %d\n"
+                % (period, BUFFER_SAMPLES, len(CHANNELS), ACQPS_MIN,
+                   ACQPS_MAX))
+        for acqps in range(ACQPS_MIN, ACQPS_MAX + 1):
+            f.write("%d" % acqps)
+            for codes in adc.buffer_set(acqps):
+                f.write(" " + " ".join("%d" % c for c in codes))
+            f.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
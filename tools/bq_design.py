@@ -0,0 +1,284 @@
+#!/usr/bin/env python3
+#
+# bq_design.py - Biquad coefficient design and bit-exact host model
+#
+# Usage: bq_design.py [output directory]
+#
+# Designs the filter banks listed in BANKS (Butterworth low-pass cascades
+# and notches, RBJ cookbook sections), quantizes them to the Q14 (Q15
+# banks) or Q30 (Q31 banks) coefficients of biquad.h and writes bq_coefs.h
+# and bq_coefs.c, by default into the repository root.
+#
+# For every bank the script
+#   - bounds each section's accumulator for inputs of BQ_*_IN_MAX from the
+#     l1 norm of the quantized impulse response, and refuses a table that
+#     could overflow the int32 (Q15) or int64 (Q31) accumulator
+#   - runs the integer model of biquad.c on the bq_bench() stimulus and
+#     writes the output checksum next to the table; bq_bench() on the
+#     target must reproduce it (bq_benchMismatch == 0)
+#   - prints the quantized response at a few frequencies
+#
+# The model below must stay the same arithmetic as bq_step_q15() and
+# bq_step_q31(): any change to the kernels or the stimulus has to be made
+# in both, and the tables regenerated.
+#
+
+import cmath
+import math
+import os
+import sys
+
+SAMPLE_HZ = 60.0e6 / 626.0      # ePWM TBCLK / (PARAM_SAMPLE_PERIOD + 1)
+
+#
+# name, format, sections as (type, frequency Hz, Q), description
+#
+BANKS = [
+    ("cpLowpass", "q15",
+     [("lowpass", 10000.0, q) for q in (0.5412, 1.3066)],
+     "CP anti-alias/smoothing, 4th order Butterworth 10 kHz"),
+    ("cpNotch", "q31",
+     [("notch", 50.0, 2.0)],
+     "CP mains hum notch, 50 Hz, Q 2"),
+    ("mainsLowpass", "q15",
+     [("lowpass", 2000.0, 0.7071)],
+     "500 VAC low-pass, 2nd order Butterworth 2 kHz"),
+]
+
+FORMATS = {
+    #        frac  in shift  data bits  acc bits
+    "q15": (14, 2, 16, 32),
+    "q31": (30, 18, 32, 64),
+}
+
+MAX_SECTIONS = 4                # BQ_MAX_SECTIONS
+BENCH_SAMPLES = 128             # BQ_BENCH_SAMPLES
+BENCH_SEED = 0xACE1             # BQ_BENCH_SEED
+CHECK_MUL = 33                  # BQ_CHECK_MUL
+L1_SAMPLES = 200000
+
+
+def rbj(kind, f0, q):
+    w0 = 2.0 * math.pi * f0 / SAMPLE_HZ
+    cw = math.cos(w0)
+    alpha = math.sin(w0) / (2.0 * q)
+    a0 = 1.0 + alpha
+    if kind == "lowpass":
+        b = [(1.0 - cw) / 2.0, 1.0 - cw, (1.0 - cw) / 2.0]
+    elif kind == "notch":
+        b = [1.0, -2.0 * cw, 1.0]
+    else:
+        raise ValueError("unknown section type %s" % kind)
+    a = [1.0, -2.0 * cw, 1.0 - alpha]
+    return [v / a0 for v in b], [v / a0 for v in a]
+
+
+def quantize(b, a, frac, bits):
+    lim = 1 << (bits - 1)
+    coef = [int(round(v * (1 << frac))) for v in (b[0], b[1], b[2],
+                                                   -a[1], -a[2])]
+    for v in coef:
+        if not -lim <= v < lim:
+            raise ValueError("coefficient %d does not fit %d bits" % (v, bits))
+    return coef
+
+
+def sat(v, bits):
+    hi = (1 << (bits - 1)) - 1
+    lo = -(1 << (bits - 1))
+    return hi if v > hi else lo if v < lo else v
+
+
+def step(coef, st, x, frac, bits):
+    # Same sums and rounding as bq_step_q15() / bq_step_q31()
+    b0, b1, b2, na1, na2 = coef
+    acc = b0 * x + b1 * st[0] + b2 * st[1] + na1 * st[2] + na2 * st[3]
+    y = sat((acc + (1 << (frac - 1))) >> frac, bits)
+    st[1] = st[0]
+    st[0] = x
+    st[3] = st[2]
+    st[2] = y
+    return y
+
+
+def stimulus(in_shift):
+    lfsr = BENCH_SEED
+    out = []
+    for _ in range(BENCH_SAMPLES):
+        lfsr = (lfsr >> 1) ^ (0xB400 if lfsr & 1 else 0)
+        out.append(((lfsr & 0x0FFF) - 2048) << in_shift)
+    return out
+
+
+def checksum(ys, bits):
+    c = 0
+    mask = (1 << bits) - 1
+    for y in ys:
+        c = (c * CHECK_MUL + (y & mask)) & 0xFFFFFFFF
+    return c
+
+
+def l1_norm(sections, frac):
+    # l1 norm of the quantized cascade's impulse response after each
+    # section, in floating point
+    norms = []
+    sig = [1.0] + [0.0] * (L1_SAMPLES - 1)
+    for coef in sections:
+        b0, b1, b2, na1, na2 = [c / float(1 << frac) for c in coef]
+        x1 = x2 = y1 = y2 = 0.0
+        out = []
+        for x in sig:
+            y = b0 * x + b1 * x1 + b2 * x2 + na1 * y1 + na2 * y2
+            x2, x1, y2, y1 = x1, x, y1, y
+            out.append(y)
+        sig = out
+        norms.append(sum(abs(v) for v in sig))
+    return norms
+
+
+def check_headroom(name, sections, fmt):
+    frac, in_shift, bits, acc_bits = FORMATS[fmt]
+    in_max = 2048 << in_shift
+    sat_max = 1 << (bits - 1)
+    norms = l1_norm(sections, frac)
+    x_max = in_max
+    for k, coef in enumerate(sections):
+        y_max = min(sat_max, in_max * norms[k])
+        bound = (sum(abs(c) for c in coef[:3]) * x_max +
+                 sum(abs(c) for c in coef[3:]) * y_max + (1 << frac))
+        if bound >= (1 << (acc_bits - 1)):
+            raise ValueError("%s section %d: accumulator bound %.3g "
+                             "overflows int%d" % (name, k, bound, acc_bits))
+        x_max = y_max
+
+
+def response(sections, frac, f):
+    z = cmath.exp(-2j * math.pi * f / SAMPLE_HZ)
+    h = 1.0
+    for b0, b1, b2, na1, na2 in sections:
+        s = float(1 << frac)
+        h *= ((b0 + b1 * z + b2 * z * z) / s) / \
+             (1.0 - (na1 * z + na2 * z * z) / s)
+    return 20.0 * math.log10(max(abs(h), 1e-12))
+
+
+def design(bank):
+    name, fmt, spec, _ = bank
+    frac, in_shift, bits, _ = FORMATS[fmt]
+    coef_bits = 16 if fmt == "q15" else 32
+    if len(spec) > MAX_SECTIONS:
+        raise ValueError("%s: more than %d sections" % (name, MAX_SECTIONS))
+    sections = [quantize(*rbj(kind, f0, q), frac=frac, bits=coef_bits)
+                for kind, f0, q in spec]
+    check_headroom(name, sections, fmt)
+
+    states = [[0, 0, 0, 0] for _ in sections]
+    ys = []
+    for x in stimulus(in_shift):
+        for coef, st in zip(sections, states):
+            x = step(coef, st, x, frac, bits)
+        ys.append(x)
+    return sections, checksum(ys, bits)
+
+
+def c_name(name):
+    out = ""
+    for ch in name:
+        out += ("_" + ch) if ch.isupper() else ch.upper()
+    return "BQ_" + out
+
+
+BANNER = """//#############################################################################
+//
+// FILE: %s
+//
+// TITLE: Biquad coefficient tables
+//
+// DESCRIPTION:
+// Generated by tools/bq_design.py for a sample rate of %.1f Hz - do not
+// edit, change the script and run it again. Each table has its section
+// count and the output checksum of the host model on the bq_bench()
+// stimulus (see biquad.h).
+//
+//#############################################################################
+"""
+
+
+def emit(out_dir, results):
+    h = [BANNER % ("bq_coefs.h", SAMPLE_HZ),
+         "#ifndef _bq_coefs_h", "#define _bq_coefs_h", "",
+         '#include "biquad.h"', "", "//", "// Defines", "//"]
+    for (name, fmt, spec, desc), (sections, check) in results:
+        h.append("#define %-31s %dU" % (c_name(name) + "_SECTIONS",
+                                        len(sections)))
+        h.append("#define %-31s 0x%08XUL" % (c_name(name) + "_CHECK", check))
+    h.append("#define %-31s %dU" % ("BQ_NUM_BANKS", len(results)))
+    h += ["", "//", "// Globals", "//"]
+    for (name, fmt, spec, desc), (sections, check) in results:
+        typ = "BqQ15Coef" if fmt == "q15" else "BqQ31Coef"
+        h.append("extern const %s bq_%s[%s];" % (typ, name,
+                                                 c_name(name) + "_SECTIONS"))
+    h.append("extern const BqBankDesc bq_banks[BQ_NUM_BANKS];")
+    h += ["", "#endif", ""]
+
+    c = [BANNER % ("bq_coefs.c", SAMPLE_HZ), "//", "// Included Files", "//",
+         '#include "bq_coefs.h"', "", "//", "// Globals", "//"]
+    for (name, fmt, spec, desc), (sections, check) in results:
+        typ = "BqQ15Coef" if fmt == "q15" else "BqQ31Coef"
+        c.append("")
+        c.append("//")
+        c.append("// %s" % desc)
+        c.append("//")
+        c.append("const %s bq_%s[%s] =" % (typ, name,
+                                           c_name(name) + "_SECTIONS"))
+        c.append("{")
+        rows = []
+        for b0, b1, b2, na1, na2 in sections:
+            if fmt == "q15":
+                rows.append("    { BQ_PAIR(%d, %d), BQ_PAIR(%d, %d), %d, 0 }"
+                            % (b1, b2, na1, na2, b0))
+            else:
+                rows.append("    { %dL, %dL, %dL, %dL, %dL, 0L }"
+                            % (b0, b1, b2, na1, na2))
+        c.append(",\n".join(rows))
+        c.append("};")
+    c += ["", "const BqBankDesc bq_banks[BQ_NUM_BANKS] =", "{"]
+    rows = []
+    for (name, fmt, spec, desc), (sections, check) in results:
+        rows.append("    { bq_%s, %s, %dU, %s }"
+                    % (name, c_name(name) + "_SECTIONS",
+                       1 if fmt == "q31" else 0, c_name(name) + "_CHECK"))
+    c.append(",\n".join(rows))
+    c += ["};", "", "//", "// End of File", "//", ""]
+
+    with open(os.path.join(out_dir, "bq_coefs.h"), "w") as f:
+        f.write("\n".join(h))
+    with open(os.path.join(out_dir, "bq_coefs.c"), "w") as f:
+        f.write("\n".join(c))
+
+
+def main(argv):
+    out_dir = argv[1] if len(argv) > 1 else \
+        os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+    results = []
+    for bank in BANKS:
+        try:
+            results.append((bank, design(bank)))
+        except ValueError as err:
+            print("bq_design: %s" % err)
+            return 1
+
+    for (name, fmt, spec, desc), (sections, check) in results:
+        frac = FORMATS[fmt][0]
+        print("%-14s %s  %d section(s)  check 0x%08X" % (name, fmt,
+              len(sections), check))
+        for f in (50.0, 1000.0, 2000.0, 10000.0, 20000.0):
+            print("    %8.0f Hz %8.2f dB" % (f, response(sections, frac, f)))
+
+    emit(out_dir, results)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
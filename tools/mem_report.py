@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+#
+# mem_report.py - Per-memory and per-section headroom report
+#
+# Usage: mem_report.py <linker .map> [memory_plan.h]
+#
+# Reads the MEMORY CONFIGURATION and SECTION ALLOCATION MAP tables of a
+# C2000 linker map file and prints, for every program memory range (PAGE 0),
+# the words used and left, followed by the output sections placed in it.
+# When memory_plan.h is given, the SampleStore, TelemetryRing and NoInit
+# sections are also checked against their budgets. Ranges or budgets with
+# less than WARN_PERCENT free are flagged. Runs as the post-build step of the
+# CPU1_RAM and CPU1_FLASH configurations; it never fails the build.
+#
+
+import re
+import sys
+
+WARN_PERCENT = 5
+
+SECTION_BUDGETS = {
+    "SampleStore": "PLAN_SAMPLESTORE_WORDS",
+    "TelemetryRing": "PLAN_TELEMETRY_WORDS",
+    "NoInit": "PLAN_NOINIT_WORDS",
+}
+
+MEM_LINE = re.compile(r"^\s+(\S+)\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s+"
+                      r"([0-9a-f]{8})\s+([0-9a-f]{8})\s+\S+")
+SEC_INLINE = re.compile(r"^(\S+)\s+(\d)\s+([0-9a-f]{8})\s+([0-9a-f]{8})")
+SEC_NAME = re.compile(r"^(\S+)\s*$")
+SEC_STAR = re.compile(r"^\*\s+(\d)\s+([0-9a-f]{8})\s+([0-9a-f]{8})")
+SPLIT_SUFFIX = re.compile(r"\.\d+$")
+
+
+def parse_map(path):
+    memories = []
+    sections = []
+    mode = None
+    page = None
+    pending = None
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            if line.startswith("MEMORY CONFIGURATION"):
+                mode = "memory"
+                continue
+            if line.startswith("SECTION ALLOCATION MAP"):
+                mode = "sections"
+                continue
+            if line.startswith("SEGMENT ALLOCATION MAP") or \
+               line.startswith("GLOBAL SYMBOLS") or \
+               line.startswith("LINKER GENERATED"):
+                mode = None
+                continue
+
+            if mode == "memory":
+                if line.startswith("PAGE"):
+                    page = int(line.split()[1].rstrip(":"))
+                    continue
+                m = MEM_LINE.match(line)
+                if m and page == 0:
+                    memories.append({
+                        "name": m.group(1),
+                        "origin": int(m.group(2), 16),
+                        "length": int(m.group(3), 16),
+                        "used": int(m.group(4), 16),
+                        "unused": int(m.group(5), 16),
+                        "sections": {},
+                    })
+            elif mode == "sections":
+                m = SEC_STAR.match(line)
+                if m:
+                    if pending:
+                        sections.append((pending, int(m.group(1)),
+                                         int(m.group(2), 16),
+                                         int(m.group(3), 16)))
+                    pending = None
+                    continue
+                m = SEC_INLINE.match(line)
+                if m:
+                    sections.append((m.group(1), int(m.group(2)),
+                                     int(m.group(3), 16), int(m.group(4), 16)))
+                    pending = None
+                    continue
+                m = SEC_NAME.match(line)
+                pending = m.group(1) if m else None
+
+    for name, sec_page, origin, length in sections:
+        if sec_page != 0 or length == 0:
+            continue
+        #
+        # Split sections (">>" placement) show up as .text.1, .text.2, ...
+        #
+        name = SPLIT_SUFFIX.sub("", name)
+        for mem in memories:
+            if mem["origin"] <= origin < mem["origin"] + mem["length"]:
+                mem["sections"][name] = mem["sections"].get(name, 0) + length
+                break
+
+    return memories
+
+
+def parse_plan(path):
+    values = {}
+    define = re.compile(r"^#define\s+(PLAN_\w+)\s+(0x[0-9A-Fa-f]+|\d+)U?\b")
+    with open(path) as f:
+        for line in f:
+            m = define.match(line)
+            if m:
+                values[m.group(1)] = int(m.group(2), 0)
+    return values
+
+
+def main(argv):
+    if len(argv) < 2:
+        print("usage: mem_report.py <map file> [memory_plan.h]")
+        return 0
+
+    try:
+        memories = parse_map(argv[1])
+    except OSError as err:
+        print("mem_report: cannot read %s (%s)" % (argv[1], err))
+        return 0
+
+    plan = {}
+    if len(argv) > 2:
+        try:
+            plan = parse_plan(argv[2])
+        except OSError:
+            plan = {}
+
+    print("")
+    print("Memory headroom (16-bit words) - %s" % argv[1])
+    print("%-22s %8s %8s %8s %6s" % ("range", "length", "used", "free",
+                                     "free%"))
+
+    placed = {}
+    for mem in memories:
+        if mem["used"] == 0:
+            continue
+        pct = 100.0 * mem["unused"] / mem["length"]
+        flag = "  <-- LOW" if pct < WARN_PERCENT else ""
+        print("%-22s %8d %8d %8d %5.1f%%%s" % (mem["name"], mem["length"],
+              mem["used"], mem["unused"], pct, flag))
+        for name, size in sorted(mem["sections"].items(),
+                                 key=lambda item: -item[1]):
+            print("    %-18s %8d" % (name, size))
+            placed[name] = placed.get(name, 0) + size
+
+    if plan:
+        print("")
+        print("%-22s %8s %8s %8s %6s" % ("section budget", "budget", "used",
+                                         "free", "free%"))
+        for name, key in SECTION_BUDGETS.items():
+            budget = plan.get(key)
+            if not budget:
+                continue
+            used = placed.get(name, 0)
+            free = budget - used
+            pct = 100.0 * free / budget
+            flag = "  <-- LOW" if pct < WARN_PERCENT else ""
+            if free < 0:
+                flag = "  <-- OVER BUDGET"
+            print("%-22s %8d %8d %8d %5.1f%%%s" % (name, budget, used, free,
+                                                   pct, flag))
+    print("")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))